@@ -0,0 +1,567 @@
+/*
+Audoo-phase-meter for OBS
+Copyright (C) 2025 you214 https://github.com/you214
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along
+with this program. If not, see <https://www.gnu.org/licenses/>
+*/
+
+// 解析・描画経路のヘッドレスベンチマーク（OBS不要）
+// 合成信号を各ブロック長・ソース数で流し、capture（音声スレッド側）、analyze（解析スレッド側）、
+// paint（オフスクリーンQImageへの描画）のコストと、1フレームあたりのメモリ確保回数をJSONで出力する
+// ウォームアップ後に1回でも確保した組み合わせがあれば、段ごとの回数を標準エラーに出して1で終わる
+// 相関カーネルの各実装がスカラー実装と許容差に収まらない場合も同様に1で終わる
+// paintはこのベンチのpaintFrame（スコープ画像の合成）だけで、ウィジェットのpaintEventは含まない
+// 確保はこのプログラムのoperator newだけを数え、Qtの中（QPainterの内部データなど）の確保は見えない
+//
+// --replayでは記録したキャプチャ（.pmrec）を記録時刻どおりの解析間隔で流し、解析コストと
+// 結果のハッシュを出力する（同じファイルからは常に同じハッシュになる）
+//
+//   phase-meter-bench [--cycles N] [--quick]
+//   phase-meter-bench --replay capture.pmrec
+
+#include <QImage>
+#include <QPainter>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "alloc-tracker.h"
+#include "analysis-worker.h"
+#include "capture-replay.h"
+#include "channel-matrix.h"
+#include "correlation-kernels.h"
+#include "source-registry.h"
+
+namespace {
+
+constexpr uint32_t SAMPLE_RATE = 48000;
+constexpr int BENCH_BANDS = 5;
+constexpr size_t BENCH_HISTORY_COLUMNS = 600; // 600列 × 10ms（最も細かい段を毎サイクル読み直す）
+
+enum class Signal { Sine, PinkNoise, Inverted, Decorrelated };
+
+const char *signalName(Signal signal)
+{
+	switch (signal) {
+	case Signal::Sine:
+		return "sine";
+	case Signal::PinkNoise:
+		return "pink";
+	case Signal::Inverted:
+		return "inverted";
+	case Signal::Decorrelated:
+		return "decorrelated";
+	}
+	return "";
+}
+
+// Paul Kelletの近似フィルタによるピンクノイズ
+class PinkNoise {
+public:
+	explicit PinkNoise(uint32_t seed) : m_random(seed), m_white(-1.0f, 1.0f) {}
+
+	float next()
+	{
+		const float white = m_white(m_random);
+		m_b0 = 0.99886f * m_b0 + white * 0.0555179f;
+		m_b1 = 0.99332f * m_b1 + white * 0.0750759f;
+		m_b2 = 0.96900f * m_b2 + white * 0.1538520f;
+		m_b3 = 0.86650f * m_b3 + white * 0.3104856f;
+		m_b4 = 0.55000f * m_b4 + white * 0.5329522f;
+		m_b5 = -0.7616f * m_b5 - white * 0.0168980f;
+		const float pink = m_b0 + m_b1 + m_b2 + m_b3 + m_b4 + m_b5 + m_b6 + white * 0.5362f;
+		m_b6 = white * 0.115926f;
+		return pink * 0.11f;
+	}
+
+private:
+	std::mt19937 m_random;
+	std::uniform_real_distribution<float> m_white;
+	float m_b0 = 0, m_b1 = 0, m_b2 = 0, m_b3 = 0, m_b4 = 0, m_b5 = 0, m_b6 = 0;
+};
+
+// 1秒分のステレオ信号を作っておき、ループして使う（計測中に信号生成のコストを混ぜない）
+void generate(Signal signal, std::vector<float> &left, std::vector<float> &right)
+{
+	left.resize(SAMPLE_RATE);
+	right.resize(SAMPLE_RATE);
+	PinkNoise noiseLeft(1);
+	PinkNoise noiseRight(2);
+
+	for (uint32_t i = 0; i < SAMPLE_RATE; ++i) {
+		switch (signal) {
+		case Signal::Sine:
+			left[i] = right[i] =
+				0.5f * static_cast<float>(std::sin(2.0 * 3.14159265358979 * 1000.0 * i / SAMPLE_RATE));
+			break;
+		case Signal::PinkNoise:
+			left[i] = right[i] = noiseLeft.next();
+			break;
+		case Signal::Inverted:
+			left[i] = noiseLeft.next();
+			right[i] = -left[i];
+			break;
+		case Signal::Decorrelated:
+			left[i] = noiseLeft.next();
+			right[i] = noiseRight.next();
+			break;
+		}
+	}
+}
+
+double nowNs()
+{
+	return static_cast<double>(statNowNs());
+}
+
+struct KernelResult {
+	const char *isa;
+	double nsPerSample;
+	double maxRelError; // スカラー実装との差の最大（ΣL²+ΣR²に対する相対値）
+};
+
+// 各実装の結果がスカラー実装と許容差（correlation-kernels.hの相対1e-5）に収まること
+constexpr double KERNEL_TOLERANCE = 1e-5;
+
+// 端数の長さと、16バイト境界からずらした先頭で、スカラー実装との差の最大を求める
+double kernelError(CorrelationKernel kernel, const std::vector<float> &left, const std::vector<float> &right)
+{
+	const CorrelationKernel scalar = correlationKernelFor(KernelIsa::Scalar);
+	double maxError = 0.0;
+	for (size_t frames : {0, 1, 7, 15, 17, 33, 511, 4097}) {
+		for (size_t offset : {0, 1}) {
+			const float *l = left.data() + offset;
+			const float *r = right.data() + offset;
+			const CorrelationSums expected = scalar(l, r, frames);
+			const CorrelationSums actual = kernel(l, r, frames);
+			// ΣLRは打ち消し合って0に近づくので、どの項もエネルギーの大きさを基準にする
+			const double scale = expected.ll + expected.rr;
+			const double diffs[] = {actual.lr - expected.lr, actual.ll - expected.ll,
+						actual.rr - expected.rr};
+			for (double diff : diffs) {
+				// 長さ0ならどちらも0のはず
+				const double error = scale > 0.0 ? std::abs(diff) / scale
+								 : (diff != 0.0 ? HUGE_VAL : 0.0);
+				maxError = std::max(maxError, error);
+			}
+		}
+	}
+	return maxError;
+}
+
+std::vector<KernelResult> benchKernels(const std::vector<float> &left, const std::vector<float> &right, int repeats)
+{
+	std::vector<KernelResult> results;
+	for (KernelIsa isa : {KernelIsa::Scalar, KernelIsa::SSE2, KernelIsa::AVX2, KernelIsa::AVX512}) {
+		CorrelationKernel kernel = correlationKernelFor(isa);
+		if (!kernel) {
+			continue;
+		}
+
+		volatile double sink = 0.0;
+		const double start = nowNs();
+		for (int r = 0; r < repeats; ++r) {
+			sink = sink + kernel(left.data(), right.data(), left.size()).lr;
+		}
+		const double elapsed = nowNs() - start;
+		results.push_back({kernelIsaName(isa), elapsed / (static_cast<double>(left.size()) * repeats),
+				   kernelError(kernel, left, right)});
+	}
+	return results;
+}
+
+struct MatrixResult {
+	int channels;
+	double nsPerSample;
+	double readNsPerSample; // 各平面をカーネルで1回読むだけのコスト（メモリ帯域の目安）
+};
+
+// 多チャンネルの相関行列（全ペア）と、同じ平面を1回読むだけの場合との比較
+std::vector<MatrixResult> benchMatrix(const std::vector<float> &left, const std::vector<float> &right, int repeats)
+{
+	std::vector<MatrixResult> results;
+	for (int channels : {6, 8}) {
+		// チャンネルごとに別の平面を用意する（同じバッファを指すとキャッシュに載りっぱなしになる）
+		std::vector<std::vector<float>> planes(channels);
+		const float *pointers[ChannelMatrix::MAX_CHANNELS];
+		for (int c = 0; c < channels; ++c) {
+			planes[c] = (c & 1) ? right : left;
+			pointers[c] = planes[c].data();
+		}
+		const size_t frames = left.size();
+
+		ChannelMatrix matrix;
+		matrix.configure(channels, SAMPLE_RATE, 300.0);
+		double start = nowNs();
+		for (int r = 0; r < repeats; ++r) {
+			matrix.process(pointers, channels, frames);
+		}
+		const double matrixNs = nowNs() - start;
+
+		volatile double sink = 0.0;
+		start = nowNs();
+		for (int r = 0; r < repeats; ++r) {
+			for (int c = 0; c + 1 < channels; c += 2) {
+				sink = sink + correlationSums(pointers[c], pointers[c + 1], frames).lr;
+			}
+		}
+		const double readNs = nowNs() - start;
+
+		const double samples = static_cast<double>(frames) * channels * repeats;
+		results.push_back({channels, matrixNs / samples, readNs / samples});
+	}
+	return results;
+}
+
+constexpr int ALLOC_STAGES = static_cast<int>(AllocStage::Count);
+
+struct PipelineResult {
+	Signal signal;
+	size_t blockFrames;
+	int sources;
+	double captureNsPerSample;
+	double analyzeNsPerSample;
+	double paintNsPerFrame;
+	double framesPerSecond;
+	double allocationsPerFrame;
+	uint64_t stageAllocations[ALLOC_STAGES]; // ウォームアップ後の段ごとの合計
+};
+
+// 段ごとの確保回数の累計を読む
+void readAllocations(uint64_t (&counts)[ALLOC_STAGES])
+{
+	for (int stage = 0; stage < ALLOC_STAGES; ++stage) {
+		counts[stage] = allocTotals(static_cast<AllocStage>(stage)).count;
+	}
+}
+
+// ウィジェットと同じ描画（ゼロコピーのQImageを加算合成で重ねる）
+void paintFrame(const AnalysisFrame &frame, QImage &target)
+{
+	const AllocScope allocScope(AllocStage::Paint);
+	QPainter painter(&target);
+	painter.fillRect(target.rect(), Qt::black);
+	painter.setCompositionMode(QPainter::CompositionMode_Plus);
+	painter.setRenderHint(QPainter::SmoothPixmapTransform);
+
+	int drawn = 0;
+	for (size_t i = 0; i < frame.count && drawn < 3; ++i) {
+		const SourceFrame &source = frame.sources[i];
+		if (!source.hasAudio || source.imageSize <= 0) {
+			continue;
+		}
+		const QImage image(reinterpret_cast<const uchar *>(source.pixels.data()), source.imageSize,
+				   source.imageSize, source.imageSize * static_cast<int>(sizeof(uint32_t)),
+				   QImage::Format_ARGB32_Premultiplied);
+		painter.drawImage(target.rect(), image);
+		drawn++;
+	}
+}
+
+// 実機の既定（積分300ms・矩形窓）に帯域別相関を加えた設定
+SourceConfig benchConfig(uint32_t sampleRate)
+{
+	SourceConfig config;
+	config.analysisVersion = 1;
+	config.sampleRate = sampleRate;
+	config.integrationMs = 300.0;
+	config.bandCount = BENCH_BANDS;
+	config.scopeVersion = 1;
+	config.persistenceMs = 150.0;
+	return config;
+}
+
+PipelineResult benchPipeline(Signal signal, const std::vector<float> &left, const std::vector<float> &right,
+			     size_t blockFrames, int sourceCount, int cycles)
+{
+	SourceRegistry registry;
+	AnalysisWorker worker(registry);
+	worker.setRasterSize(ScopeRasterizer::DEFAULT_SIZE);
+	worker.setHistoryView(BENCH_HISTORY_COLUMNS, 1);
+	const SourceConfig config = benchConfig(SAMPLE_RATE);
+	worker.setConfig(config);
+
+	std::vector<AudioSource *> sources;
+	for (int i = 0; i < sourceCount; ++i) {
+		AudioSource *source = registry.add(QString("bench-%1").arg(i), QString("Source %1").arg(i),
+						   QColor::fromHsv((i * 67) % 360, 200, 255), SAMPLE_RATE / 50,
+						   [&config](AudioSource &added) { added.configure(config, nullptr); });
+		sources.push_back(source);
+	}
+
+	QImage target(ScopeRasterizer::DEFAULT_SIZE, ScopeRasterizer::DEFAULT_SIZE,
+		      QImage::Format_ARGB32_Premultiplied);
+
+	size_t position = 0;
+	uint64_t timestamp = 1000000000ULL;
+	double captureNs = 0.0;
+	double analyzeNs = 0.0;
+	double paintNs = 0.0;
+	uint64_t allocations[ALLOC_STAGES] = {};
+
+	// 最初の数サイクルはバッファの初期化（スコープ画像など）を含むので計測しない
+	const int warmup = 8;
+	for (int cycle = 0; cycle < warmup + cycles; ++cycle) {
+		const bool measured = cycle >= warmup;
+		if (position + blockFrames > left.size()) {
+			position = 0;
+		}
+
+		uint64_t allocationsBefore[ALLOC_STAGES];
+		readAllocations(allocationsBefore);
+
+		const double captureStart = nowNs();
+		{
+			const AllocScope allocScope(AllocStage::Capture); // 音声コールバックの代わり
+			for (AudioSource *source : sources) {
+				source->push(left.data() + position, right.data() + position, blockFrames,
+					     timestamp);
+			}
+		}
+		const double analyzeStart = nowNs();
+		worker.step(timestamp);
+		const double paintStart = nowNs();
+		worker.acquireFrame();
+		paintFrame(worker.frame(), target);
+		const double paintEnd = nowNs();
+
+		position += blockFrames;
+		timestamp += static_cast<uint64_t>(blockFrames) * 1000000000ULL / SAMPLE_RATE;
+
+		if (measured) {
+			captureNs += analyzeStart - captureStart;
+			analyzeNs += paintStart - analyzeStart;
+			paintNs += paintEnd - paintStart;
+			uint64_t allocationsAfter[ALLOC_STAGES];
+			readAllocations(allocationsAfter);
+			for (int stage = 0; stage < ALLOC_STAGES; ++stage) {
+				allocations[stage] += allocationsAfter[stage] - allocationsBefore[stage];
+			}
+		}
+	}
+
+	const double samples = static_cast<double>(blockFrames) * sourceCount * cycles;
+	PipelineResult result;
+	result.signal = signal;
+	result.blockFrames = blockFrames;
+	result.sources = sourceCount;
+	result.captureNsPerSample = captureNs / samples;
+	result.analyzeNsPerSample = analyzeNs / samples;
+	result.paintNsPerFrame = paintNs / cycles;
+	result.framesPerSecond = cycles * 1e9 / (captureNs + analyzeNs + paintNs);
+	uint64_t allocationTotal = 0;
+	for (int stage = 0; stage < ALLOC_STAGES; ++stage) {
+		result.stageAllocations[stage] = allocations[stage];
+		allocationTotal += allocations[stage];
+	}
+	result.allocationsPerFrame = static_cast<double>(allocationTotal) / cycles;
+	return result;
+}
+
+// 記録を待たずに流し、記録時刻で解析の周期ごとに解析する（実行速度に依存せず結果が決まる）
+int replayCapture(const char *path)
+{
+	CaptureReplay replay;
+	std::string error;
+	if (!replay.open(path, error)) {
+		std::fprintf(stderr, "%s\n", error.c_str());
+		return 1;
+	}
+
+	SourceRegistry registry;
+	AnalysisWorker worker(registry);
+	const SourceConfig config = benchConfig(replay.sampleRate());
+	worker.setConfig(config);
+	std::vector<AudioSource *> targets;
+
+	const uint64_t interval = worker.clock().period().count();
+	uint64_t nextStep = 0;
+	uint64_t blocks = 0;
+	uint64_t samples = 0;
+	uint64_t steps = 0;
+	double analyzeNs = 0.0;
+	uint64_t hash = 14695981039346656037ULL; // 公開された相関値のFNV-1a
+
+	const auto analyzeAt = [&](uint64_t streamNs) {
+		const double start = nowNs();
+		worker.step(streamNs);
+		analyzeNs += nowNs() - start;
+		steps++;
+		if (worker.acquireFrame()) {
+			const AnalysisFrame &frame = worker.frame();
+			for (size_t i = 0; i < frame.count; ++i) {
+				uint32_t bits;
+				std::memcpy(&bits, &frame.sources[i].correlation, sizeof(bits));
+				hash = (hash ^ bits) * 1099511628211ULL;
+			}
+		}
+	};
+
+	replay.play(
+		CaptureReplay::Pace::Unthrottled,
+		[&](const ReplaySource &recorded) {
+			if (recorded.slot < 0) {
+				return;
+			}
+			const auto setup = [&config](AudioSource &added) { added.configure(config, nullptr); };
+			AudioSource *source = registry.add(QString::fromStdString(recorded.uuid),
+							   QString::fromStdString(recorded.name), QColor(),
+							   replay.sampleRate() / 50, setup);
+			if (targets.size() <= static_cast<size_t>(recorded.slot)) {
+				targets.resize(recorded.slot + 1, nullptr);
+			}
+			targets[recorded.slot] = source;
+		},
+		[&](const ReplayBlock &block) {
+			if (nextStep == 0) {
+				nextStep = block.timestampNs + interval;
+			}
+			while (block.timestampNs >= nextStep) {
+				analyzeAt(nextStep);
+				nextStep += interval;
+			}
+			AudioSource *target = static_cast<size_t>(block.slot) < targets.size() ? targets[block.slot]
+											       : nullptr;
+			if (target) {
+				target->push(block.left, block.right, block.frames, block.timestampNs);
+				blocks++;
+				samples += block.frames;
+			}
+			return true;
+		});
+	analyzeAt(nextStep);
+
+	std::printf("{\n");
+	std::printf("  \"replay\": \"%s\",\n", path);
+	std::printf("  \"sample_rate\": %u,\n", replay.sampleRate());
+	std::printf("  \"blocks\": %llu,\n", static_cast<unsigned long long>(blocks));
+	std::printf("  \"dropped_blocks\": %llu,\n", static_cast<unsigned long long>(replay.droppedBlocks()));
+	std::printf("  \"analysis_cycles\": %llu,\n", static_cast<unsigned long long>(steps));
+	std::printf("  \"analyze_ns_per_sample\": %.3f,\n", samples ? analyzeNs / samples : 0.0);
+	std::printf("  \"result_hash\": \"%016llx\"\n", static_cast<unsigned long long>(hash));
+	std::printf("}\n");
+	return 0;
+}
+
+} // namespace
+
+int main(int argc, char **argv)
+{
+	int cycles = 200;
+	bool quick = false;
+	for (int i = 1; i < argc; ++i) {
+		if (std::strcmp(argv[i], "--cycles") == 0 && i + 1 < argc) {
+			cycles = std::max(1, std::atoi(argv[++i]));
+		} else if (std::strcmp(argv[i], "--quick") == 0) {
+			quick = true;
+		} else if (std::strcmp(argv[i], "--replay") == 0 && i + 1 < argc) {
+			return replayCapture(argv[i + 1]);
+		} else {
+			std::fprintf(stderr, "usage: %s [--cycles N] [--quick] | --replay FILE\n", argv[0]);
+			return 2;
+		}
+	}
+
+	const std::vector<size_t> blockSizes =
+		quick ? std::vector<size_t>{480} : std::vector<size_t>{64, 256, 480, 1024, 4096};
+	const std::vector<int> sourceCounts = quick ? std::vector<int>{1, 4} : std::vector<int>{1, 4, 16};
+	const Signal signals[] = {Signal::Sine, Signal::PinkNoise, Signal::Inverted, Signal::Decorrelated};
+
+	std::vector<float> left;
+	std::vector<float> right;
+	generate(Signal::PinkNoise, left, right);
+	const std::vector<KernelResult> kernels = benchKernels(left, right, quick ? 20 : 200);
+	const std::vector<MatrixResult> matrices = benchMatrix(left, right, quick ? 10 : 100);
+
+	std::vector<PipelineResult> results;
+	for (Signal signal : signals) {
+		generate(signal, left, right);
+		for (size_t block : blockSizes) {
+			for (int count : sourceCounts) {
+				results.push_back(benchPipeline(signal, left, right, block, count, cycles));
+			}
+		}
+	}
+
+	// JSON出力（比較スクリプトから読むので形式を変えるときは注意）
+	std::printf("{\n");
+	std::printf("  \"sample_rate\": %u,\n", SAMPLE_RATE);
+	std::printf("  \"cycles\": %d,\n", cycles);
+	std::printf("  \"active_kernel\": \"%s\",\n", kernelIsaName(activeKernelIsa()));
+	std::printf("  \"paint_scope\": \"bench scope compositing only, not PhaseMeterWidget::paintEvent; "
+		    "allocations inside Qt are not counted\",\n");
+	std::printf("  \"kernels\": [\n");
+	for (size_t i = 0; i < kernels.size(); ++i) {
+		std::printf("    {\"isa\": \"%s\", \"ns_per_sample\": %.4f, \"max_rel_error\": %.3g}%s\n",
+			    kernels[i].isa, kernels[i].nsPerSample, kernels[i].maxRelError,
+			    i + 1 < kernels.size() ? "," : "");
+	}
+	std::printf("  ],\n");
+	std::printf("  \"matrix\": [\n");
+	for (size_t i = 0; i < matrices.size(); ++i) {
+		std::printf("    {\"channels\": %d, \"ns_per_sample\": %.4f, \"read_ns_per_sample\": %.4f}%s\n",
+			    matrices[i].channels, matrices[i].nsPerSample, matrices[i].readNsPerSample,
+			    i + 1 < matrices.size() ? "," : "");
+	}
+	std::printf("  ],\n");
+	std::printf("  \"pipeline\": [\n");
+	for (size_t i = 0; i < results.size(); ++i) {
+		const PipelineResult &r = results[i];
+		std::printf("    {\"signal\": \"%s\", \"block_frames\": %zu, \"sources\": %d, "
+			    "\"capture_ns_per_sample\": %.3f, \"analyze_ns_per_sample\": %.3f, "
+			    "\"paint_ns_per_frame\": %.0f, \"frames_per_second\": %.1f, "
+			    "\"allocations_per_frame\": %.3f}%s\n",
+			    signalName(r.signal), r.blockFrames, r.sources, r.captureNsPerSample, r.analyzeNsPerSample,
+			    r.paintNsPerFrame, r.framesPerSecond, r.allocationsPerFrame,
+			    i + 1 < results.size() ? "," : "");
+	}
+	std::printf("  ]\n");
+	std::printf("}\n");
+
+	// 回帰チェック: どの実装もスカラー実装と許容差に収まること
+	int failures = 0;
+	for (const KernelResult &k : kernels) {
+		if (k.maxRelError > KERNEL_TOLERANCE) {
+			std::fprintf(stderr, "kernel mismatch: %s differs from scalar by %.3g (tolerance %.0e)\n",
+				     k.isa, k.maxRelError, KERNEL_TOLERANCE);
+			failures++;
+		}
+	}
+
+	// 回帰チェック: ウォームアップ後の定常状態では、どの段もメモリを確保しないこと
+	for (const PipelineResult &r : results) {
+		if (r.allocationsPerFrame <= 0.0) {
+			continue;
+		}
+		std::fprintf(stderr, "allocation regression: %s, %zu frames, %d sources:", signalName(r.signal),
+			     r.blockFrames, r.sources);
+		for (int stage = 0; stage < ALLOC_STAGES; ++stage) {
+			if (r.stageAllocations[stage] > 0) {
+				std::fprintf(stderr, " %s %llu", allocStageName(static_cast<AllocStage>(stage)),
+					     static_cast<unsigned long long>(r.stageAllocations[stage]));
+			}
+		}
+		std::fprintf(stderr, " over %d cycles\n", cycles);
+		failures++;
+	}
+	return failures > 0 ? 1 : 0;
+}
@@ -0,0 +1,177 @@
+/*
+Audoo-phase-meter for OBS
+Copyright (C) 2025 you214 https://github.com/you214
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along
+with this program. If not, see <https://www.gnu.org/licenses/>
+*/
+
+
+#include "alloc-tracker.h"
+
+const char *allocStageName(AllocStage stage)
+{
+	switch (stage) {
+	case AllocStage::Capture:
+		return "capture";
+	case AllocStage::Drain:
+		return "drain";
+	case AllocStage::Analysis:
+		return "analysis";
+	case AllocStage::Paint:
+		return "paint";
+	default:
+		return "other";
+	}
+}
+
+#ifdef PHASE_METER_ALLOC_TRACKING
+
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+// 置き換えたnew/deleteをインライン展開したGCCがmalloc/freeの対応を誤検出するため警告を抑止する
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic ignored "-Wmismatched-new-delete"
+#endif
+
+namespace {
+
+struct alignas(64) StageCounters {
+	std::atomic<uint64_t> count{0};
+	std::atomic<uint64_t> bytes{0};
+};
+
+// otherは複数のスレッドが書き込むので、ここだけはfetch_addで数える（計測用のビルドに限る）
+StageCounters stageCounters[static_cast<int>(AllocStage::Count)];
+thread_local AllocStage currentStage = AllocStage::Other;
+
+void record(size_t size)
+{
+	StageCounters &counters = stageCounters[static_cast<int>(currentStage)];
+	counters.count.fetch_add(1, std::memory_order_relaxed);
+	counters.bytes.fetch_add(size, std::memory_order_relaxed);
+}
+
+// Windowsの_aligned_mallocはfreeでは解放できない
+void alignedFree(void *p)
+{
+#ifdef _WIN32
+	_aligned_free(p);
+#else
+	std::free(p);
+#endif
+}
+
+} // namespace
+
+AllocScope::AllocScope(AllocStage stage) : m_previous(currentStage)
+{
+	currentStage = stage;
+}
+
+AllocScope::~AllocScope()
+{
+	currentStage = m_previous;
+}
+
+AllocTotals allocTotals(AllocStage stage)
+{
+	const StageCounters &counters = stageCounters[static_cast<int>(stage)];
+	AllocTotals totals;
+	totals.count = counters.count.load(std::memory_order_relaxed);
+	totals.bytes = counters.bytes.load(std::memory_order_relaxed);
+	return totals;
+}
+
+// libstdc++の<new>はoperator newをdefault可視性で宣言するので、-fvisibility=hiddenでもこの定義は公開される
+// OBSがdlopenしたモジュールの中の呼び出しは、そのままだと本体が読み込んだlibstdc++のoperator newに束縛されて数えられない
+// そのためLinuxではCMakeで-Bsymbolic-functionsを付けてリンクし、このモジュールの中の呼び出しをここへ束縛する
+// （実行ファイルのベンチでは付けなくてもここが使われる）
+void *operator new(size_t size)
+{
+	record(size);
+	if (void *p = std::malloc(size ? size : 1)) {
+		return p;
+	}
+	throw std::bad_alloc();
+}
+
+void *operator new[](size_t size)
+{
+	return operator new(size);
+}
+
+void *operator new(size_t size, std::align_val_t alignment)
+{
+	record(size);
+	const size_t align = static_cast<size_t>(alignment);
+#ifdef _WIN32
+	if (void *p = _aligned_malloc(size ? size : 1, align)) {
+		return p;
+	}
+#else
+	if (void *p = std::aligned_alloc(align, (size + align - 1) / align * align)) {
+		return p;
+	}
+#endif
+	throw std::bad_alloc();
+}
+
+void *operator new[](size_t size, std::align_val_t alignment)
+{
+	return operator new(size, alignment);
+}
+
+void operator delete(void *p) noexcept
+{
+	std::free(p);
+}
+
+void operator delete[](void *p) noexcept
+{
+	std::free(p);
+}
+
+void operator delete(void *p, size_t) noexcept
+{
+	std::free(p);
+}
+
+void operator delete[](void *p, size_t) noexcept
+{
+	std::free(p);
+}
+
+void operator delete(void *p, std::align_val_t) noexcept
+{
+	alignedFree(p);
+}
+
+void operator delete[](void *p, std::align_val_t) noexcept
+{
+	alignedFree(p);
+}
+
+void operator delete(void *p, size_t, std::align_val_t) noexcept
+{
+	alignedFree(p);
+}
+
+void operator delete[](void *p, size_t, std::align_val_t) noexcept
+{
+	alignedFree(p);
+}
+
+#endif
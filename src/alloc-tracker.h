@@ -0,0 +1,70 @@
+/*
+Audoo-phase-meter for OBS
+Copyright (C) 2025 you214 https://github.com/you214
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along
+with this program. If not, see <https://www.gnu.org/licenses/>
+*/
+
+
+#pragma once
+
+#include <cstdint>
+
+// パイプラインの段ごとのメモリ確保の計測（ENABLE_ALLOC_TRACKINGでビルドしたときだけ数える）
+// 置き換えたoperator newで数えるので、Qtなど他のライブラリの中でmallocされた分は含まない
+// 段はスレッドごとに持つ（音声スレッド=capture、解析スレッド=drain/analysis、GUIスレッド=paint）
+enum class AllocStage { Other, Capture, Drain, Analysis, Paint, Count };
+
+struct AllocTotals {
+	uint64_t count = 0;
+	uint64_t bytes = 0;
+};
+
+const char *allocStageName(AllocStage stage);
+
+#ifdef PHASE_METER_ALLOC_TRACKING
+
+constexpr bool ALLOC_TRACKING = true;
+
+// このスレッドでの確保をstageに数える。入れ子にでき、抜けると元の段に戻す
+class AllocScope {
+public:
+	explicit AllocScope(AllocStage stage);
+	~AllocScope();
+
+	AllocScope(const AllocScope &) = delete;
+	AllocScope &operator=(const AllocScope &) = delete;
+
+private:
+	AllocStage m_previous;
+};
+
+// 起動してからの累計
+AllocTotals allocTotals(AllocStage stage);
+
+#else
+
+constexpr bool ALLOC_TRACKING = false;
+
+class AllocScope {
+public:
+	explicit AllocScope(AllocStage) {}
+};
+
+inline AllocTotals allocTotals(AllocStage)
+{
+	return {};
+}
+
+#endif
@@ -0,0 +1,272 @@
+/*
+Audoo-phase-meter for OBS
+Copyright (C) 2025 you214 https://github.com/you214
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along
+with this program. If not, see <https://www.gnu.org/licenses/>
+*/
+
+#include "analysis-worker.h"
+#include "alloc-tracker.h"
+#include <algorithm>
+#include <cmath>
+
+AnalysisWorker::AnalysisWorker(SourceRegistry &registry) : m_registry(registry)
+{
+}
+
+AnalysisWorker::~AnalysisWorker()
+{
+	stop();
+}
+
+void AnalysisWorker::start()
+{
+	if (m_thread.joinable()) {
+		return;
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(m_wakeMutex);
+		m_stopping = false;
+	}
+	m_thread = std::thread(&AnalysisWorker::run, this);
+}
+
+void AnalysisWorker::stop()
+{
+	{
+		std::lock_guard<std::mutex> lock(m_wakeMutex);
+		m_stopping = true;
+	}
+	m_wake.notify_all();
+	m_clock.signal(); // 通知待ちで眠っていれば起こす
+
+	if (m_thread.joinable()) {
+		m_thread.join();
+	}
+}
+
+void AnalysisWorker::run()
+{
+	auto nextTick = std::chrono::steady_clock::now();
+	std::unique_lock<std::mutex> lock(m_wakeMutex);
+	while (!m_stopping) {
+		// 新しい音声か表示の変更が届くまで眠る
+		lock.unlock();
+		m_clock.wait();
+		lock.lock();
+
+		// 前回の解析から1周期は空ける（その間に届いた通知は次の1回にまとめる）
+		if (m_wake.wait_until(lock, nextTick, [this]() { return m_stopping; })) {
+			break;
+		}
+		lock.unlock();
+
+		const auto tickStart = std::chrono::steady_clock::now();
+		m_clock.consume();
+		const uint64_t sequence = m_sequence;
+		// 残光が消えるまでは音声が止まっても次の周期を刻む
+		if (analyze(statNowNs())) {
+			m_clock.signal();
+		}
+		if (m_sequence != sequence && m_onFrame) {
+			m_onFrame();
+		}
+		nextTick = tickStart + m_clock.period();
+
+		lock.lock();
+	}
+}
+
+bool AnalysisWorker::analyze(uint64_t nowNs)
+{
+	const AllocScope allocScope(AllocStage::Analysis);
+	const uint64_t start = statNowNs();
+	const double elapsedMs = m_lastCycleNs && nowNs > m_lastCycleNs ? (nowNs - m_lastCycleNs) / 1e6 : 0.0;
+	m_lastCycleNs = nowNs;
+
+	const int rasterSize = std::clamp(m_rasterSize.load(std::memory_order_relaxed), 16, MAX_RASTER_SIZE);
+	const uint64_t historyView = m_historyView.load(std::memory_order_relaxed);
+	const size_t historyColumns = static_cast<size_t>(historyView >> 32);
+	const uint64_t historyStep = historyView & 0xFFFFFFFFu;
+	AnalysisFrame &frame = m_frames.writeBuffer();
+	frame.count = 0;
+	bool fresh = false;
+	bool delayCaptured = false;
+	bool delayPending = false;
+
+	{
+		// この周期で読む一覧と設定の版（削除されたソースも、この版を手放すまでは解放されない）
+		const SourceSnapshot sources = m_registry.snapshot();
+		const auto config = m_config.acquire();
+
+		const bool delayActive = updateDelayPair(*sources);
+
+		sources->forEach([&](const SourceEntry &entry) {
+			const uint64_t sourceStart = statNowNs();
+			AudioSource &source = *entry.source;
+			source.configure(*config, entry.tap.get());
+
+			// 遅延推定の対象になっているソースだけ時刻付きの履歴を取る
+			const bool inPair = delayActive && (source.slot == m_delayReference || source.slot == m_delayTarget);
+			if (inPair != source.history.enabled()) {
+				source.history.configure(inPair ? m_delay.historyFrames() : 0);
+			}
+
+			source.raster.resize(rasterSize);
+			source.raster.setColor(entry.color.rgb());
+
+			// 残光を減衰させてから新しいサンプルを打点する
+			// 表示しないソースもリングは読み捨てて、溢れないようにする
+			const bool decaying = source.raster.decay(elapsedMs);
+			bool drained;
+			{
+				const AllocScope drainScope(AllocStage::Drain);
+				drained = source.drain(entry.tap.get());
+			}
+			fresh = fresh || drained || decaying;
+			m_delayDirty = m_delayDirty || (inPair && drained);
+
+			if (frame.count == frame.sources.size()) {
+				frame.sources.emplace_back();
+			}
+			SourceFrame &out = frame.sources[frame.count++];
+			if (out.slot != source.slot) {
+				// 別のソースの履歴・画像・スペクトルが残っている。版は各ソースで0から数えるので、
+				// どの版とも一致しない値にして必ず取り直す（グリッドのタイルもpixelsVersionで判断する）
+				out.historyView = 0;
+				out.pixelsVersion = ~uint64_t(0);
+				out.spectrumVersion = ~uint64_t(0);
+			}
+			out.slot = source.slot;
+			out.name = entry.name;
+			out.color = entry.color;
+			out.enabled = source.enabled;
+			out.hasAudio = source.validFrames > 0;
+			out.correlation = static_cast<float>(source.correlation.correlation());
+			out.bandCount = source.bands.bandCount();
+			for (int band = 0; band < out.bandCount; ++band) {
+				out.bandCorrelation[band] = static_cast<float>(source.bands.correlation(band));
+			}
+
+			const ChannelMatrix &matrix = source.matrix;
+			out.matrixChannels = matrix.enabled() && !entry.tap ? matrix.channels() : 0; // フィルターは2チャンネルだけ
+			for (int a = 0; a < out.matrixChannels; ++a) {
+				out.matrix[ChannelMatrix::pairIndex(a, a)] = static_cast<float>(matrix.levelDb(a));
+				for (int b = a + 1; b < out.matrixChannels; ++b) {
+					const float correlation = static_cast<float>(matrix.correlation(a, b));
+					out.matrix[ChannelMatrix::pairIndex(a, b)] = correlation;
+				}
+			}
+			out.phantomCenter = static_cast<float>(matrix.phantomCenter());
+
+			out.hasSpectrum = source.spectrum.enabled();
+			if (out.hasSpectrum && out.spectrumVersion != source.spectrum.version()) {
+				source.spectrum.columns(out.spectrumPhase.data(), out.spectrumMono.data(),
+							out.spectrumLevel.data());
+				out.spectrumVersion = source.spectrum.version();
+			}
+
+			// 履歴は表示1列あたり数点を読むだけなので、ソース数が多くても軽い
+			if (historyColumns == 0) {
+				out.historyCount = 0;
+			} else if (out.historyView != historyView ||
+				   out.historyPoints != source.correlationHistory.points()) {
+				if (out.history.size() < historyColumns) {
+					out.history.resize(historyColumns);
+				}
+				out.historyCount = source.correlationHistory.read(historyStep, historyColumns,
+										  out.history.data());
+				out.historyView = historyView;
+				out.historyPoints = source.correlationHistory.points();
+			}
+
+			// このバッファが前回公開された後にスコープが変化していれば画像へ変換し直す
+			if (out.imageSize != source.raster.size()) {
+				out.imageSize = source.raster.size();
+				out.pixels.assign(static_cast<size_t>(out.imageSize) * out.imageSize, 0);
+				out.pixelsVersion = 0;
+			}
+			if (out.pixelsVersion != source.raster.version()) {
+				source.raster.render(out.pixels.data());
+				out.pixelsVersion = source.raster.version();
+			}
+
+			statAdd(source.consumeStats.analyzeNs, statNowNs() - sourceStart);
+		});
+
+		// 推定は数回/秒で十分なので、間隔が空いたときだけ窓を切り出す
+		// 新しい音声が無ければ結果も変わらないので、切り出さずに解析スレッドを眠らせる
+		if (delayActive && m_delayDirty && nowNs >= m_delayDueNs) {
+			m_delayDirty = false;
+			m_delayDueNs = nowNs + std::chrono::nanoseconds(DELAY_INTERVAL).count();
+			const SourceEntry *reference = sources->at(m_delayReference);
+			const SourceEntry *target = sources->at(m_delayTarget);
+			delayCaptured = reference && target &&
+					m_delay.capture(reference->source->history, target->source->history);
+		}
+		delayPending = delayActive && m_delayDirty; // 間隔が空くまで次の周期を刻む
+	}
+
+	if (delayCaptured) {
+		m_delay.estimate();
+		fresh = true;
+	}
+	frame.delayReference = m_delayReference;
+	frame.delayTarget = m_delayTarget;
+	frame.delay = m_delay.result();
+
+	// 新しい音声もソース一覧の変化もなければ公開しない（描画側を起こさない）
+	const bool force = m_forcePublish.exchange(false, std::memory_order_relaxed);
+	if (fresh || force || frame.count != m_publishedCount) {
+		frame.sequence = ++m_sequence;
+		m_publishedCount = frame.count;
+		if (m_frames.publish()) {
+			statAdd(m_stats.framesSuperseded, 1);
+		}
+		statAdd(m_stats.framesPublished, 1);
+	}
+
+	statAdd(m_stats.cycles, 1);
+	statAdd(m_stats.analyzeNs, statNowNs() - start);
+	return fresh || delayPending;
+}
+
+bool AnalysisWorker::updateDelayPair(const SourceList &sources)
+{
+	const uint64_t packed = m_delayPair.load(std::memory_order_relaxed);
+	const int reference = static_cast<int32_t>(packed >> 32);
+	const int target = static_cast<int32_t>(packed & 0xFFFFFFFFu);
+	const bool active = reference >= 0 && target >= 0 && reference != target;
+
+	if (!active) {
+		m_delayReference = -1;
+		m_delayTarget = -1;
+		return false;
+	}
+
+	// 組み合わせが変わったら推定をやり直す（サンプルレートは基準ソースに合わせる）
+	if (reference != m_delayReference || target != m_delayTarget) {
+		const SourceEntry *source = sources.at(reference);
+		if (!source) {
+			return false;
+		}
+		m_delay.configure(source->source->sampleRate);
+		m_delayReference = reference;
+		m_delayTarget = target;
+		m_delayDueNs = 0;
+		m_delayDirty = true; // 溜まっている履歴ですぐに推定する
+	}
+	return true;
+}
@@ -0,0 +1,199 @@
+/*
+Audoo-phase-meter for OBS
+Copyright (C) 2025 you214 https://github.com/you214
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along
+with this program. If not, see <https://www.gnu.org/licenses/>
+*/
+
+#pragma once
+
+#include <QString>
+#include <QColor>
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "frame-clock.h"
+#include "source-registry.h"
+#include "triple-buffer.h"
+
+// 1ソース分の描画用データ（解析スレッドが作り、GUIスレッドは読むだけ）
+struct SourceFrame {
+	int slot = -1;
+	QString name;
+	QColor color;
+	bool enabled = false;
+	bool hasAudio = false;
+	float correlation = 0.0f;
+
+	// 帯域別の相関（bandCount == 0 なら無効）
+	int bandCount = 0;
+	std::array<float, BandCorrelationMeter::MAX_BANDS> bandCorrelation = {};
+
+	// 多チャンネルの相関行列（matrixChannels == 0 なら無効）。並びはChannelMatrix::pairIndexで、対角はレベル（dBFS）
+	int matrixChannels = 0;
+	std::array<float, ChannelMatrix::MAX_PAIRS> matrix = {};
+	float phantomCenter = 0.0f; // Cと(L+R)の相関
+
+	// スペクトル表示用の列（hasSpectrum == false なら無効）
+	bool hasSpectrum = false;
+	uint64_t spectrumVersion = 0; // 変換元のversion。一致していれば再計算しない
+	std::array<float, PhaseSpectrum::COLUMNS> spectrumPhase = {};
+	std::array<float, PhaseSpectrum::COLUMNS> spectrumMono = {};
+	std::array<float, PhaseSpectrum::COLUMNS> spectrumLevel = {};
+
+	// 相関履歴の列（古い順にhistoryCount列、最後が最新）。表示範囲と履歴の点数が前回と同じなら読み直さない
+	size_t historyCount = 0;
+	uint64_t historyView = 0;
+	uint64_t historyPoints = 0;
+	std::vector<HistoryPoint> history;
+
+	// スコープ画像（ARGB32乗算済み、imageSize四方）。描画側はコピーせずQImageで包む
+	int imageSize = 0;
+	std::vector<uint32_t> pixels;
+	uint64_t pixelsVersion = 0; // 変換元ラスタライザのversion。一致していれば再変換しない
+};
+
+// 1回の解析結果。トリプルバッファで使い回すので、sourcesは縮めずにcountで有効数を管理する
+struct AnalysisFrame {
+	uint64_t sequence = 0;
+	size_t count = 0;
+	std::vector<SourceFrame> sources;
+
+	// ソース間の遅延推定（基準・対象のスロットが-1なら無効）
+	int delayReference = -1;
+	int delayTarget = -1;
+	DelayEstimate delay;
+};
+
+// 全ソースのリングを取り出し、相関と描画形状を計算して最新フレームとして公開する常駐スレッド
+// 解析が遅くてもGUIスレッドは前回のフレームを描くだけで、描画が遅くても解析は止まらない
+// 新しい音声が届いたときだけFrameClockの周期で起き、全ソースが無音で残光も消えていれば眠ったままになる
+// ソース一覧は周期ごとにロックを取らずに版を受け取り、解析の設定もここで各ソースへ反映する
+class AnalysisWorker {
+public:
+	explicit AnalysisWorker(SourceRegistry &registry);
+	~AnalysisWorker();
+
+	AnalysisWorker(const AnalysisWorker &) = delete;
+	AnalysisWorker &operator=(const AnalysisWorker &) = delete;
+
+	// onFrameはフレームを公開するたびに解析スレッドから呼ばれる（GUIへの通知用。start()の前に設定する）
+	void setFrameCallback(std::function<void()> onFrame) { m_onFrame = std::move(onFrame); }
+
+	void start();
+	void stop();
+
+	// スレッドを起動せずに1回だけ解析する（ベンチマーク・再生・オフライン処理用。start()と併用しないこと）
+	// nowNsは残光の減衰と遅延推定の間隔に使う時刻。記録の時刻を渡せば結果が実行速度に依存しない
+	void step(uint64_t nowNs) { analyze(nowNs); }
+
+	// 解析の設定を差し替える（変わった段だけ、次の周期で全ソースへ反映する）
+	void setConfig(const SourceConfig &config)
+	{
+		m_config.publish(config);
+		requestPublish();
+	}
+
+	// 音声が無くても次の解析で必ずフレームを公開させる（ソースの追加・削除・色変更時）
+	void requestPublish()
+	{
+		m_forcePublish.store(true, std::memory_order_relaxed);
+		m_clock.signal();
+	}
+
+	// 解析の周期。音声の生産者はここへ通知し、GUIは表示の状態に合わせてレートを変える
+	FrameClock &clock() { return m_clock; }
+
+	// スコープ画像の一辺の画素数（表示サイズに合わせてGUIから設定）
+	void setRasterSize(int size)
+	{
+		if (m_rasterSize.exchange(size, std::memory_order_relaxed) != size) {
+			requestPublish();
+		}
+	}
+
+	// 履歴の表示範囲（columns列、1列あたり基本点pointsPerColumn個）。columnsが0なら履歴を読まない
+	void setHistoryView(size_t columns, uint64_t pointsPerColumn)
+	{
+		uint64_t packed = 0;
+		if (columns > 0) {
+			packed = (static_cast<uint64_t>(std::min<size_t>(columns, MAX_HISTORY_COLUMNS)) << 32) |
+				 std::clamp<uint64_t>(pointsPerColumn, 1, 0xFFFFFFFFu);
+		}
+		// 音声が止まっていても拡大率の変更はすぐ描き直す
+		if (m_historyView.exchange(packed, std::memory_order_relaxed) != packed) {
+			requestPublish();
+		}
+	}
+
+	// 遅延推定の基準と対象のスロット（どちらかが-1なら推定しない）
+	void setDelayPair(int referenceSlot, int targetSlot)
+	{
+		const uint64_t packed = (static_cast<uint64_t>(static_cast<uint32_t>(referenceSlot)) << 32) |
+					static_cast<uint32_t>(targetSlot);
+		if (m_delayPair.exchange(packed, std::memory_order_relaxed) != packed) {
+			requestPublish();
+		}
+	}
+
+	// GUIスレッド側: 新しいフレームがあれば受け取る
+	bool acquireFrame() { return m_frames.update(); }
+	bool hasNewFrame() const { return m_frames.hasUpdate(); }
+	const AnalysisFrame &frame() const { return m_frames.readBuffer(); }
+
+	const AnalysisStats &stats() const { return m_stats; }
+
+	static constexpr int MAX_RASTER_SIZE = 512;
+	static constexpr std::chrono::milliseconds DELAY_INTERVAL{200};
+	static constexpr size_t MAX_HISTORY_COLUMNS = 8192;
+
+private:
+	void run();
+	// 次の周期も解析が要るか（新しい音声・残光の減衰・遅延推定の待ち）を返す
+	bool analyze(uint64_t nowNs);
+	bool updateDelayPair(const SourceList &sources);
+
+	SourceRegistry &m_registry;
+	SnapshotPtr<SourceConfig> m_config;
+	TripleBuffer<AnalysisFrame> m_frames;
+	uint64_t m_sequence = 0;
+	uint64_t m_lastCycleNs = 0;
+	size_t m_publishedCount = 0;
+	std::atomic<int> m_rasterSize{ScopeRasterizer::DEFAULT_SIZE};
+	std::atomic<uint64_t> m_historyView{0};
+
+	// 遅延推定（窓はその周期の一覧の版を持っている間に切り出し、FFTは版を手放してから行う）
+	std::atomic<uint64_t> m_delayPair{~uint64_t(0)};
+	int m_delayReference = -1;
+	int m_delayTarget = -1;
+	uint64_t m_delayDueNs = 0;
+	bool m_delayDirty = false; // 前回の推定の後に基準か対象へ新しい音声が届いた
+	DelayEstimator m_delay;
+	AnalysisStats m_stats;
+
+	FrameClock m_clock;
+	std::function<void()> m_onFrame;
+	std::thread m_thread;
+	std::mutex m_wakeMutex;
+	std::condition_variable m_wake;
+	bool m_stopping = false;
+	std::atomic<bool> m_forcePublish{true};
+};
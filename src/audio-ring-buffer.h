@@ -0,0 +1,172 @@
+/*
+Audoo-phase-meter for OBS
+Copyright (C) 2025 you214 https://github.com/you214
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along
+with this program. If not, see <https://www.gnu.org/licenses/>
+*/
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <algorithm>
+#include <memory>
+
+// ステレオ音声用の単一生産者・単一消費者リングバッファ
+// 生産者（OBSの音声スレッド）はロックもメモリ確保も行わず、満杯時は溢れた分を破棄する
+class AudioRingBuffer {
+public:
+	// 容量は2の冪に切り上げる（インデックス計算をマスクで済ませるため）
+	explicit AudioRingBuffer(size_t minCapacity = DEFAULT_CAPACITY)
+	{
+		size_t capacity = 1;
+		while (capacity < minCapacity) {
+			capacity <<= 1;
+		}
+		m_capacity = capacity;
+		m_mask = capacity - 1;
+		m_left = std::make_unique<float[]>(capacity);
+		m_right = std::make_unique<float[]>(capacity);
+	}
+
+	AudioRingBuffer(const AudioRingBuffer &) = delete;
+	AudioRingBuffer &operator=(const AudioRingBuffer &) = delete;
+
+	size_t capacity() const { return m_capacity; }
+
+	// 生産者側: 書き込めたフレーム数を返す（書き込めなかった分は破棄）
+	// timestampNsを渡すと、このブロック先頭の位置と時刻の対応を記録する（0なら記録しない）
+	size_t write(const float *left, const float *right, size_t frames, uint64_t timestampNs = 0)
+	{
+		const uint64_t head = m_head.load(std::memory_order_relaxed);
+		if (timestampNs != 0) {
+			publishStamp(head, timestampNs);
+		}
+
+		const uint64_t tail = m_tail.load(std::memory_order_acquire);
+		const size_t space = m_capacity - static_cast<size_t>(head - tail);
+		const size_t count = std::min(frames, space);
+
+		if (count > 0) {
+			const size_t start = static_cast<size_t>(head) & m_mask;
+			const size_t first = std::min(count, m_capacity - start);
+
+			std::memcpy(m_left.get() + start, left, first * sizeof(float));
+			std::memcpy(m_right.get() + start, right, first * sizeof(float));
+			if (count > first) {
+				std::memcpy(m_left.get(), left + first, (count - first) * sizeof(float));
+				std::memcpy(m_right.get(), right + first, (count - first) * sizeof(float));
+			}
+
+			m_head.store(head + count, std::memory_order_release);
+		}
+
+		if (count < frames) {
+			m_dropped.fetch_add(frames - count, std::memory_order_relaxed);
+		}
+
+		return count;
+	}
+
+	// 消費者側: 読み出し可能なフレーム数
+	size_t available() const
+	{
+		return static_cast<size_t>(m_head.load(std::memory_order_acquire) -
+					   m_tail.load(std::memory_order_relaxed));
+	}
+
+	// 消費者側: コピーせずにリング上の連続領域をコールバックへ渡し、すべて消費する
+	// fn(const float *left, const float *right, size_t frames) は最大2回呼ばれる
+	template<typename Fn> size_t consume(Fn &&fn)
+	{
+		const uint64_t tail = m_tail.load(std::memory_order_relaxed);
+		const uint64_t head = m_head.load(std::memory_order_acquire);
+		const size_t count = static_cast<size_t>(head - tail);
+
+		if (count == 0) {
+			return 0;
+		}
+
+		const size_t start = static_cast<size_t>(tail) & m_mask;
+		const size_t first = std::min(count, m_capacity - start);
+
+		fn(m_left.get() + start, m_right.get() + start, first);
+		if (count > first) {
+			fn(m_left.get(), m_right.get(), count - first);
+		}
+
+		m_tail.store(head, std::memory_order_release);
+		return count;
+	}
+
+	// 消費者側: 次に読み出すフレームの通し位置
+	uint64_t readPosition() const { return m_tail.load(std::memory_order_relaxed); }
+
+	// 通し位置positionのフレームの時刻（ns）。最後に記録された時刻から外挿する。未記録ならfalse
+	bool frameTime(uint64_t position, uint32_t sampleRate, uint64_t &timeNs) const
+	{
+		uint32_t before, after;
+		uint64_t stampFrame, stampNs;
+		do {
+			before = m_stampSeq.load(std::memory_order_acquire);
+			stampFrame = m_stampFrame.load(std::memory_order_relaxed);
+			stampNs = m_stampNs.load(std::memory_order_relaxed);
+			std::atomic_thread_fence(std::memory_order_acquire);
+			after = m_stampSeq.load(std::memory_order_relaxed);
+		} while ((before & 1) || before != after);
+
+		if (stampNs == 0 || sampleRate == 0) {
+			return false;
+		}
+		const int64_t offset = static_cast<int64_t>(position - stampFrame);
+		timeNs = stampNs + offset * 1000000000LL / static_cast<int64_t>(sampleRate);
+		return true;
+	}
+
+	// 消費者側: 未読データをすべて破棄する
+	void clear() { m_tail.store(m_head.load(std::memory_order_acquire), std::memory_order_release); }
+
+	// 溢れて破棄されたフレームの累計
+	uint64_t droppedFrames() const { return m_dropped.load(std::memory_order_relaxed); }
+
+	// 48kHzで約340ms分。解析の周期（ドックが隠れている間は100ms）に対して十分な余裕を持たせる
+	static constexpr size_t DEFAULT_CAPACITY = 16384;
+
+private:
+	// シーケンスロック（書き込み中は奇数）。生産者は待たない
+	void publishStamp(uint64_t position, uint64_t timestampNs)
+	{
+		const uint32_t seq = m_stampSeq.load(std::memory_order_relaxed);
+		m_stampSeq.store(seq + 1, std::memory_order_relaxed);
+		std::atomic_thread_fence(std::memory_order_release);
+		m_stampFrame.store(position, std::memory_order_relaxed);
+		m_stampNs.store(timestampNs, std::memory_order_relaxed);
+		m_stampSeq.store(seq + 2, std::memory_order_release);
+	}
+
+	size_t m_capacity = 0;
+	size_t m_mask = 0;
+	std::unique_ptr<float[]> m_left;
+	std::unique_ptr<float[]> m_right;
+
+	// 生産者と消費者が書き込む変数は別キャッシュラインに置く
+	alignas(64) std::atomic<uint64_t> m_head{0};
+	std::atomic<uint64_t> m_dropped{0};
+	std::atomic<uint32_t> m_stampSeq{0};
+	std::atomic<uint64_t> m_stampFrame{0};
+	std::atomic<uint64_t> m_stampNs{0};
+	alignas(64) std::atomic<uint64_t> m_tail{0};
+};
@@ -0,0 +1,162 @@
+/*
+Audoo-phase-meter for OBS
+Copyright (C) 2025 you214 https://github.com/you214
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along
+with this program. If not, see <https://www.gnu.org/licenses/>
+*/
+
+#include "band-correlation.h"
+#include <algorithm>
+#include <cmath>
+
+static constexpr double LOWEST_EDGE_HZ = 20.0;
+static constexpr double HIGHEST_EDGE_HZ = 20000.0;
+static constexpr double PI = 3.14159265358979323846;
+
+// 無音が続いたときにフィルタ状態が非正規化数になって遅くならないよう、これ未満は0にする
+static constexpr float DENORMAL_LIMIT = 1e-18f;
+
+namespace {
+
+struct Biquad {
+	float b0 = 1.0f, b1 = 0.0f, b2 = 0.0f, a1 = 0.0f, a2 = 0.0f;
+};
+
+// Butterworth（Q = 1/√2）の2次ローパス・ハイパス。同じものを2段重ねるとLinkwitz-Riley 4次になる
+Biquad butterworth(double frequency, uint32_t sampleRate, bool highPass)
+{
+	const double w0 = 2.0 * PI * std::min(frequency, sampleRate * 0.45) / sampleRate;
+	const double cosW0 = std::cos(w0);
+	const double alpha = std::sin(w0) / std::sqrt(2.0);
+	const double a0 = 1.0 + alpha;
+
+	const double b1 = highPass ? -(1.0 + cosW0) : (1.0 - cosW0);
+	const double b0 = highPass ? (1.0 + cosW0) / 2.0 : (1.0 - cosW0) / 2.0;
+
+	Biquad q;
+	q.b0 = static_cast<float>(b0 / a0);
+	q.b1 = static_cast<float>(b1 / a0);
+	q.b2 = static_cast<float>(b0 / a0);
+	q.a1 = static_cast<float>(-2.0 * cosW0 / a0);
+	q.a2 = static_cast<float>((1.0 - alpha) / a0);
+	return q;
+}
+
+} // namespace
+
+void BandCorrelationMeter::configure(uint32_t sampleRate, int bandCount, double integrationMs,
+				     CorrelationMeter::Mode mode)
+{
+	m_bandCount = bandCount > 0 ? std::clamp(bandCount, MIN_BANDS, MAX_BANDS) : 0;
+	m_lanes = m_bandCount * 2;
+	sampleRate = std::max<uint32_t>(sampleRate, 1);
+
+	for (int i = 0; i <= m_bandCount; ++i) {
+		m_edges[i] = edgeFrequency(i, m_bandCount);
+	}
+
+	for (int band = 0; band < m_bandCount; ++band) {
+		// 最低域はハイパス無し、最高域はローパス無し（素通しの係数のまま）
+		const Biquad identity;
+		const Biquad highPass = band > 0 ? butterworth(m_edges[band], sampleRate, true) : identity;
+		const Biquad lowPass = band < m_bandCount - 1 ? butterworth(m_edges[band + 1], sampleRate, false)
+							       : identity;
+		const Biquad sections[STAGES] = {highPass, highPass, lowPass, lowPass};
+
+		for (int s = 0; s < STAGES; ++s) {
+			Stage &stage = m_stages[s];
+			for (int lane = band * 2; lane < band * 2 + 2; ++lane) {
+				stage.b0[lane] = sections[s].b0;
+				stage.b1[lane] = sections[s].b1;
+				stage.b2[lane] = sections[s].b2;
+				stage.a1[lane] = sections[s].a1;
+				stage.a2[lane] = sections[s].a2;
+			}
+		}
+
+		m_meters[band].configure(sampleRate, integrationMs, mode);
+	}
+
+	reset();
+}
+
+double BandCorrelationMeter::edgeFrequency(int index, int bandCount)
+{
+	if (bandCount <= 0) {
+		return LOWEST_EDGE_HZ;
+	}
+	return LOWEST_EDGE_HZ * std::pow(HIGHEST_EDGE_HZ / LOWEST_EDGE_HZ, static_cast<double>(index) / bandCount);
+}
+
+void BandCorrelationMeter::reset()
+{
+	for (Stage &stage : m_stages) {
+		std::fill(std::begin(stage.z1), std::end(stage.z1), 0.0f);
+		std::fill(std::begin(stage.z2), std::end(stage.z2), 0.0f);
+	}
+	for (int band = 0; band < m_bandCount; ++band) {
+		m_meters[band].reset();
+	}
+}
+
+void BandCorrelationMeter::process(const float *left, const float *right, size_t frames)
+{
+	if (m_bandCount == 0 || !left || !right) {
+		return;
+	}
+
+	for (size_t start = 0; start < frames; start += BLOCK_FRAMES) {
+		const size_t count = std::min(BLOCK_FRAMES, frames - start);
+		filterBlock(left + start, right + start, count);
+
+		// 帯域ごとの積分は広帯域と同じ積和カーネルを使う
+		for (int band = 0; band < m_bandCount; ++band) {
+			m_meters[band].process(m_output[band * 2], m_output[band * 2 + 1], count);
+		}
+	}
+
+	for (Stage &stage : m_stages) {
+		for (int lane = 0; lane < m_lanes; ++lane) {
+			stage.z1[lane] = std::fabs(stage.z1[lane]) < DENORMAL_LIMIT ? 0.0f : stage.z1[lane];
+			stage.z2[lane] = std::fabs(stage.z2[lane]) < DENORMAL_LIMIT ? 0.0f : stage.z2[lane];
+		}
+	}
+}
+
+void BandCorrelationMeter::filterBlock(const float *left, const float *right, size_t frames)
+{
+	const int lanes = m_lanes;
+
+	for (size_t i = 0; i < frames; ++i) {
+		alignas(64) float x[MAX_LANES];
+		for (int lane = 0; lane < lanes; ++lane) {
+			x[lane] = (lane & 1) ? right[i] : left[i];
+		}
+
+		// 直列の各段はサンプル方向には再帰だが、レーン方向には独立なのでベクトル化できる（転置直接形II）
+		for (Stage &stage : m_stages) {
+			for (int lane = 0; lane < lanes; ++lane) {
+				const float in = x[lane];
+				const float out = stage.b0[lane] * in + stage.z1[lane];
+				stage.z1[lane] = stage.b1[lane] * in - stage.a1[lane] * out + stage.z2[lane];
+				stage.z2[lane] = stage.b2[lane] * in - stage.a2[lane] * out;
+				x[lane] = out;
+			}
+		}
+
+		for (int lane = 0; lane < lanes; ++lane) {
+			m_output[lane][i] = x[lane];
+		}
+	}
+}
@@ -0,0 +1,80 @@
+/*
+Audoo-phase-meter for OBS
+Copyright (C) 2025 you214 https://github.com/you214
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along
+with this program. If not, see <https://www.gnu.org/licenses/>
+*/
+
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+#include "correlation-meter.h"
+
+// 帯域別の相関メーター
+// Linkwitz-Riley（4次）のクロスオーバーで帯域に分け、各帯域をCorrelationMeterで積分する
+// 帯域ごとのバンドパスは互いに独立なので、(帯域, チャンネル) をレーンとして全レーンをまとめて計算する
+class BandCorrelationMeter {
+public:
+	BandCorrelationMeter() = default;
+
+	// 帯域数0で無効（processは何もしない）。クロスオーバーは20Hz〜20kHzを対数で等分する
+	void configure(uint32_t sampleRate, int bandCount, double integrationMs, CorrelationMeter::Mode mode);
+	void reset();
+
+	void process(const float *left, const float *right, size_t frames);
+
+	int bandCount() const { return m_bandCount; }
+	double correlation(int band) const { return m_meters[band].correlation(); }
+
+	// 帯域の下限・上限周波数（両端は20Hz / 20kHz）
+	double lowerEdge(int band) const { return m_edges[band]; }
+	double upperEdge(int band) const { return m_edges[band + 1]; }
+
+	// bandCount帯域に分けたときの index 番目の境界周波数（0が20Hz、bandCountが20kHz）
+	static double edgeFrequency(int index, int bandCount);
+
+	static constexpr int MIN_BANDS = 3;
+	static constexpr int MAX_BANDS = 8;
+
+private:
+	// 1レーンあたりの直列ビカッド数（LR4ハイパス2段 + LR4ローパス2段、両端の帯域は不要な段を素通しにする）
+	static constexpr int STAGES = 4;
+	static constexpr int MAX_LANES = MAX_BANDS * 2;
+	static constexpr size_t BLOCK_FRAMES = 256;
+
+	// 係数と状態は段ごとにレーン方向へ並べる（レーン方向のループをSIMD化させるため）
+	struct alignas(64) Stage {
+		float b0[MAX_LANES];
+		float b1[MAX_LANES];
+		float b2[MAX_LANES];
+		float a1[MAX_LANES];
+		float a2[MAX_LANES];
+		float z1[MAX_LANES];
+		float z2[MAX_LANES];
+	};
+
+	void filterBlock(const float *left, const float *right, size_t frames);
+
+	int m_bandCount = 0;
+	int m_lanes = 0;
+	std::array<double, MAX_BANDS + 1> m_edges = {};
+	std::array<Stage, STAGES> m_stages = {};
+	std::array<CorrelationMeter, MAX_BANDS> m_meters;
+
+	// フィルタ出力（レーンごとにBLOCK_FRAMES分）。レーン2b がL、2b+1 がR
+	alignas(64) float m_output[MAX_LANES][BLOCK_FRAMES] = {};
+};
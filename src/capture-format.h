@@ -0,0 +1,85 @@
+/*
+Audoo-phase-meter for OBS
+Copyright (C) 2025 you214 https://github.com/you214
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along
+with this program. If not, see <https://www.gnu.org/licenses/>
+*/
+
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+// キャプチャ記録ファイル（.pmrec）の形式
+//   ファイルヘッダ → レコードの並び（記録順）
+//   レコードは8バイト境界に揃え、先頭に種類と全長（ヘッダ込み）を持つ
+//   数値はすべてリトルエンディアン、音声はプレーナのfloat（L全体の後にR全体）
+namespace CaptureFormat {
+
+constexpr char MAGIC[8] = {'P', 'M', 'C', 'A', 'P', 'T', 'U', 'R'};
+constexpr uint32_t VERSION = 1;
+
+struct FileHeader {
+	char magic[8];
+	uint32_t version;
+	uint32_t sampleRate;
+	uint64_t blocks;        // 記録した音声ブロック数（閉じるときに書く。0なら途中で止まったファイル）
+	uint64_t droppedBlocks; // リングが満杯で記録できなかったブロック数
+};
+
+enum RecordType : uint32_t {
+	RECORD_PADDING = 0, // リングの折り返し用（ファイルには書かない）
+	RECORD_SOURCE = 1,  // スロットとソースの対応（同じスロットの後のレコードで上書き）
+	RECORD_AUDIO = 2,
+};
+
+struct RecordHeader {
+	uint32_t type;
+	uint32_t size; // ヘッダ込みの全長。記録中のリングでは0が「書き込み中」を表す
+};
+
+// RECORD_SOURCE: 続けてUUIDと名前のUTF-8（終端なし）
+struct SourceRecord {
+	RecordHeader header;
+	int32_t slot;
+	uint16_t uuidLength;
+	uint16_t nameLength;
+};
+
+// RECORD_AUDIO: 続けてleft[frames]、right[frames]
+struct AudioRecord {
+	RecordHeader header;
+	int32_t slot;
+	uint32_t frames;
+	uint64_t timestampNs;
+};
+
+constexpr size_t ALIGNMENT = 8;
+
+constexpr size_t alignedSize(size_t size)
+{
+	return (size + ALIGNMENT - 1) & ~(ALIGNMENT - 1);
+}
+
+constexpr size_t audioRecordSize(size_t frames)
+{
+	return alignedSize(sizeof(AudioRecord) + frames * 2 * sizeof(float));
+}
+
+static_assert(sizeof(FileHeader) == 32);
+static_assert(sizeof(SourceRecord) == 16);
+static_assert(sizeof(AudioRecord) == 24);
+
+} // namespace CaptureFormat
@@ -0,0 +1,219 @@
+/*
+Audoo-phase-meter for OBS
+Copyright (C) 2025 you214 https://github.com/you214
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along
+with this program. If not, see <https://www.gnu.org/licenses/>
+*/
+
+
+#include "capture-recorder.h"
+#include <algorithm>
+#include <cstring>
+
+using namespace CaptureFormat;
+
+static_assert((CaptureRecorder::RING_BYTES & (CaptureRecorder::RING_BYTES - 1)) == 0);
+
+CaptureRecorder::CaptureRecorder() : m_ring(std::make_unique<uint8_t[]>(RING_BYTES))
+{
+	// 全長0は「書き込み中」を表すので、リングは0で初期化しておく
+	std::memset(m_ring.get(), 0, RING_BYTES);
+}
+
+CaptureRecorder::~CaptureRecorder()
+{
+	stop();
+}
+
+bool CaptureRecorder::start(const std::string &path, uint32_t sampleRate, std::string &error)
+{
+	if (m_thread.joinable()) {
+		error = "already recording";
+		return false;
+	}
+	if (!m_file.create(path, FILE_GROW_BYTES)) {
+		error = "cannot create " + path;
+		return false;
+	}
+
+	FileHeader header{};
+	std::memcpy(header.magic, MAGIC, sizeof(MAGIC));
+	header.version = VERSION;
+	header.sampleRate = sampleRate;
+	std::memcpy(m_file.data(), &header, sizeof(header));
+
+	m_fileUsed = sizeof(FileHeader);
+	m_fileFailed = false;
+	m_sampleRate = sampleRate;
+	m_blocks.store(0, std::memory_order_relaxed);
+	m_dropped.store(0, std::memory_order_relaxed);
+	m_written.store(m_fileUsed, std::memory_order_relaxed);
+
+	{
+		std::lock_guard<std::mutex> lock(m_wakeMutex);
+		m_stopping = false;
+	}
+	m_thread = std::thread(&CaptureRecorder::run, this);
+	m_active.store(true);
+	return true;
+}
+
+void CaptureRecorder::stop()
+{
+	if (!m_thread.joinable()) {
+		return;
+	}
+
+	// 新しい生産者を締め出し、確保済みのレコードが公開されるのを待つ
+	m_active.store(false);
+	while (m_producers.load() != 0) {
+		std::this_thread::yield();
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(m_wakeMutex);
+		m_stopping = true;
+	}
+	m_wake.notify_all();
+	m_thread.join();
+
+	// ヘッダの件数を確定し、伸長した余りを切り詰める
+	if (m_file.isOpen()) {
+		FileHeader *header = reinterpret_cast<FileHeader *>(m_file.data());
+		header->blocks = m_blocks.load(std::memory_order_relaxed);
+		header->droppedBlocks = m_dropped.load(std::memory_order_relaxed);
+	}
+	m_file.close(m_fileUsed);
+}
+
+uint8_t *CaptureRecorder::reserve(size_t size)
+{
+	uint64_t position = m_reserved.load(std::memory_order_relaxed);
+	for (;;) {
+		// 末尾に収まらなければ、残りを折り返し用のレコードで埋めて先頭から確保する
+		const size_t offset = static_cast<size_t>(position) & m_ringMask;
+		const size_t toEnd = RING_BYTES - offset;
+		const size_t needed = size <= toEnd ? size : toEnd + size;
+
+		if (position + needed - m_flushed.load(std::memory_order_acquire) > RING_BYTES) {
+			return nullptr;
+		}
+		if (m_reserved.compare_exchange_weak(position, position + needed, std::memory_order_relaxed)) {
+			if (size <= toEnd) {
+				return m_ring.get() + offset;
+			}
+			commit(m_ring.get() + offset, RECORD_PADDING, toEnd);
+			return m_ring.get();
+		}
+	}
+}
+
+void CaptureRecorder::commit(uint8_t *record, uint32_t type, size_t size)
+{
+	RecordHeader *header = reinterpret_cast<RecordHeader *>(record);
+	header->type = type;
+	std::atomic_ref<uint32_t>(header->size).store(static_cast<uint32_t>(size), std::memory_order_release);
+}
+
+void CaptureRecorder::recordAudio(int slot, uint64_t timestampNs, const float *left, const float *right,
+				  size_t frames)
+{
+	// 停止処理と入れ違いにならないよう、生産者数を増やしてから記録中かを確かめる
+	m_producers.fetch_add(1);
+	if (m_active.load()) {
+		const size_t size = audioRecordSize(frames);
+		uint8_t *record = size <= RING_BYTES / 4 ? reserve(size) : nullptr;
+		if (record) {
+			AudioRecord *audio = reinterpret_cast<AudioRecord *>(record);
+			audio->slot = slot;
+			audio->frames = static_cast<uint32_t>(frames);
+			audio->timestampNs = timestampNs;
+			float *samples = reinterpret_cast<float *>(record + sizeof(AudioRecord));
+			std::memcpy(samples, left, frames * sizeof(float));
+			std::memcpy(samples + frames, right, frames * sizeof(float));
+			commit(record, RECORD_AUDIO, size);
+			m_blocks.fetch_add(1, std::memory_order_relaxed);
+		} else {
+			m_dropped.fetch_add(1, std::memory_order_relaxed);
+		}
+	}
+	m_producers.fetch_sub(1, std::memory_order_release);
+}
+
+void CaptureRecorder::recordSource(int slot, const std::string &uuid, const std::string &name)
+{
+	m_producers.fetch_add(1);
+	if (m_active.load()) {
+		const size_t uuidLength = std::min<size_t>(uuid.size(), UINT16_MAX);
+		const size_t nameLength = std::min<size_t>(name.size(), UINT16_MAX);
+		const size_t size = alignedSize(sizeof(SourceRecord) + uuidLength + nameLength);
+		if (uint8_t *record = reserve(size)) {
+			SourceRecord *source = reinterpret_cast<SourceRecord *>(record);
+			source->slot = slot;
+			source->uuidLength = static_cast<uint16_t>(uuidLength);
+			source->nameLength = static_cast<uint16_t>(nameLength);
+			char *text = reinterpret_cast<char *>(record + sizeof(SourceRecord));
+			std::memcpy(text, uuid.data(), uuidLength);
+			std::memcpy(text + uuidLength, name.data(), nameLength);
+			commit(record, RECORD_SOURCE, size);
+		}
+	}
+	m_producers.fetch_sub(1, std::memory_order_release);
+}
+
+void CaptureRecorder::run()
+{
+	std::unique_lock<std::mutex> lock(m_wakeMutex);
+	while (!m_stopping) {
+		lock.unlock();
+		flush();
+		lock.lock();
+
+		m_wake.wait_for(lock, FLUSH_INTERVAL, [this]() { return m_stopping; });
+	}
+	lock.unlock();
+	flush();
+}
+
+void CaptureRecorder::flush()
+{
+	uint64_t position = m_flushed.load(std::memory_order_relaxed);
+	const uint64_t reserved = m_reserved.load(std::memory_order_acquire);
+
+	while (position < reserved) {
+		uint8_t *record = m_ring.get() + (static_cast<size_t>(position) & m_ringMask);
+		RecordHeader *header = reinterpret_cast<RecordHeader *>(record);
+		const uint32_t size = std::atomic_ref<uint32_t>(header->size).load(std::memory_order_acquire);
+		if (size == 0) {
+			break; // 生産者が書き込み中。記録順を守るため次回に回す
+		}
+
+		if (header->type != RECORD_PADDING && !m_fileFailed) {
+			if (m_fileUsed + size > m_file.size() && !m_file.resize(m_file.size() + FILE_GROW_BYTES)) {
+				// 伸長に失敗したら（ディスク不足など）以降は読み捨てる
+				m_fileFailed = true;
+			} else {
+				std::memcpy(m_file.data() + m_fileUsed, record, size);
+				m_fileUsed += size;
+			}
+		}
+
+		// 次に同じ領域を使うレコードのために、全長0（書き込み中）へ戻してから解放する
+		std::memset(record, 0, size);
+		position += size;
+	}
+
+	m_flushed.store(position, std::memory_order_release);
+	m_written.store(m_fileUsed, std::memory_order_relaxed);
+}
@@ -0,0 +1,98 @@
+/*
+Audoo-phase-meter for OBS
+Copyright (C) 2025 you214 https://github.com/you214
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along
+with this program. If not, see <https://www.gnu.org/licenses/>
+*/
+
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+
+#include "capture-format.h"
+#include "mapped-file.h"
+
+// 音声コールバックが受け取ったブロックをそのままメモリマップしたファイルへ記録する
+// 音声スレッドはロック不要の複数生産者リングへ詰めるだけで、システムコールもメモリ確保もしない
+// ファイルへの書き出しと伸長は書き出しスレッドが行う
+class CaptureRecorder {
+public:
+	CaptureRecorder();
+	~CaptureRecorder();
+
+	CaptureRecorder(const CaptureRecorder &) = delete;
+	CaptureRecorder &operator=(const CaptureRecorder &) = delete;
+
+	// 記録を開始する（失敗時はerrorに理由を入れてfalse）。パスはUTF-8
+	bool start(const std::string &path, uint32_t sampleRate, std::string &error);
+	// 記録中のブロックをすべて書き出してから閉じる
+	void stop();
+	bool isRecording() const { return m_active.load(std::memory_order_relaxed); }
+
+	// 音声スレッドから呼ぶ（記録していなければ何もしない）。リングが満杯なら破棄して数える
+	void recordAudio(int slot, uint64_t timestampNs, const float *left, const float *right, size_t frames);
+	// スロットとソースの対応を記録する（記録開始時、ソースの追加・名前変更時）
+	void recordSource(int slot, const std::string &uuid, const std::string &name);
+
+	uint64_t recordedBlocks() const { return m_blocks.load(std::memory_order_relaxed); }
+	uint64_t droppedBlocks() const { return m_dropped.load(std::memory_order_relaxed); }
+	uint64_t bytesWritten() const { return m_written.load(std::memory_order_relaxed); }
+
+	// 48kHzステレオで約20秒分。書き出しスレッドが多少遅れても溢れない
+	static constexpr size_t RING_BYTES = 8u << 20;
+	static constexpr size_t FILE_GROW_BYTES = 64u << 20;
+	static constexpr std::chrono::milliseconds FLUSH_INTERVAL{20};
+
+private:
+	// リング上にsizeバイトを確保して先頭を返す（満杯ならnullptr）
+	uint8_t *reserve(size_t size);
+	// 書き込み終えたレコードを公開する（全長を最後に書く）
+	static void commit(uint8_t *record, uint32_t type, size_t size);
+	void run();
+	// 公開済みのレコードをファイルへ書き出す
+	void flush();
+
+	std::unique_ptr<uint8_t[]> m_ring;
+	const size_t m_ringMask = RING_BYTES - 1;
+
+	// 生産者が確保した位置と、書き出しスレッドが読み終えた位置（どちらも通し位置）
+	alignas(64) std::atomic<uint64_t> m_reserved{0};
+	alignas(64) std::atomic<uint64_t> m_flushed{0};
+
+	// 停止時に、記録中の生産者がいなくなるまで待つ
+	alignas(64) std::atomic<bool> m_active{false};
+	std::atomic<int> m_producers{0};
+
+	std::atomic<uint64_t> m_blocks{0};
+	std::atomic<uint64_t> m_dropped{0};
+	std::atomic<uint64_t> m_written{0};
+
+	MappedFile m_file;
+	size_t m_fileUsed = 0;
+	bool m_fileFailed = false;
+	uint32_t m_sampleRate = 0;
+
+	std::thread m_thread;
+	std::mutex m_wakeMutex;
+	std::condition_variable m_wake;
+	bool m_stopping = false;
+};
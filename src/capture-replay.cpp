@@ -0,0 +1,115 @@
+/*
+Audoo-phase-meter for OBS
+Copyright (C) 2025 you214 https://github.com/you214
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along
+with this program. If not, see <https://www.gnu.org/licenses/>
+*/
+
+
+#include "capture-replay.h"
+#include <chrono>
+#include <cstring>
+#include <thread>
+
+using namespace CaptureFormat;
+
+bool CaptureReplay::open(const std::string &path, std::string &error)
+{
+	if (!m_file.openRead(path)) {
+		error = "cannot open " + path;
+		return false;
+	}
+
+	FileHeader header;
+	if (m_file.size() < sizeof(header)) {
+		error = "file too short";
+		m_file.close();
+		return false;
+	}
+	std::memcpy(&header, m_file.data(), sizeof(header));
+	if (std::memcmp(header.magic, MAGIC, sizeof(MAGIC)) != 0 || header.version != VERSION) {
+		error = "not a phase meter capture";
+		m_file.close();
+		return false;
+	}
+
+	m_sampleRate = header.sampleRate;
+	m_droppedBlocks = header.droppedBlocks;
+	return true;
+}
+
+bool CaptureReplay::play(Pace pace, const SourceFn &onSource, const BlockFn &onBlock,
+			 const std::atomic<bool> *stop) const
+{
+	const uint8_t *data = m_file.data();
+	const size_t size = m_file.size();
+	size_t offset = sizeof(FileHeader);
+
+	using Clock = std::chrono::steady_clock;
+	Clock::time_point wallOrigin;
+	uint64_t streamOrigin = 0;
+	uint64_t lastTimestamp = 0;
+
+	while (data && offset + sizeof(RecordHeader) <= size) {
+		if (stop && stop->load(std::memory_order_relaxed)) {
+			return false;
+		}
+
+		RecordHeader header;
+		std::memcpy(&header, data + offset, sizeof(header));
+		// 全長0は記録が途中で止まったファイルの末尾（伸長した余りの0埋め）
+		if (header.size < sizeof(RecordHeader) || offset + header.size > size) {
+			break;
+		}
+		const uint8_t *record = data + offset;
+		offset += header.size;
+
+		if (header.type == RECORD_SOURCE && header.size >= sizeof(SourceRecord)) {
+			SourceRecord source;
+			std::memcpy(&source, record, sizeof(source));
+			if (sizeof(SourceRecord) + source.uuidLength + source.nameLength > header.size) {
+				continue;
+			}
+			const char *text = reinterpret_cast<const char *>(record + sizeof(SourceRecord));
+			if (onSource) {
+				onSource({source.slot, std::string(text, source.uuidLength),
+					  std::string(text + source.uuidLength, source.nameLength)});
+			}
+		} else if (header.type == RECORD_AUDIO && header.size >= sizeof(AudioRecord)) {
+			AudioRecord audio;
+			std::memcpy(&audio, record, sizeof(audio));
+			if (audioRecordSize(audio.frames) > header.size) {
+				continue;
+			}
+
+			if (pace == Pace::RealTime) {
+				// 時刻が戻ったり大きく飛んだりしたら、そこを新しい起点にする
+				if (streamOrigin == 0 || audio.timestampNs < lastTimestamp ||
+				    audio.timestampNs - lastTimestamp > MAX_GAP_NS) {
+					streamOrigin = audio.timestampNs;
+					wallOrigin = Clock::now();
+				}
+				lastTimestamp = audio.timestampNs;
+				const std::chrono::nanoseconds offset(audio.timestampNs - streamOrigin);
+				std::this_thread::sleep_until(wallOrigin + offset);
+			}
+
+			const float *samples = reinterpret_cast<const float *>(record + sizeof(AudioRecord));
+			if (!onBlock({audio.slot, audio.timestampNs, audio.frames, samples, samples + audio.frames})) {
+				return false;
+			}
+		}
+	}
+	return true;
+}
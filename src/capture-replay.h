@@ -0,0 +1,76 @@
+/*
+Audoo-phase-meter for OBS
+Copyright (C) 2025 you214 https://github.com/you214
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along
+with this program. If not, see <https://www.gnu.org/licenses/>
+*/
+
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <string>
+
+#include "capture-format.h"
+#include "mapped-file.h"
+
+// スロットとソースの対応（記録時のUUIDと名前）
+struct ReplaySource {
+	int slot;
+	std::string uuid;
+	std::string name;
+};
+
+// 記録された音声ブロック（マップしたファイルを直接指す。再生中のみ有効）
+struct ReplayBlock {
+	int slot;
+	uint64_t timestampNs;
+	size_t frames;
+	const float *left;
+	const float *right;
+};
+
+// CaptureRecorderが書いたファイルを記録順に再生する
+// 同じファイルからは常に同じ順序・同じ区切りでブロックが渡される
+class CaptureReplay {
+public:
+	enum class Pace {
+		Unthrottled, // 待たずに流す（解析のプロファイル・再現用）
+		RealTime,    // タイムスタンプの間隔どおりに流す（ドックで見る用）
+	};
+
+	using SourceFn = std::function<void(const ReplaySource &)>;
+	using BlockFn = std::function<bool(const ReplayBlock &)>; // falseを返すと中断
+
+	// ファイルを開いて形式を確かめる（失敗時はerrorに理由を入れてfalse）。パスはUTF-8
+	bool open(const std::string &path, std::string &error);
+	void close() { m_file.close(); }
+
+	uint32_t sampleRate() const { return m_sampleRate; }
+	uint64_t droppedBlocks() const { return m_droppedBlocks; }
+
+	// 最後まで流せたらtrue（onBlockがfalseを返すかstopが立ったらfalse）
+	bool play(Pace pace, const SourceFn &onSource, const BlockFn &onBlock,
+		  const std::atomic<bool> *stop = nullptr) const;
+
+	// RealTimeで、これより長く時刻が飛んだら待たずに続ける（記録の一時停止やシーンの切り替え）
+	static constexpr uint64_t MAX_GAP_NS = 1000000000ULL;
+
+private:
+	MappedFile m_file;
+	uint32_t m_sampleRate = 0;
+	uint64_t m_droppedBlocks = 0;
+};
@@ -0,0 +1,181 @@
+/*
+Audoo-phase-meter for OBS
+Copyright (C) 2025 you214 https://github.com/you214
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along
+with this program. If not, see <https://www.gnu.org/licenses/>
+*/
+
+#include "channel-matrix.h"
+#include "correlation-meter.h"
+#include "correlation-kernels.h"
+#include <algorithm>
+#include <cmath>
+
+static constexpr double SILENCE_ENERGY = 1e-15;
+
+const char *channelLabel(int channels, int index)
+{
+	static const char *const NUMBERS[ChannelMatrix::MAX_CHANNELS] = {"1", "2", "3", "4", "5", "6", "7", "8"};
+	static const char *const LAYOUT_2_1[] = {"L", "R", "LFE"};
+	static const char *const LAYOUT_4_0[] = {"L", "R", "C", "S"};
+	static const char *const LAYOUT_4_1[] = {"L", "R", "C", "LFE", "S"};
+	static const char *const LAYOUT_5_1[] = {"L", "R", "C", "LFE", "Ls", "Rs"};
+	static const char *const LAYOUT_7_1[] = {"L", "R", "C", "LFE", "Lb", "Rb", "Ls", "Rs"};
+
+	if (index < 0 || index >= ChannelMatrix::MAX_CHANNELS) {
+		return "?";
+	}
+	switch (channels) {
+	case 2:
+		return index < 2 ? LAYOUT_5_1[index] : NUMBERS[index];
+	case 3:
+		return index < 3 ? LAYOUT_2_1[index] : NUMBERS[index];
+	case 4:
+		return index < 4 ? LAYOUT_4_0[index] : NUMBERS[index];
+	case 5:
+		return index < 5 ? LAYOUT_4_1[index] : NUMBERS[index];
+	case 6:
+		return index < 6 ? LAYOUT_5_1[index] : NUMBERS[index];
+	case 8:
+		return LAYOUT_7_1[index];
+	default:
+		return NUMBERS[index];
+	}
+}
+
+int centerChannel(int channels)
+{
+	switch (channels) {
+	case 4:
+	case 5:
+	case 6:
+	case 8:
+		return 2;
+	default:
+		return -1;
+	}
+}
+
+void ChannelMatrix::configure(int channels, uint32_t sampleRate, double integrationMs)
+{
+	m_channels.store(std::clamp(channels, 0, MAX_CHANNELS), std::memory_order_relaxed);
+	const double tauFrames = std::max(integrationMs, 1.0) / 1000.0 * std::max<uint32_t>(sampleRate, 1);
+	m_decay = std::exp(-1.0 / tauFrames);
+	m_ema.fill(0.0);
+}
+
+void ChannelMatrix::process(const float *const *planes, int count, size_t frames)
+{
+	const int channels = std::min(count, m_channels.load(std::memory_order_relaxed));
+	if (channels < 3 || frames == 0) {
+		return;
+	}
+
+	// 区間ごとに全ペアを回す。区間の全平面がL1に載っている間に、同じ区間を何度も読み直す
+	const float *block[MAX_CHANNELS];
+	float row[MAX_CHANNELS];
+	for (size_t start = 0; start < frames; start += BLOCK_FRAMES) {
+		const size_t run = std::min(BLOCK_FRAMES, frames - start);
+		for (int c = 0; c < channels; ++c) {
+			block[c] = planes[c] + start;
+		}
+		// 行aはaと自分以降のチャンネルとの内積（上三角）
+		for (int a = 0; a < channels; ++a) {
+			dotProducts(block[a], block + a, channels - a, run, row);
+			for (int b = a; b < channels; ++b) {
+				m_totals[pairIndex(a, b)] += row[b - a];
+			}
+		}
+	}
+	m_totalFrames += frames;
+
+	// 累計を公開する（書き込み中はシーケンスが奇数）
+	const uint32_t seq = m_seq.load(std::memory_order_relaxed);
+	m_seq.store(seq + 1, std::memory_order_relaxed);
+	std::atomic_thread_fence(std::memory_order_release);
+	for (int a = 0; a < channels; ++a) {
+		for (int b = a; b < channels; ++b) {
+			const int index = pairIndex(a, b);
+			m_published[index].store(m_totals[index], std::memory_order_relaxed);
+		}
+	}
+	m_publishedFrames.store(m_totalFrames, std::memory_order_relaxed);
+	m_seq.store(seq + 2, std::memory_order_release);
+}
+
+bool ChannelMatrix::update()
+{
+	if (!enabled()) {
+		return false;
+	}
+
+	std::array<double, MAX_PAIRS> totals;
+	uint32_t before, after;
+	uint64_t totalFrames;
+	do {
+		before = m_seq.load(std::memory_order_acquire);
+		for (int index = 0; index < MAX_PAIRS; ++index) {
+			totals[index] = m_published[index].load(std::memory_order_relaxed);
+		}
+		totalFrames = m_publishedFrames.load(std::memory_order_relaxed);
+		std::atomic_thread_fence(std::memory_order_acquire);
+		after = m_seq.load(std::memory_order_relaxed);
+	} while ((before & 1) || before != after);
+
+	const uint64_t frames = totalFrames - m_takenFrames;
+	if (frames == 0) {
+		return false;
+	}
+
+	// まとめて届いた分は区間内で一様だったとみなし、区間の重みの平均を掛けて加える
+	const double decay = std::pow(m_decay, static_cast<double>(frames));
+	const double weight = (1.0 - decay) / (static_cast<double>(frames) * (1.0 - m_decay));
+	for (int index = 0; index < MAX_PAIRS; ++index) {
+		m_ema[index] = decay * m_ema[index] + weight * (totals[index] - m_taken[index]);
+	}
+	m_taken = totals;
+	m_takenFrames = totalFrames;
+	return true;
+}
+
+double ChannelMatrix::correlation(int a, int b) const
+{
+	const int channels = this->channels();
+	if (a < 0 || b < 0 || a >= channels || b >= channels) {
+		return 0.0;
+	}
+	return CorrelationSums{sum(a, b), sum(a, a), sum(b, b)}.correlation();
+}
+
+double ChannelMatrix::phantomCenter() const
+{
+	const int center = centerChannel(channels());
+	if (center < 0) {
+		return 0.0;
+	}
+	// Σ C(L+R) = ΣCL + ΣCR、Σ(L+R)² = ΣL² + 2ΣLR + ΣR²
+	return CorrelationSums{sum(0, center) + sum(1, center), sum(center, center),
+			       sum(0, 0) + 2.0 * sum(0, 1) + sum(1, 1)}
+		.correlation();
+}
+
+double ChannelMatrix::levelDb(int channel) const
+{
+	if (channel < 0 || channel >= channels()) {
+		return LEVEL_FLOOR_DB;
+	}
+	// 指数積分の重みの合計は1 / (1 - decay)
+	const double power = sum(channel, channel) * (1.0 - m_decay);
+	return power > SILENCE_ENERGY ? std::max(10.0 * std::log10(power), LEVEL_FLOOR_DB) : LEVEL_FLOOR_DB;
+}
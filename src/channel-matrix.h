@@ -0,0 +1,81 @@
+/*
+Audoo-phase-meter for OBS
+Copyright (C) 2025 you214 https://github.com/you214
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along
+with this program. If not, see <https://www.gnu.org/licenses/>
+*/
+
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+// OBSのスピーカー配置はチャンネル数で決まるので、名前もチャンネル数から引く
+// 並びはlibobsのspeaker_layoutと同じ（5.1: L R C LFE Ls Rs、7.1: L R C LFE Lb Rb Ls Rs）
+const char *channelLabel(int channels, int index);
+// 中央チャンネルの位置（無ければ-1）
+int centerChannel(int channels);
+
+// 多チャンネル音声の全ペアの相関行列
+// 音声スレッドは平面ごとのバッファをBLOCK_FRAMESずつ区切り、L1に載った区間で全ペアの積和を取る。
+// 各平面はメモリから1回しか読まないので、8チャンネルでも負荷はバッファを1回読む程度で済む。
+// 対角（ΣX²）も同じ積和の表に持つので、正規化やファントムセンター（C対L+R）は表の組み合わせで求まる
+// 生産者（音声コールバック）と消費者（解析スレッド）はそれぞれ1つだけ
+class ChannelMatrix {
+public:
+	static constexpr int MAX_CHANNELS = 8;
+	static constexpr int MAX_PAIRS = MAX_CHANNELS * (MAX_CHANNELS + 1) / 2;
+	static constexpr size_t BLOCK_FRAMES = 256; // 8チャンネルで8KB
+
+	// チャンネル数（3未満なら何もしない）と積分時間を設定する。チャンネル数はOBSの再起動まで変わらない
+	void configure(int channels, uint32_t sampleRate, double integrationMs);
+	int channels() const { return m_channels.load(std::memory_order_relaxed); }
+	bool enabled() const { return channels() >= 3; }
+
+	// 生産者側: planes[0..count)のブロックを積算する（バッファは読むだけ）
+	void process(const float *const *planes, int count, size_t frames);
+
+	// 消費者側: 前回から増えた積和を指数積分へ反映する。増えていればtrue
+	bool update();
+
+	// 消費者側: 積分した相関（-1〜+1、無音なら0）とレベル（dBFS）
+	double correlation(int a, int b) const;
+	double phantomCenter() const; // Cと(L+R)の相関（中央チャンネルが無ければ0）
+	double levelDb(int channel) const;
+
+	// 積和の表の位置（a <= b。チャンネル数によらず同じ位置）
+	static constexpr int pairIndex(int a, int b) { return a * (2 * MAX_CHANNELS - a + 1) / 2 + (b - a); }
+
+	static constexpr double LEVEL_FLOOR_DB = -120.0;
+
+private:
+	double sum(int a, int b) const { return a <= b ? m_ema[pairIndex(a, b)] : m_ema[pairIndex(b, a)]; }
+
+	std::atomic<int> m_channels{0};
+
+	// 積和の累計（生産者だけが書き、シーケンスロックで公開する）
+	std::array<double, MAX_PAIRS> m_totals = {};
+	uint64_t m_totalFrames = 0;
+	std::atomic<uint32_t> m_seq{0};
+	std::array<std::atomic<double>, MAX_PAIRS> m_published = {};
+	std::atomic<uint64_t> m_publishedFrames{0};
+
+	// 消費者側
+	std::array<double, MAX_PAIRS> m_taken = {};
+	uint64_t m_takenFrames = 0;
+	std::array<double, MAX_PAIRS> m_ema = {};
+	double m_decay = 0.0; // 1フレームあたりの減衰
+};
@@ -0,0 +1,251 @@
+/*
+Audoo-phase-meter for OBS
+Copyright (C) 2025 you214 https://github.com/you214
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along
+with this program. If not, see <https://www.gnu.org/licenses/>
+*/
+
+
+#include "correlation-history.h"
+#include "correlation-kernels.h"
+#include <algorithm>
+#include <cmath>
+
+namespace {
+
+void mergeRange(HistoryRange &range, const HistoryRange &other)
+{
+	range.min = std::min(range.min, other.min);
+	range.max = std::max(range.max, other.max);
+}
+
+float toDb(double power, float floorDb)
+{
+	return power > 1e-20 ? std::max(floorDb, static_cast<float>(10.0 * std::log10(power))) : floorDb;
+}
+
+HistoryRange single(float value)
+{
+	return HistoryRange{value, value, value};
+}
+
+} // namespace
+
+void CorrelationHistory::Accumulator::add(const HistoryPoint &point, uint64_t pointWeight)
+{
+	Accumulator other;
+	other.range = point;
+	other.correlationSum = static_cast<double>(point.correlation.mean) * pointWeight;
+	other.widthSum = static_cast<double>(point.width.mean) * pointWeight;
+	other.levelSum = static_cast<double>(point.level.mean) * pointWeight;
+	other.weight = pointWeight;
+	merge(other);
+}
+
+void CorrelationHistory::Accumulator::merge(const Accumulator &other)
+{
+	if (other.weight == 0) {
+		return;
+	}
+	if (weight == 0) {
+		*this = other;
+		return;
+	}
+
+	mergeRange(range.correlation, other.range.correlation);
+	mergeRange(range.width, other.range.width);
+	mergeRange(range.level, other.range.level);
+	correlationSum += other.correlationSum;
+	widthSum += other.widthSum;
+	levelSum += other.levelSum;
+	weight += other.weight;
+}
+
+HistoryPoint CorrelationHistory::Accumulator::result() const
+{
+	HistoryPoint point = range;
+	if (weight > 0) {
+		point.correlation.mean = static_cast<float>(correlationSum / weight);
+		point.width.mean = static_cast<float>(widthSum / weight);
+		point.level.mean = static_cast<float>(levelSum / weight);
+	}
+	return point;
+}
+
+uint64_t CorrelationHistory::scale(size_t level)
+{
+	uint64_t points = 1;
+	for (size_t i = 0; i < level; ++i) {
+		points *= DECIMATION;
+	}
+	return points;
+}
+
+double CorrelationHistory::retainedSeconds()
+{
+	return static_cast<double>(LEVEL_CAPACITY * scale(LEVELS - 1)) * BASE_INTERVAL_MS / 1000.0;
+}
+
+void CorrelationHistory::configure(uint32_t sampleRate)
+{
+	if (sampleRate == m_sampleRate && !m_levels.empty()) {
+		return;
+	}
+
+	m_sampleRate = sampleRate;
+	m_pointFrames = std::max<size_t>(1, static_cast<size_t>(sampleRate * BASE_INTERVAL_MS / 1000.0));
+	m_levels.resize(LEVELS);
+	for (Level &level : m_levels) {
+		level.ring.assign(LEVEL_CAPACITY, HistoryPoint());
+	}
+	reset();
+}
+
+void CorrelationHistory::reset()
+{
+	for (Level &level : m_levels) {
+		level.written = 0;
+		level.pending = Accumulator();
+	}
+	m_framesInPoint = 0;
+	m_sums = CorrelationSums();
+}
+
+void CorrelationHistory::process(const float *left, const float *right, size_t frames)
+{
+	if (m_levels.empty()) {
+		return;
+	}
+
+	while (frames > 0) {
+		const size_t count = std::min(frames, m_pointFrames - m_framesInPoint);
+		m_sums += correlationSums(left, right, count);
+		m_framesInPoint += count;
+		left += count;
+		right += count;
+		frames -= count;
+
+		if (m_framesInPoint == m_pointFrames) {
+			commitPoint();
+		}
+	}
+}
+
+void CorrelationHistory::processSums(const CorrelationSums &sums, size_t frames)
+{
+	if (m_levels.empty()) {
+		return;
+	}
+
+	size_t remaining = frames;
+	while (remaining > 0) {
+		const size_t count = std::min(remaining, m_pointFrames - m_framesInPoint);
+		m_sums += sums.scaled(static_cast<double>(count) / frames);
+		m_framesInPoint += count;
+		remaining -= count;
+
+		if (m_framesInPoint == m_pointFrames) {
+			commitPoint();
+		}
+	}
+}
+
+void CorrelationHistory::commitPoint()
+{
+	HistoryPoint point;
+	point.correlation = single(static_cast<float>(m_sums.correlation()));
+	point.width = single(static_cast<float>(m_sums.widthDb()));
+	point.level = single(toDb((m_sums.ll + m_sums.rr) * 0.5 / m_framesInPoint, LEVEL_FLOOR_DB));
+
+	m_framesInPoint = 0;
+	m_sums = CorrelationSums();
+	pushLevel(0, point);
+}
+
+void CorrelationHistory::pushLevel(size_t level, const HistoryPoint &point)
+{
+	Level &current = m_levels[level];
+	current.ring[current.written & (LEVEL_CAPACITY - 1)] = point;
+	current.written++;
+
+	// DECIMATION点たまったら1つ上の段へ1点として送る
+	if (level + 1 < LEVELS) {
+		Level &upper = m_levels[level + 1];
+		upper.pending.add(point, scale(level));
+		if (upper.pending.weight == scale(level + 1)) {
+			const HistoryPoint merged = upper.pending.result();
+			upper.pending = Accumulator();
+			pushLevel(level + 1, merged);
+		}
+	}
+}
+
+CorrelationHistory::Accumulator CorrelationHistory::pendingTail(size_t level) const
+{
+	// level段の未確定分は、その段と下の各段で束ね途中の点を合わせたもの
+	Accumulator tail;
+	for (size_t i = 1; i <= level; ++i) {
+		tail.merge(m_levels[i].pending);
+	}
+	return tail;
+}
+
+size_t CorrelationHistory::read(uint64_t pointsPerColumn, size_t columns, HistoryPoint *out) const
+{
+	const uint64_t total = points();
+	if (pointsPerColumn == 0 || columns == 0 || total == 0) {
+		return 0;
+	}
+
+	// 1列に数点で済む最も細かい段を選び、表示範囲を保持していなければ粗い段へ上げる
+	const uint64_t span = pointsPerColumn * columns;
+	size_t level = 0;
+	while (level + 1 < LEVELS && scale(level + 1) <= pointsPerColumn) {
+		level++;
+	}
+	while (level + 1 < LEVELS && LEVEL_CAPACITY * scale(level) < span) {
+		level++;
+	}
+
+	const Level &source = m_levels[level];
+	const uint64_t pointScale = scale(level);
+	const uint64_t oldest = source.written > LEVEL_CAPACITY ? source.written - LEVEL_CAPACITY : 0;
+	const Accumulator tail = pendingTail(level); // 通し番号source.writtenの点として扱う
+
+	const uint64_t lastColumn = (total - 1) / pointsPerColumn;
+	const uint64_t firstColumn = lastColumn + 1 > columns ? lastColumn + 1 - columns : 0;
+
+	size_t count = 0;
+	for (uint64_t column = firstColumn; column <= lastColumn; ++column) {
+		const uint64_t from = std::max(column * pointsPerColumn / pointScale, oldest);
+		const uint64_t to = std::min(((column + 1) * pointsPerColumn - 1) / pointScale, source.written);
+
+		Accumulator merged;
+		for (uint64_t index = from; index <= to; ++index) {
+			if (index == source.written) {
+				merged.merge(tail);
+			} else {
+				merged.add(source.ring[index & (LEVEL_CAPACITY - 1)], pointScale);
+			}
+		}
+
+		// 古い側は履歴が残っていない列が続くので、最初に中身のある列から詰めて書く
+		if (merged.weight > 0) {
+			out[count++] = merged.result();
+		} else if (count > 0) {
+			break;
+		}
+	}
+	return count;
+}
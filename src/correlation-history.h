@@ -0,0 +1,106 @@
+/*
+Audoo-phase-meter for OBS
+Copyright (C) 2025 you214 https://github.com/you214
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along
+with this program. If not, see <https://www.gnu.org/licenses/>
+*/
+
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "correlation-meter.h"
+
+// 履歴の1点（またはそれを束ねた区間）の最小・最大・平均
+struct HistoryRange {
+	float min = 0.0f;
+	float max = 0.0f;
+	float mean = 0.0f;
+};
+
+struct HistoryPoint {
+	HistoryRange correlation; // -1〜+1
+	HistoryRange width;       // M/Sのエネルギー比（dB、CorrelationSums::widthDb()）
+	HistoryRange level;       // L/R平均のRMS（dBFS、LEVEL_FLOOR_DBで打ち切り）
+};
+
+// 相関・ステレオ幅・レベルの長時間履歴
+// 基本間隔ごとの点を段ごとにDECIMATION個ずつ束ねたmin/max/meanのピラミッドで持つ。各段は固定長のリングなので、
+// 何時間動かしてもメモリは一定で、どの拡大率でも表示1列あたり数点を読むだけで描ける
+// 時間軸は取り出した音声のサンプル数で進む（監視を止めていた間は詰まる）。解析スレッドのみが触る
+class CorrelationHistory {
+public:
+	CorrelationHistory() = default;
+
+	// サンプルレートが変わったときだけ履歴を捨てて作り直す
+	void configure(uint32_t sampleRate);
+	void reset();
+
+	void process(const float *left, const float *right, size_t frames);
+	// サンプルの代わりにframes分の積和をまとめて加える（基本点にはフレーム数で按分する）
+	void processSums(const CorrelationSums &sums, size_t frames);
+
+	// 確定した基本点の累計（表示の更新判定に使う）
+	uint64_t points() const { return m_levels.empty() ? 0 : m_levels[0].written; }
+
+	// 1列を基本点pointsPerColumn個とし、最新の列を右端としてcolumns列分を古い順にoutへ書く
+	// 列の境目は基本点の通し番号に揃えるので、流れても列の中身は揺れない。書けた（履歴が残っている）列数を返す
+	size_t read(uint64_t pointsPerColumn, size_t columns, HistoryPoint *out) const;
+
+	// 保持できる最長の時間（最上段のリングが満杯のとき）
+	static double retainedSeconds();
+
+	static constexpr double BASE_INTERVAL_MS = 10.0;
+	static constexpr size_t DECIMATION = 4;
+	static constexpr size_t LEVELS = 8;            // 10ms × 4^7 × 2048 ≒ 93時間
+	static constexpr size_t LEVEL_CAPACITY = 2048; // 各段のリング長（2の冪）
+	static constexpr float LEVEL_FLOOR_DB = -120.0f;
+
+private:
+	// 束ねている途中の区間（平均は基本点数で重み付けする）
+	struct Accumulator {
+		HistoryPoint range;
+		double correlationSum = 0.0;
+		double widthSum = 0.0;
+		double levelSum = 0.0;
+		uint64_t weight = 0;
+
+		void add(const HistoryPoint &point, uint64_t pointWeight);
+		void merge(const Accumulator &other);
+		HistoryPoint result() const;
+	};
+
+	struct Level {
+		std::vector<HistoryPoint> ring;
+		uint64_t written = 0;
+		Accumulator pending; // 下の段から届いた、まだDECIMATION個に満たない点
+	};
+
+	// level段の1点が束ねる基本点の数（DECIMATION^level）
+	static uint64_t scale(size_t level);
+
+	void commitPoint();
+	void pushLevel(size_t level, const HistoryPoint &point);
+	// level段の未確定分（下の段の未確定分も含む）。無ければweight == 0
+	Accumulator pendingTail(size_t level) const;
+
+	uint32_t m_sampleRate = 0;
+	size_t m_pointFrames = 0;
+	size_t m_framesInPoint = 0;
+	CorrelationSums m_sums;
+	std::vector<Level> m_levels;
+};
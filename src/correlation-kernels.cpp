@@ -0,0 +1,484 @@
+/*
+Audoo-phase-meter for OBS
+Copyright (C) 2025 you214 https://github.com/you214
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along
+with this program. If not, see <https://www.gnu.org/licenses/>
+*/
+
+#include "correlation-kernels.h"
+#include <algorithm>
+#include <cstdint>
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define PM_KERNELS_X86 1
+#include <immintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#else
+#include <cpuid.h>
+#endif
+#endif
+
+// MSVCは関数単位のターゲット指定なしで全ISAの組み込み関数を使える
+#if defined(PM_KERNELS_X86) && !defined(_MSC_VER)
+#define PM_TARGET_AVX2 __attribute__((target("avx2")))
+#define PM_TARGET_AVX512 __attribute__((target("avx512f")))
+#else
+#define PM_TARGET_AVX2
+#define PM_TARGET_AVX512
+#endif
+
+static CorrelationSums sums_scalar(const float *left, const float *right, size_t frames)
+{
+	CorrelationSums result;
+
+	for (size_t start = 0; start < frames; start += KERNEL_BLOCK_FRAMES) {
+		const size_t end = std::min(frames, start + KERNEL_BLOCK_FRAMES);
+		float lr = 0.0f, ll = 0.0f, rr = 0.0f;
+
+		for (size_t i = start; i < end; ++i) {
+			const float l = left[i];
+			const float r = right[i];
+			lr += l * r;
+			ll += l * l;
+			rr += r * r;
+		}
+
+		result.lr += lr;
+		result.ll += ll;
+		result.rr += rr;
+	}
+
+	return result;
+}
+
+static void dots_scalar(const float *x, const float *const *ys, int count, size_t frames, float *out)
+{
+	for (int k = 0; k < count; ++k) {
+		const float *y = ys[k];
+		float sum = 0.0f;
+		for (size_t i = 0; i < frames; ++i) {
+			sum += x[i] * y[i];
+		}
+		out[k] = sum;
+	}
+}
+
+// 内積を4本ずつまとめて回す。足りない分は最後の平面を重ねて読み、結果は捨てる
+// 4本の依存チェーンが並行に進むので、加算のレイテンシで詰まらない
+static inline void dot_group(const float *const *ys, int k, int count, const float *g[4])
+{
+	for (int j = 0; j < 4; ++j) {
+		g[j] = ys[std::min(k + j, count - 1)];
+	}
+}
+
+static inline void dot_tail(const float *x, const float *const g[4], size_t start, size_t frames, float sums[4])
+{
+	for (size_t i = start; i < frames; ++i) {
+		for (int j = 0; j < 4; ++j) {
+			sums[j] += x[i] * g[j][i];
+		}
+	}
+}
+
+#ifdef PM_KERNELS_X86
+
+static inline double hsum128(__m128 v)
+{
+	alignas(16) float lanes[4];
+	_mm_store_ps(lanes, v);
+	return (static_cast<double>(lanes[0]) + lanes[1]) + (static_cast<double>(lanes[2]) + lanes[3]);
+}
+
+static CorrelationSums sums_sse2(const float *left, const float *right, size_t frames)
+{
+	CorrelationSums result;
+	size_t i = 0;
+
+	while (i + 8 <= frames) {
+		const size_t end = std::min(frames, i + KERNEL_BLOCK_FRAMES) & ~static_cast<size_t>(7);
+		__m128 lr0 = _mm_setzero_ps(), ll0 = _mm_setzero_ps(), rr0 = _mm_setzero_ps();
+		__m128 lr1 = _mm_setzero_ps(), ll1 = _mm_setzero_ps(), rr1 = _mm_setzero_ps();
+
+		// 依存チェーンを分けるため2本のアキュムレータで交互に積算する
+		for (; i < end; i += 8) {
+			const __m128 l0 = _mm_loadu_ps(left + i);
+			const __m128 r0 = _mm_loadu_ps(right + i);
+			const __m128 l1 = _mm_loadu_ps(left + i + 4);
+			const __m128 r1 = _mm_loadu_ps(right + i + 4);
+			lr0 = _mm_add_ps(lr0, _mm_mul_ps(l0, r0));
+			ll0 = _mm_add_ps(ll0, _mm_mul_ps(l0, l0));
+			rr0 = _mm_add_ps(rr0, _mm_mul_ps(r0, r0));
+			lr1 = _mm_add_ps(lr1, _mm_mul_ps(l1, r1));
+			ll1 = _mm_add_ps(ll1, _mm_mul_ps(l1, l1));
+			rr1 = _mm_add_ps(rr1, _mm_mul_ps(r1, r1));
+		}
+
+		result.lr += hsum128(_mm_add_ps(lr0, lr1));
+		result.ll += hsum128(_mm_add_ps(ll0, ll1));
+		result.rr += hsum128(_mm_add_ps(rr0, rr1));
+	}
+
+	result += sums_scalar(left + i, right + i, frames - i);
+	return result;
+}
+
+// 4本の積算結果を転置して足し合わせ、4本の内積を1本のベクトルで返す
+static inline __m128 hsum4x128(__m128 s0, __m128 s1, __m128 s2, __m128 s3)
+{
+	_MM_TRANSPOSE4_PS(s0, s1, s2, s3);
+	return _mm_add_ps(_mm_add_ps(s0, s1), _mm_add_ps(s2, s3));
+}
+
+static void dots_sse2(const float *x, const float *const *ys, int count, size_t frames, float *out)
+{
+	const size_t vectorFrames = frames & ~static_cast<size_t>(7);
+	for (int k = 0; k < count; k += 4) {
+		const float *g[4];
+		dot_group(ys, k, count, g);
+		// 8フレームずつ2本に分けて、依存チェーンを8本にする
+		__m128 a0 = _mm_setzero_ps(), a1 = _mm_setzero_ps(), a2 = _mm_setzero_ps(), a3 = _mm_setzero_ps();
+		__m128 b0 = _mm_setzero_ps(), b1 = _mm_setzero_ps(), b2 = _mm_setzero_ps(), b3 = _mm_setzero_ps();
+		for (size_t i = 0; i < vectorFrames; i += 8) {
+			const __m128 u = _mm_loadu_ps(x + i);
+			const __m128 v = _mm_loadu_ps(x + i + 4);
+			a0 = _mm_add_ps(a0, _mm_mul_ps(u, _mm_loadu_ps(g[0] + i)));
+			a1 = _mm_add_ps(a1, _mm_mul_ps(u, _mm_loadu_ps(g[1] + i)));
+			a2 = _mm_add_ps(a2, _mm_mul_ps(u, _mm_loadu_ps(g[2] + i)));
+			a3 = _mm_add_ps(a3, _mm_mul_ps(u, _mm_loadu_ps(g[3] + i)));
+			b0 = _mm_add_ps(b0, _mm_mul_ps(v, _mm_loadu_ps(g[0] + i + 4)));
+			b1 = _mm_add_ps(b1, _mm_mul_ps(v, _mm_loadu_ps(g[1] + i + 4)));
+			b2 = _mm_add_ps(b2, _mm_mul_ps(v, _mm_loadu_ps(g[2] + i + 4)));
+			b3 = _mm_add_ps(b3, _mm_mul_ps(v, _mm_loadu_ps(g[3] + i + 4)));
+		}
+		float sums[4];
+		_mm_storeu_ps(sums, hsum4x128(_mm_add_ps(a0, b0), _mm_add_ps(a1, b1), _mm_add_ps(a2, b2),
+					      _mm_add_ps(a3, b3)));
+		dot_tail(x, g, vectorFrames, frames, sums);
+		for (int j = 0; j < 4 && k + j < count; ++j) {
+			out[k + j] = sums[j];
+		}
+	}
+}
+
+PM_TARGET_AVX2 static inline double hsum256(__m256 v)
+{
+	alignas(32) float lanes[8];
+	_mm256_store_ps(lanes, v);
+	double sum = 0.0;
+	for (float lane : lanes) {
+		sum += lane;
+	}
+	return sum;
+}
+
+PM_TARGET_AVX2 static CorrelationSums sums_avx2(const float *left, const float *right, size_t frames)
+{
+	CorrelationSums result;
+	size_t i = 0;
+
+	while (i + 16 <= frames) {
+		const size_t end = std::min(frames, i + KERNEL_BLOCK_FRAMES) & ~static_cast<size_t>(15);
+		__m256 lr0 = _mm256_setzero_ps(), ll0 = _mm256_setzero_ps(), rr0 = _mm256_setzero_ps();
+		__m256 lr1 = _mm256_setzero_ps(), ll1 = _mm256_setzero_ps(), rr1 = _mm256_setzero_ps();
+
+		for (; i < end; i += 16) {
+			const __m256 l0 = _mm256_loadu_ps(left + i);
+			const __m256 r0 = _mm256_loadu_ps(right + i);
+			const __m256 l1 = _mm256_loadu_ps(left + i + 8);
+			const __m256 r1 = _mm256_loadu_ps(right + i + 8);
+			lr0 = _mm256_add_ps(lr0, _mm256_mul_ps(l0, r0));
+			ll0 = _mm256_add_ps(ll0, _mm256_mul_ps(l0, l0));
+			rr0 = _mm256_add_ps(rr0, _mm256_mul_ps(r0, r0));
+			lr1 = _mm256_add_ps(lr1, _mm256_mul_ps(l1, r1));
+			ll1 = _mm256_add_ps(ll1, _mm256_mul_ps(l1, l1));
+			rr1 = _mm256_add_ps(rr1, _mm256_mul_ps(r1, r1));
+		}
+
+		result.lr += hsum256(_mm256_add_ps(lr0, lr1));
+		result.ll += hsum256(_mm256_add_ps(ll0, ll1));
+		result.rr += hsum256(_mm256_add_ps(rr0, rr1));
+	}
+
+	result += sums_sse2(left + i, right + i, frames - i);
+	return result;
+}
+
+PM_TARGET_AVX2 static inline __m128 hsum4x256(__m256 s0, __m256 s1, __m256 s2, __m256 s3)
+{
+	const __m256 pairs = _mm256_hadd_ps(_mm256_hadd_ps(s0, s1), _mm256_hadd_ps(s2, s3));
+	return _mm_add_ps(_mm256_castps256_ps128(pairs), _mm256_extractf128_ps(pairs, 1));
+}
+
+PM_TARGET_AVX2 static void dots_avx2(const float *x, const float *const *ys, int count, size_t frames, float *out)
+{
+	const size_t vectorFrames = frames & ~static_cast<size_t>(15);
+	for (int k = 0; k < count; k += 4) {
+		const float *g[4];
+		dot_group(ys, k, count, g);
+		__m256 a0 = _mm256_setzero_ps(), a1 = _mm256_setzero_ps(), a2 = _mm256_setzero_ps();
+		__m256 a3 = _mm256_setzero_ps(), b0 = _mm256_setzero_ps(), b1 = _mm256_setzero_ps();
+		__m256 b2 = _mm256_setzero_ps(), b3 = _mm256_setzero_ps();
+		for (size_t i = 0; i < vectorFrames; i += 16) {
+			const __m256 u = _mm256_loadu_ps(x + i);
+			const __m256 v = _mm256_loadu_ps(x + i + 8);
+			a0 = _mm256_add_ps(a0, _mm256_mul_ps(u, _mm256_loadu_ps(g[0] + i)));
+			a1 = _mm256_add_ps(a1, _mm256_mul_ps(u, _mm256_loadu_ps(g[1] + i)));
+			a2 = _mm256_add_ps(a2, _mm256_mul_ps(u, _mm256_loadu_ps(g[2] + i)));
+			a3 = _mm256_add_ps(a3, _mm256_mul_ps(u, _mm256_loadu_ps(g[3] + i)));
+			b0 = _mm256_add_ps(b0, _mm256_mul_ps(v, _mm256_loadu_ps(g[0] + i + 8)));
+			b1 = _mm256_add_ps(b1, _mm256_mul_ps(v, _mm256_loadu_ps(g[1] + i + 8)));
+			b2 = _mm256_add_ps(b2, _mm256_mul_ps(v, _mm256_loadu_ps(g[2] + i + 8)));
+			b3 = _mm256_add_ps(b3, _mm256_mul_ps(v, _mm256_loadu_ps(g[3] + i + 8)));
+		}
+		float sums[4];
+		_mm_storeu_ps(sums, hsum4x256(_mm256_add_ps(a0, b0), _mm256_add_ps(a1, b1), _mm256_add_ps(a2, b2),
+					      _mm256_add_ps(a3, b3)));
+		dot_tail(x, g, vectorFrames, frames, sums);
+		for (int j = 0; j < 4 && k + j < count; ++j) {
+			out[k + j] = sums[j];
+		}
+	}
+}
+
+PM_TARGET_AVX512 static inline double hsum512(__m512 v)
+{
+	alignas(64) float lanes[16];
+	_mm512_store_ps(lanes, v);
+	double sum = 0.0;
+	for (float lane : lanes) {
+		sum += lane;
+	}
+	return sum;
+}
+
+PM_TARGET_AVX512 static CorrelationSums sums_avx512(const float *left, const float *right, size_t frames)
+{
+	CorrelationSums result;
+	size_t i = 0;
+
+	while (i + 32 <= frames) {
+		const size_t end = std::min(frames, i + KERNEL_BLOCK_FRAMES) & ~static_cast<size_t>(31);
+		__m512 lr0 = _mm512_setzero_ps(), ll0 = _mm512_setzero_ps(), rr0 = _mm512_setzero_ps();
+		__m512 lr1 = _mm512_setzero_ps(), ll1 = _mm512_setzero_ps(), rr1 = _mm512_setzero_ps();
+
+		for (; i < end; i += 32) {
+			const __m512 l0 = _mm512_loadu_ps(left + i);
+			const __m512 r0 = _mm512_loadu_ps(right + i);
+			const __m512 l1 = _mm512_loadu_ps(left + i + 16);
+			const __m512 r1 = _mm512_loadu_ps(right + i + 16);
+			lr0 = _mm512_add_ps(lr0, _mm512_mul_ps(l0, r0));
+			ll0 = _mm512_add_ps(ll0, _mm512_mul_ps(l0, l0));
+			rr0 = _mm512_add_ps(rr0, _mm512_mul_ps(r0, r0));
+			lr1 = _mm512_add_ps(lr1, _mm512_mul_ps(l1, r1));
+			ll1 = _mm512_add_ps(ll1, _mm512_mul_ps(l1, l1));
+			rr1 = _mm512_add_ps(rr1, _mm512_mul_ps(r1, r1));
+		}
+
+		result.lr += hsum512(_mm512_add_ps(lr0, lr1));
+		result.ll += hsum512(_mm512_add_ps(ll0, ll1));
+		result.rr += hsum512(_mm512_add_ps(rr0, rr1));
+	}
+
+	result += sums_sse2(left + i, right + i, frames - i);
+	return result;
+}
+
+PM_TARGET_AVX512 static inline __m256 fold512(__m512 v)
+{
+	alignas(64) float lanes[16];
+	_mm512_store_ps(lanes, v);
+	return _mm256_add_ps(_mm256_load_ps(lanes), _mm256_load_ps(lanes + 8));
+}
+
+PM_TARGET_AVX512 static void dots_avx512(const float *x, const float *const *ys, int count, size_t frames,
+					 float *out)
+{
+	const size_t vectorFrames = frames & ~static_cast<size_t>(31);
+	for (int k = 0; k < count; k += 4) {
+		const float *g[4];
+		dot_group(ys, k, count, g);
+		__m512 a0 = _mm512_setzero_ps(), a1 = _mm512_setzero_ps(), a2 = _mm512_setzero_ps();
+		__m512 a3 = _mm512_setzero_ps(), b0 = _mm512_setzero_ps(), b1 = _mm512_setzero_ps();
+		__m512 b2 = _mm512_setzero_ps(), b3 = _mm512_setzero_ps();
+		for (size_t i = 0; i < vectorFrames; i += 32) {
+			const __m512 u = _mm512_loadu_ps(x + i);
+			const __m512 v = _mm512_loadu_ps(x + i + 16);
+			a0 = _mm512_add_ps(a0, _mm512_mul_ps(u, _mm512_loadu_ps(g[0] + i)));
+			a1 = _mm512_add_ps(a1, _mm512_mul_ps(u, _mm512_loadu_ps(g[1] + i)));
+			a2 = _mm512_add_ps(a2, _mm512_mul_ps(u, _mm512_loadu_ps(g[2] + i)));
+			a3 = _mm512_add_ps(a3, _mm512_mul_ps(u, _mm512_loadu_ps(g[3] + i)));
+			b0 = _mm512_add_ps(b0, _mm512_mul_ps(v, _mm512_loadu_ps(g[0] + i + 16)));
+			b1 = _mm512_add_ps(b1, _mm512_mul_ps(v, _mm512_loadu_ps(g[1] + i + 16)));
+			b2 = _mm512_add_ps(b2, _mm512_mul_ps(v, _mm512_loadu_ps(g[2] + i + 16)));
+			b3 = _mm512_add_ps(b3, _mm512_mul_ps(v, _mm512_loadu_ps(g[3] + i + 16)));
+		}
+		float sums[4];
+		_mm_storeu_ps(sums, hsum4x256(fold512(_mm512_add_ps(a0, b0)), fold512(_mm512_add_ps(a1, b1)),
+					      fold512(_mm512_add_ps(a2, b2)), fold512(_mm512_add_ps(a3, b3))));
+		dot_tail(x, g, vectorFrames, frames, sums);
+		for (int j = 0; j < 4 && k + j < count; ++j) {
+			out[k + j] = sums[j];
+		}
+	}
+}
+
+static void cpuid(uint32_t leaf, uint32_t subleaf, uint32_t regs[4])
+{
+#if defined(_MSC_VER)
+	int info[4];
+	__cpuidex(info, static_cast<int>(leaf), static_cast<int>(subleaf));
+	for (int i = 0; i < 4; ++i) {
+		regs[i] = static_cast<uint32_t>(info[i]);
+	}
+#else
+	__cpuid_count(leaf, subleaf, regs[0], regs[1], regs[2], regs[3]);
+#endif
+}
+
+static uint64_t read_xcr0()
+{
+#if defined(_MSC_VER)
+	return _xgetbv(0);
+#else
+	uint32_t eax, edx;
+	__asm__ volatile("xgetbv" : "=a"(eax), "=d"(edx) : "c"(0));
+	return (static_cast<uint64_t>(edx) << 32) | eax;
+#endif
+}
+
+// CPUとOSの両方が対応している最上位のISAを返す
+static KernelIsa detect_isa()
+{
+	uint32_t regs[4];
+	cpuid(0, 0, regs);
+	const uint32_t maxLeaf = regs[0];
+
+	cpuid(1, 0, regs);
+	const bool sse2 = (regs[3] & (1u << 26)) != 0;
+	const bool osxsave = (regs[2] & (1u << 27)) != 0;
+	const bool avx = (regs[2] & (1u << 28)) != 0;
+
+	if (!sse2) {
+		return KernelIsa::Scalar;
+	}
+	if (!osxsave || !avx || maxLeaf < 7) {
+		return KernelIsa::SSE2;
+	}
+
+	// XMM/YMMの状態保存がOSで有効か、ZMMまで有効か
+	const uint64_t xcr0 = read_xcr0();
+	const bool ymmEnabled = (xcr0 & 0x6) == 0x6;
+	const bool zmmEnabled = (xcr0 & 0xE6) == 0xE6;
+
+	cpuid(7, 0, regs);
+	const bool avx2 = (regs[1] & (1u << 5)) != 0;
+	const bool avx512f = (regs[1] & (1u << 16)) != 0;
+
+	if (avx512f && zmmEnabled) {
+		return KernelIsa::AVX512;
+	}
+	if (avx2 && ymmEnabled) {
+		return KernelIsa::AVX2;
+	}
+	return KernelIsa::SSE2;
+}
+
+#else
+
+static KernelIsa detect_isa()
+{
+	return KernelIsa::Scalar;
+}
+
+#endif
+
+CorrelationKernel correlationKernelFor(KernelIsa isa)
+{
+	static const KernelIsa supported = detect_isa();
+	if (static_cast<int>(isa) > static_cast<int>(supported)) {
+		return nullptr;
+	}
+
+	switch (isa) {
+#ifdef PM_KERNELS_X86
+	case KernelIsa::AVX512:
+		return sums_avx512;
+	case KernelIsa::AVX2:
+		return sums_avx2;
+	case KernelIsa::SSE2:
+		return sums_sse2;
+#endif
+	case KernelIsa::Scalar:
+		return sums_scalar;
+	default:
+		return nullptr;
+	}
+}
+
+DotKernel dotKernelFor(KernelIsa isa)
+{
+	static const KernelIsa supported = detect_isa();
+	if (static_cast<int>(isa) > static_cast<int>(supported)) {
+		return nullptr;
+	}
+
+	switch (isa) {
+#ifdef PM_KERNELS_X86
+	case KernelIsa::AVX512:
+		return dots_avx512;
+	case KernelIsa::AVX2:
+		return dots_avx2;
+	case KernelIsa::SSE2:
+		return dots_sse2;
+#endif
+	case KernelIsa::Scalar:
+		return dots_scalar;
+	default:
+		return nullptr;
+	}
+}
+
+KernelIsa activeKernelIsa()
+{
+	static const KernelIsa active = detect_isa();
+	return active;
+}
+
+const char *kernelIsaName(KernelIsa isa)
+{
+	switch (isa) {
+	case KernelIsa::AVX512:
+		return "AVX-512";
+	case KernelIsa::AVX2:
+		return "AVX2";
+	case KernelIsa::SSE2:
+		return "SSE2";
+	default:
+		return "scalar";
+	}
+}
+
+CorrelationSums correlationSums(const float *left, const float *right, size_t frames)
+{
+	static const CorrelationKernel kernel = correlationKernelFor(activeKernelIsa());
+	return kernel(left, right, frames);
+}
+
+void dotProducts(const float *x, const float *const *ys, int count, size_t frames, float *out)
+{
+	static const DotKernel kernel = dotKernelFor(activeKernelIsa());
+	kernel(x, ys, count, frames, out);
+}
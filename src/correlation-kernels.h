@@ -0,0 +1,49 @@
+/*
+Audoo-phase-meter for OBS
+Copyright (C) 2025 you214 https://github.com/you214
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along
+with this program. If not, see <https://www.gnu.org/licenses/>
+*/
+
+#pragma once
+
+#include <cstddef>
+
+#include "correlation-meter.h"
+
+// ΣLR, ΣL², ΣR² を1パスで求めるカーネル
+// 各実装はKERNEL_BLOCK_FRAMESごとにfloatで積算してdoubleへ足し込むため、
+// 実装間の差は相対1e-5程度に収まる
+enum class KernelIsa { Scalar, SSE2, AVX2, AVX512 };
+
+using CorrelationKernel = CorrelationSums (*)(const float *left, const float *right, size_t frames);
+
+// 起動時にCPUIDで選んだ最速の実装で計算する
+CorrelationSums correlationSums(const float *left, const float *right, size_t frames);
+
+// 選択された実装
+KernelIsa activeKernelIsa();
+const char *kernelIsaName(KernelIsa isa);
+
+// 指定した実装を取得する（CPUやビルドが対応していなければnullptr）。ベンチマーク・検証用
+CorrelationKernel correlationKernelFor(KernelIsa isa);
+
+// xとys[0..count)それぞれの内積 Σx·y を1パスで求める（相関行列の1行分。xの読み込みを共有する）
+// floatのまま積算するので、framesはKERNEL_BLOCK_FRAMES以下で呼ぶこと
+using DotKernel = void (*)(const float *x, const float *const *ys, int count, size_t frames, float *out);
+
+void dotProducts(const float *x, const float *const *ys, int count, size_t frames, float *out);
+DotKernel dotKernelFor(KernelIsa isa);
+
+static constexpr size_t KERNEL_BLOCK_FRAMES = 1024;
@@ -0,0 +1,201 @@
+/*
+Audoo-phase-meter for OBS
+Copyright (C) 2025 you214 https://github.com/you214
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along
+with this program. If not, see <https://www.gnu.org/licenses/>
+*/
+
+#include "correlation-meter.h"
+#include "correlation-kernels.h"
+#include <algorithm>
+#include <cmath>
+
+// この値未満のエネルギーは無音とみなす（-150dBFS相当）
+static constexpr double SILENCE_ENERGY = 1e-15;
+
+double CorrelationSums::correlation() const
+{
+	if (ll <= SILENCE_ENERGY || rr <= SILENCE_ENERGY) {
+		return 0.0;
+	}
+	return std::clamp(lr / std::sqrt(ll * rr), -1.0, 1.0);
+}
+
+double CorrelationSums::widthDb() const
+{
+	const double mid = std::max(0.0, ll + rr + 2.0 * lr);
+	const double side = std::max(0.0, ll + rr - 2.0 * lr);
+	if (mid <= 1e-20 && side <= 1e-20) {
+		return 0.0;
+	}
+	if (mid <= 1e-20) {
+		return WIDTH_LIMIT_DB;
+	}
+	const double ratio = side / mid;
+	return ratio > 1e-20 ? std::clamp(10.0 * std::log10(ratio), -WIDTH_LIMIT_DB, WIDTH_LIMIT_DB) : -WIDTH_LIMIT_DB;
+}
+
+void CorrelationMeter::configure(uint32_t sampleRate, double integrationMs, Mode mode)
+{
+	m_sampleRate = std::max<uint32_t>(sampleRate, 1);
+	m_integrationMs = std::max(integrationMs, 1.0);
+	m_mode = mode;
+
+	const double windowFrames = m_sampleRate * m_integrationMs / 1000.0;
+	m_chunkFrames = std::max<size_t>(1, static_cast<size_t>(windowFrames / CHUNKS_PER_WINDOW));
+	m_chunks.assign(CHUNKS_PER_WINDOW, CorrelationSums());
+
+	// 時定数τの一次IIR: y[n] = a*y[n-1] + x[n]
+	m_decay = std::exp(-1.0 / windowFrames);
+	m_blockDecay = std::pow(m_decay, static_cast<double>(EXPONENTIAL_BLOCK_FRAMES));
+
+	reset();
+}
+
+void CorrelationMeter::reset()
+{
+	std::fill(m_chunks.begin(), m_chunks.end(), CorrelationSums());
+	m_chunkIndex = 0;
+	m_chunksFilled = 0;
+	m_framesInChunk = 0;
+	m_commitsSinceRebuild = 0;
+	m_current = CorrelationSums();
+	m_total = CorrelationSums();
+	m_ema = CorrelationSums();
+}
+
+void CorrelationMeter::process(const float *left, const float *right, size_t frames)
+{
+	if (!left || !right || frames == 0) {
+		return;
+	}
+
+	if (m_mode == Mode::Exponential) {
+		processExponential(left, right, frames);
+	} else {
+		processWindow(left, right, frames);
+	}
+}
+
+void CorrelationMeter::processSums(const CorrelationSums &sums, size_t frames)
+{
+	if (frames == 0) {
+		return;
+	}
+
+	if (m_mode == Mode::Exponential) {
+		const double decay = std::pow(m_decay, static_cast<double>(frames));
+		m_ema.lr = decay * m_ema.lr + sums.lr;
+		m_ema.ll = decay * m_ema.ll + sums.ll;
+		m_ema.rr = decay * m_ema.rr + sums.rr;
+		if (m_ema.ll < SILENCE_ENERGY && m_ema.rr < SILENCE_ENERGY) {
+			m_ema = CorrelationSums();
+		}
+		return;
+	}
+
+	if (m_chunks.empty()) {
+		configure(m_sampleRate, m_integrationMs, m_mode);
+	}
+
+	size_t remaining = frames;
+	while (remaining > 0) {
+		const size_t run = std::min(remaining, m_chunkFrames - m_framesInChunk);
+		m_current += sums.scaled(static_cast<double>(run) / frames);
+		m_framesInChunk += run;
+		remaining -= run;
+
+		if (m_framesInChunk == m_chunkFrames) {
+			commitChunk();
+		}
+	}
+}
+
+CorrelationSums CorrelationMeter::sums() const
+{
+	if (m_mode == Mode::Exponential) {
+		return m_ema;
+	}
+
+	CorrelationSums total = m_total;
+	total += m_current;
+	return total;
+}
+
+void CorrelationMeter::processWindow(const float *left, const float *right, size_t frames)
+{
+	if (m_chunks.empty()) {
+		configure(m_sampleRate, m_integrationMs, m_mode);
+	}
+
+	size_t offset = 0;
+	while (offset < frames) {
+		// チャンク境界までの連続区間をまとめて積算する
+		const size_t run = std::min(frames - offset, m_chunkFrames - m_framesInChunk);
+
+		m_current += correlationSums(left + offset, right + offset, run);
+
+		m_framesInChunk += run;
+		offset += run;
+
+		if (m_framesInChunk == m_chunkFrames) {
+			commitChunk();
+		}
+	}
+}
+
+void CorrelationMeter::commitChunk()
+{
+	// 窓から外れる最古のチャンクを差し引き、新しいチャンクを加える
+	CorrelationSums &slot = m_chunks[m_chunkIndex];
+	m_total -= slot;
+	slot = m_current;
+	m_total += slot;
+
+	m_chunkIndex = (m_chunkIndex + 1) % m_chunks.size();
+	m_chunksFilled = std::min(m_chunksFilled + 1, m_chunks.size());
+	m_current = CorrelationSums();
+	m_framesInChunk = 0;
+
+	// 加減算の丸め誤差が長時間で蓄積しないよう、窓1周ごとに合計を再計算する（償却O(1)）
+	if (++m_commitsSinceRebuild >= m_chunks.size()) {
+		m_commitsSinceRebuild = 0;
+		CorrelationSums total;
+		for (const CorrelationSums &chunk : m_chunks) {
+			total += chunk;
+		}
+		m_total = total;
+	}
+}
+
+void CorrelationMeter::processExponential(const float *left, const float *right, size_t frames)
+{
+	// 短いブロック単位で減衰させ、ブロック内はカーネルで単純和を取る
+	// ブロック長は最短の積分時間に対して十分短いので、時定数への影響は無視できる
+	for (size_t offset = 0; offset < frames; offset += EXPONENTIAL_BLOCK_FRAMES) {
+		const size_t run = std::min(frames - offset, EXPONENTIAL_BLOCK_FRAMES);
+		const double decay = run == EXPONENTIAL_BLOCK_FRAMES ? m_blockDecay
+								     : std::pow(m_decay, static_cast<double>(run));
+		const CorrelationSums block = correlationSums(left + offset, right + offset, run);
+
+		m_ema.lr = decay * m_ema.lr + block.lr;
+		m_ema.ll = decay * m_ema.ll + block.ll;
+		m_ema.rr = decay * m_ema.rr + block.rr;
+	}
+
+	// 長い無音でデノーマルに落ちないようにする
+	if (m_ema.ll < SILENCE_ENERGY && m_ema.rr < SILENCE_ENERGY) {
+		m_ema = CorrelationSums();
+	}
+}
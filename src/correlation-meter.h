@@ -0,0 +1,110 @@
+/*
+Audoo-phase-meter for OBS
+Copyright (C) 2025 you214 https://github.com/you214
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along
+with this program. If not, see <https://www.gnu.org/licenses/>
+*/
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// 相関計算用の積和（ΣLR, ΣL², ΣR²）
+struct CorrelationSums {
+	double lr = 0.0;
+	double ll = 0.0;
+	double rr = 0.0;
+
+	CorrelationSums &operator+=(const CorrelationSums &other)
+	{
+		lr += other.lr;
+		ll += other.ll;
+		rr += other.rr;
+		return *this;
+	}
+
+	CorrelationSums &operator-=(const CorrelationSums &other)
+	{
+		lr -= other.lr;
+		ll -= other.ll;
+		rr -= other.rr;
+		return *this;
+	}
+
+	// 各積和をfactor倍したもの（まとめて受け取った積和を区間へ按分するときに使う）
+	CorrelationSums scaled(double factor) const { return CorrelationSums{lr * factor, ll * factor, rr * factor}; }
+
+	// 正規化した相関値（-1〜+1）。無音時は0
+	double correlation() const;
+	// M/Sのエネルギー比（dB）。モノラルで-∞、逆相で+∞になるので±WIDTH_LIMIT_DBで打ち切る。無音時は0
+	double widthDb() const;
+
+	static constexpr double WIDTH_LIMIT_DB = 60.0;
+};
+
+// 積分時間付きの相関メーター
+// Window: 指定時間の矩形窓。窓をチャンクに分けた積和のリングで管理し、1サンプルあたりO(1)で更新する
+// Exponential: 指定時定数の指数移動平均（アナログメーター風のバリスティクス）
+class CorrelationMeter {
+public:
+	enum class Mode { Window, Exponential };
+
+	CorrelationMeter() = default;
+
+	// サンプルレートと積分時間（ミリ秒）を設定し、状態をリセットする
+	void configure(uint32_t sampleRate, double integrationMs, Mode mode);
+	void reset();
+
+	void process(const float *left, const float *right, size_t frames);
+	// サンプルの代わりにframes分の積和をまとめて加える（フィルターの要約から更新する場合）
+	// 窓のチャンクにはフレーム数で按分するので、時間分解能は受け取る間隔まで下がる
+	void processSums(const CorrelationSums &sums, size_t frames);
+
+	double correlation() const { return sums().correlation(); }
+	CorrelationSums sums() const;
+
+	uint32_t sampleRate() const { return m_sampleRate; }
+	double integrationMs() const { return m_integrationMs; }
+	Mode mode() const { return m_mode; }
+
+	// 窓を分割するチャンク数（窓の時間分解能は 積分時間 / CHUNKS_PER_WINDOW）
+	static constexpr size_t CHUNKS_PER_WINDOW = 64;
+
+private:
+	void processWindow(const float *left, const float *right, size_t frames);
+	void processExponential(const float *left, const float *right, size_t frames);
+	void commitChunk();
+
+	uint32_t m_sampleRate = 48000;
+	double m_integrationMs = 300.0;
+	Mode m_mode = Mode::Window;
+
+	// Window用
+	std::vector<CorrelationSums> m_chunks; // 完了したチャンクの積和（リング）
+	size_t m_chunkFrames = 1;
+	size_t m_chunkIndex = 0;
+	size_t m_chunksFilled = 0;
+	size_t m_framesInChunk = 0;
+	size_t m_commitsSinceRebuild = 0;
+	CorrelationSums m_current; // 書き込み中のチャンク
+	CorrelationSums m_total;   // 完了チャンクの合計
+
+	// Exponential用
+	static constexpr size_t EXPONENTIAL_BLOCK_FRAMES = 32;
+	double m_decay = 0.0;
+	double m_blockDecay = 0.0;
+	CorrelationSums m_ema;
+};
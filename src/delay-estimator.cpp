@@ -0,0 +1,201 @@
+/*
+Audoo-phase-meter for OBS
+Copyright (C) 2025 you214 https://github.com/you214
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along
+with this program. If not, see <https://www.gnu.org/licenses/>
+*/
+
+#include "delay-estimator.h"
+#include <algorithm>
+#include <cmath>
+
+// 相互スペクトルの時間平均の係数（推定1回あたり）
+static constexpr float SPECTRUM_SMOOTHING = 0.3f;
+
+// どちらかの窓の平均パワーがこれ未満（約-70dBFS）なら推定しない
+static constexpr double SILENCE_POWER = 1e-7;
+
+// PHATの正規化で振幅がほぼ0のビンを持ち上げすぎないための下限（平均振幅比）
+static constexpr float PHAT_FLOOR = 1e-3f;
+
+void DelayHistory::configure(size_t capacity)
+{
+	if (capacity == 0) {
+		m_samples = {};
+		m_mask = 0;
+	} else {
+		size_t size = 1;
+		while (size < capacity) {
+			size <<= 1;
+		}
+		m_samples.assign(size, 0.0f);
+		m_mask = size - 1;
+	}
+	m_written = 0;
+	m_endNs = 0;
+}
+
+void DelayHistory::push(const float *left, const float *right, size_t frames)
+{
+	if (m_samples.empty()) {
+		return;
+	}
+
+	for (size_t i = 0; i < frames; ++i) {
+		m_samples[(m_written + i) & m_mask] = (left[i] + right[i]) * 0.5f;
+	}
+	m_written += frames;
+}
+
+bool DelayHistory::copy(uint64_t endNs, size_t count, uint32_t sampleRate, float *out) const
+{
+	if (m_samples.empty() || m_endNs == 0 || endNs > m_endNs) {
+		return false;
+	}
+
+	// 最新サンプルから何サンプル遡った位置で終わるか
+	const uint64_t back = ((m_endNs - endNs) * sampleRate + 500000000ULL) / 1000000000ULL;
+	const uint64_t available = std::min<uint64_t>(m_written, m_samples.size());
+	if (back + count > available) {
+		return false;
+	}
+
+	const uint64_t start = m_written - back - count;
+	for (size_t i = 0; i < count; ++i) {
+		out[i] = m_samples[(start + i) & m_mask];
+	}
+	return true;
+}
+
+void DelayEstimator::configure(uint32_t sampleRate)
+{
+	m_sampleRate = std::max<uint32_t>(sampleRate, 1);
+
+	// 0.5秒以上の2の冪。ゼロ詰めして2倍長でFFTする（巡回相関の折り返しを避けるため）
+	m_window = 1;
+	while (m_window < m_sampleRate / 2 && m_window * 2 < FftPlan::MAX_SIZE) {
+		m_window <<= 1;
+	}
+
+	m_plan = FftPlan::get(m_window * 2);
+	m_reference.assign(m_window, 0.0f);
+	m_target.assign(m_window, 0.0f);
+	m_work.assign(m_window * 2, std::complex<float>());
+	m_smoothed.assign(m_window * 2, std::complex<float>());
+	reset();
+}
+
+void DelayEstimator::reset()
+{
+	std::fill(m_smoothed.begin(), m_smoothed.end(), std::complex<float>());
+	m_hasSmoothed = false;
+	m_result = DelayEstimate();
+}
+
+bool DelayEstimator::capture(const DelayHistory &reference, const DelayHistory &target)
+{
+	if (!m_plan || reference.endTime() == 0 || target.endTime() == 0) {
+		return false;
+	}
+
+	// 両方に揃っている最新の時刻で窓を切る（OBS内部のバッファ差はここで吸収される）
+	const uint64_t endNs = std::min(reference.endTime(), target.endTime());
+	return reference.copy(endNs, m_window, m_sampleRate, m_reference.data()) &&
+	       target.copy(endNs, m_window, m_sampleRate, m_target.data());
+}
+
+void DelayEstimator::estimate()
+{
+	if (!m_plan) {
+		return;
+	}
+
+	const size_t size = m_plan->size();
+	const size_t mask = size - 1;
+
+	double referencePower = 0.0;
+	double targetPower = 0.0;
+	for (size_t i = 0; i < m_window; ++i) {
+		referencePower += m_reference[i] * m_reference[i];
+		targetPower += m_target[i] * m_target[i];
+	}
+	if (referencePower < SILENCE_POWER * m_window || targetPower < SILENCE_POWER * m_window) {
+		return; // 無音の区間では前回の結果を保つ
+	}
+
+	// 基準を実部、対象を虚部に入れて1回のFFTで両方を変換する（後半はゼロ詰め）
+	std::complex<float> *z = m_work.data();
+	for (size_t i = 0; i < m_window; ++i) {
+		z[i] = std::complex<float>(m_reference[i], m_target[i]);
+	}
+	std::fill(z + m_window, z + size, std::complex<float>());
+	m_plan->forward(z);
+
+	// 相互スペクトル G = conj(A)·B を時間方向に平均する
+	// A[k] = (Z[k] + conj(Z[N-k])) / 2, B[k] = (Z[k] - conj(Z[N-k])) / 2i
+	const float alpha = m_hasSmoothed ? SPECTRUM_SMOOTHING : 1.0f;
+	double magnitudeSum = 0.0;
+	for (size_t k = 0; k < size; ++k) {
+		const std::complex<float> a = z[k];
+		const std::complex<float> b = std::conj(z[(size - k) & mask]);
+		const float aRe = (a.real() + b.real()) * 0.5f;
+		const float aIm = (a.imag() + b.imag()) * 0.5f;
+		const float bRe = (a.imag() - b.imag()) * 0.5f;
+		const float bIm = (b.real() - a.real()) * 0.5f;
+
+		const std::complex<float> cross(aRe * bRe + aIm * bIm, aRe * bIm - aIm * bRe);
+		const std::complex<float> g = m_smoothed[k] + (cross - m_smoothed[k]) * alpha;
+		m_smoothed[k] = g;
+		magnitudeSum += std::sqrt(g.real() * g.real() + g.imag() * g.imag());
+	}
+	m_hasSmoothed = true;
+
+	// PHAT: 振幅を捨てて位相だけにする（残響や音色の違いに強く、ピークが鋭くなる）
+	// 逆変換は conj → 順変換 → conj で行う（実数部だけ使うので最後のconjは省略）
+	const float floor = static_cast<float>(magnitudeSum / size) * PHAT_FLOOR + 1e-20f;
+	for (size_t k = 0; k < size; ++k) {
+		const std::complex<float> g = m_smoothed[k];
+		const float weight = 1.0f / (std::sqrt(g.real() * g.real() + g.imag() * g.imag()) + floor);
+		z[k] = std::complex<float>(g.real() * weight, -g.imag() * weight);
+	}
+	m_plan->forward(z);
+
+	// r[τ] = Σ a[n]·b[n+τ]。正のラグは先頭から、負のラグは末尾から読む
+	const float scale = 1.0f / static_cast<float>(size);
+	const size_t maxLag = std::min<size_t>(static_cast<size_t>(MAX_DELAY_MS * m_sampleRate / 1000.0), m_window - 1);
+	auto at = [&](long lag) { return z[static_cast<size_t>(lag) & mask].real() * scale; };
+
+	long bestLag = 0;
+	float bestValue = at(0);
+	for (long lag = -static_cast<long>(maxLag); lag <= static_cast<long>(maxLag); ++lag) {
+		const float value = at(lag);
+		if (std::fabs(value) > std::fabs(bestValue)) {
+			bestValue = value;
+			bestLag = lag;
+		}
+	}
+
+	// 放物線補間でサンプル以下の遅延を求める（符号を揃えて最大値として扱う）
+	const float sign = bestValue < 0.0f ? -1.0f : 1.0f;
+	const float y0 = at(bestLag - 1) * sign;
+	const float y1 = bestValue * sign;
+	const float y2 = at(bestLag + 1) * sign;
+	const float denominator = y0 - 2.0f * y1 + y2;
+	const double fraction = denominator < 0.0f ? std::clamp(0.5f * (y0 - y2) / denominator, -0.5f, 0.5f) : 0.0;
+
+	m_result.valid = true;
+	m_result.delayMs = (static_cast<double>(bestLag) + fraction) * 1000.0 / m_sampleRate;
+	m_result.peak = std::min(1.0f, std::fabs(bestValue));
+	m_result.inverted = bestValue < 0.0f;
+}
@@ -0,0 +1,93 @@
+/*
+Audoo-phase-meter for OBS
+Copyright (C) 2025 you214 https://github.com/you214
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along
+with this program. If not, see <https://www.gnu.org/licenses/>
+*/
+
+#pragma once
+
+#include <complex>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "fft-plan.h"
+
+// 遅延推定用の時刻付きモノラル履歴（(L+R)/2 のリング）。解析スレッドのみが触る
+class DelayHistory {
+public:
+	DelayHistory() = default;
+
+	// 容量0で無効（pushは何もしない）
+	void configure(size_t capacity);
+	bool enabled() const { return !m_samples.empty(); }
+
+	void push(const float *left, const float *right, size_t frames);
+
+	// 最後にpushしたサンプルの次のフレームの時刻（ns）
+	void setEndTime(uint64_t timeNs) { m_endNs = timeNs; }
+	uint64_t endTime() const { return m_endNs; }
+
+	// 時刻endNsで終わる count サンプルを out にコピーする。履歴が足りなければfalse
+	bool copy(uint64_t endNs, size_t count, uint32_t sampleRate, float *out) const;
+
+private:
+	std::vector<float> m_samples;
+	size_t m_mask = 0;
+	uint64_t m_written = 0;
+	uint64_t m_endNs = 0;
+};
+
+struct DelayEstimate {
+	bool valid = false;
+	double delayMs = 0.0; // 正なら対象が基準より遅れている
+	double peak = 0.0;    // PHAT相関のピーク（0〜1、1に近いほど確か）
+	bool inverted = false;
+};
+
+// 2つのソースの到達時間差と極性をGCC-PHAT（位相変換付き一般化相互相関）で推定する
+// 窓の切り出しはロック中に行い、FFTはロックの外で行う
+class DelayEstimator {
+public:
+	DelayEstimator() = default;
+
+	// 窓長はサンプルレートから決める（約0.5秒以上の2の冪）。バッファはここで確保する
+	void configure(uint32_t sampleRate);
+	void reset();
+
+	// 両方の履歴から同じ時刻範囲の窓をコピーする。揃えられなければfalse
+	bool capture(const DelayHistory &reference, const DelayHistory &target);
+
+	// captureした窓で相互相関を計算して結果を更新する
+	void estimate();
+
+	const DelayEstimate &result() const { return m_result; }
+	size_t windowFrames() const { return m_window; }
+	size_t historyFrames() const { return m_window * 2; }
+
+	static constexpr double MAX_DELAY_MS = 250.0;
+
+private:
+	uint32_t m_sampleRate = 0;
+	size_t m_window = 0;
+	std::shared_ptr<const FftPlan> m_plan;
+	std::vector<float> m_reference;
+	std::vector<float> m_target;
+	std::vector<std::complex<float>> m_work;
+	std::vector<std::complex<float>> m_smoothed; // 時間方向に平均した相互スペクトル
+	bool m_hasSmoothed = false;
+	DelayEstimate m_result;
+};
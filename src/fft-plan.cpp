@@ -0,0 +1,129 @@
+/*
+Audoo-phase-meter for OBS
+Copyright (C) 2025 you214 https://github.com/you214
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along
+with this program. If not, see <https://www.gnu.org/licenses/>
+*/
+
+#include "fft-plan.h"
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <mutex>
+
+static constexpr double PI = 3.14159265358979323846;
+
+FftPlan::FftPlan(size_t size) : m_size(size), m_windowSum(0.0)
+{
+	int bits = 0;
+	while ((size_t(1) << bits) < size) {
+		++bits;
+	}
+
+	m_bitReverse.resize(size);
+	for (size_t i = 0; i < size; ++i) {
+		uint32_t reversed = 0;
+		for (int b = 0; b < bits; ++b) {
+			reversed |= ((i >> b) & 1u) << (bits - 1 - b);
+		}
+		m_bitReverse[i] = reversed;
+	}
+
+	// 回転因子と窓は倍精度で計算してから丸める
+	m_twiddles.resize(size / 2);
+	for (size_t k = 0; k < size / 2; ++k) {
+		const double angle = -2.0 * PI * static_cast<double>(k) / static_cast<double>(size);
+		m_twiddles[k] = std::complex<float>(static_cast<float>(std::cos(angle)),
+						    static_cast<float>(std::sin(angle)));
+	}
+
+	m_window.resize(size);
+	for (size_t i = 0; i < size; ++i) {
+		const double w = 0.5 - 0.5 * std::cos(2.0 * PI * static_cast<double>(i) / static_cast<double>(size));
+		m_window[i] = static_cast<float>(w);
+		m_windowSum += w;
+	}
+}
+
+// この長さ未満の段はループの入れ子を入れ替える
+static constexpr size_t SHORT_STAGE = 16;
+
+static inline void butterfly(float *a, float *b, float wRe, float wIm)
+{
+	const float re = b[0] * wRe - b[1] * wIm;
+	const float im = b[0] * wIm + b[1] * wRe;
+	b[0] = a[0] - re;
+	b[1] = a[1] - im;
+	a[0] += re;
+	a[1] += im;
+}
+
+void FftPlan::forward(std::complex<float> *data) const
+{
+	for (size_t i = 0; i < m_size; ++i) {
+		const size_t j = m_bitReverse[i];
+		if (i < j) {
+			std::swap(data[i], data[j]);
+		}
+	}
+
+	// 実部・虚部を別々に扱う（std::complexの積はNaN処理のため遅くなることがある）
+	float *values = reinterpret_cast<float *>(data);
+	const float *twiddles = reinterpret_cast<const float *>(m_twiddles.data());
+
+	for (size_t length = 2; length <= m_size; length <<= 1) {
+		const size_t half = length / 2;
+		const size_t step = m_size / length;
+
+		if (half < SHORT_STAGE) {
+			// 短い段: 回転因子ごとに全ブロックを処理する（内側のループを長くする）
+			for (size_t k = 0; k < half; ++k) {
+				const float wRe = twiddles[2 * k * step];
+				const float wIm = twiddles[2 * k * step + 1];
+				for (size_t start = k; start < m_size; start += length) {
+					butterfly(values + 2 * start, values + 2 * (start + half), wRe, wIm);
+				}
+			}
+		} else {
+			// 長い段: ブロックごとに連続したメモリを順に処理する
+			for (size_t start = 0; start < m_size; start += length) {
+				for (size_t k = 0; k < half; ++k) {
+					butterfly(values + 2 * (start + k), values + 2 * (start + k + half), twiddles[2 * k * step],
+						  twiddles[2 * k * step + 1]);
+				}
+			}
+		}
+	}
+}
+
+std::shared_ptr<const FftPlan> FftPlan::get(size_t size)
+{
+	// 1024〜65536 の7種類だけなので配列で持つ
+	static constexpr size_t PLAN_COUNT = 7;
+	static std::array<std::shared_ptr<const FftPlan>, PLAN_COUNT> plans;
+	static std::mutex mutex;
+
+	size_t rounded = MIN_SIZE;
+	size_t index = 0;
+	while (rounded < size && rounded < MAX_SIZE) {
+		rounded <<= 1;
+		++index;
+	}
+
+	std::lock_guard<std::mutex> lock(mutex);
+	if (!plans[index]) {
+		plans[index] = std::make_shared<const FftPlan>(rounded);
+	}
+	return plans[index];
+}
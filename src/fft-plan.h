@@ -0,0 +1,55 @@
+/*
+Audoo-phase-meter for OBS
+Copyright (C) 2025 you214 https://github.com/you214
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along
+with this program. If not, see <https://www.gnu.org/licenses/>
+*/
+
+#pragma once
+
+#include <complex>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+// 基数2の複素FFTプラン（ビット反転表・回転因子・Hann窓を事前計算しておく）
+// プランはサイズごとに1つだけ作って共有し、変換時にメモリ確保はしない
+class FftPlan {
+public:
+	explicit FftPlan(size_t size);
+
+	FftPlan(const FftPlan &) = delete;
+	FftPlan &operator=(const FftPlan &) = delete;
+
+	size_t size() const { return m_size; }
+	const float *window() const { return m_window.data(); }
+	double windowSum() const { return m_windowSum; }
+
+	// インプレースの順変換（exp(-i2πkn/N)）
+	void forward(std::complex<float> *data) const;
+
+	// サイズごとのプランキャッシュ（2の冪で MIN_SIZE〜MAX_SIZE に丸める）
+	static std::shared_ptr<const FftPlan> get(size_t size);
+
+	static constexpr size_t MIN_SIZE = 1024;
+	static constexpr size_t MAX_SIZE = 65536;
+
+private:
+	size_t m_size;
+	std::vector<uint32_t> m_bitReverse;
+	std::vector<std::complex<float>> m_twiddles; // N/2個
+	std::vector<float> m_window;
+	double m_windowSum;
+};
@@ -0,0 +1,57 @@
+/*
+Audoo-phase-meter for OBS
+Copyright (C) 2025 you214 https://github.com/you214
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along
+with this program. If not, see <https://www.gnu.org/licenses/>
+*/
+
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+
+// 解析と描画の周期を刻む時計。新しいデータが届いたときだけ動き、何も届かなければ眠ったままになる
+// signal()はロックもシステムコールも（待っている側がいなければ）行わないので、音声スレッドから呼べる
+class FrameClock {
+public:
+	// 生産者側: 新しい音声や表示の変更があったことを知らせる（何度呼んでも次の1周期にまとまる）
+	void signal()
+	{
+		if (m_pending.exchange(1, std::memory_order_acq_rel) == 0) {
+			m_pending.notify_one();
+		}
+	}
+
+	// 消費者側: 通知が来るまで眠る
+	void wait() const { m_pending.wait(0, std::memory_order_acquire); }
+
+	// 消費者側: 通知を受け取る。これより後のsignal()で書かれたデータは次の周期で読む
+	// （両側ともexchangeなので、ここで読み落とした書き込みには必ず次の通知が付く）
+	void consume() { m_pending.exchange(0, std::memory_order_acq_rel); }
+
+	// 1秒あたりの周期数（表示の目標レートや、隠れているときの間引いたレート）
+	void setRate(int hz) { m_rate.store(std::clamp(hz, MIN_RATE_HZ, MAX_RATE_HZ), std::memory_order_relaxed); }
+	int rate() const { return m_rate.load(std::memory_order_relaxed); }
+	std::chrono::nanoseconds period() const { return std::chrono::nanoseconds(std::chrono::seconds(1)) / rate(); }
+
+	static constexpr int MIN_RATE_HZ = 1;
+	static constexpr int MAX_RATE_HZ = 240;
+	static constexpr int DEFAULT_RATE_HZ = 30;
+
+private:
+	std::atomic<uint32_t> m_pending{1}; // 起動直後に1回は解析する
+	std::atomic<int> m_rate{DEFAULT_RATE_HZ};
+};
@@ -0,0 +1,226 @@
+/*
+Audoo-phase-meter for OBS
+Copyright (C) 2025 you214 https://github.com/you214
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along
+with this program. If not, see <https://www.gnu.org/licenses/>
+*/
+
+
+#include "mapped-file.h"
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#ifdef _WIN32
+
+static std::wstring widePath(const std::string &path)
+{
+	const int length = MultiByteToWideChar(CP_UTF8, 0, path.c_str(), -1, nullptr, 0);
+	std::wstring wide(length > 0 ? length : 0, L'\0');
+	if (length > 0) {
+		MultiByteToWideChar(CP_UTF8, 0, path.c_str(), -1, wide.data(), length);
+	}
+	return wide;
+}
+
+static bool setFileSize(HANDLE file, size_t size)
+{
+	LARGE_INTEGER position;
+	position.QuadPart = static_cast<LONGLONG>(size);
+	return SetFilePointerEx(file, position, nullptr, FILE_BEGIN) && SetEndOfFile(file);
+}
+
+bool MappedFile::openRead(const std::string &path)
+{
+	close();
+	HANDLE file = CreateFileW(widePath(path).c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+				  FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+	if (file == INVALID_HANDLE_VALUE) {
+		return false;
+	}
+	LARGE_INTEGER size;
+	if (!GetFileSizeEx(file, &size) || size.QuadPart <= 0) {
+		CloseHandle(file);
+		return false;
+	}
+	m_file = file;
+	m_writable = false;
+	if (!map(static_cast<size_t>(size.QuadPart))) {
+		close();
+		return false;
+	}
+	return true;
+}
+
+bool MappedFile::create(const std::string &path, size_t size)
+{
+	close();
+	HANDLE file = CreateFileW(widePath(path).c_str(), GENERIC_READ | GENERIC_WRITE, FILE_SHARE_READ, nullptr,
+				  CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+	if (file == INVALID_HANDLE_VALUE) {
+		return false;
+	}
+	m_file = file;
+	m_writable = true;
+	if (!setFileSize(file, size) || !map(size)) {
+		close(0);
+		return false;
+	}
+	return true;
+}
+
+bool MappedFile::resize(size_t size)
+{
+	if (!m_file || !m_writable) {
+		return false;
+	}
+	unmap();
+	return setFileSize(static_cast<HANDLE>(m_file), size) && map(size);
+}
+
+void MappedFile::close(size_t finalSize)
+{
+	unmap();
+	if (m_file) {
+		if (m_writable && finalSize != SIZE_MAX) {
+			setFileSize(static_cast<HANDLE>(m_file), finalSize);
+		}
+		CloseHandle(static_cast<HANDLE>(m_file));
+		m_file = nullptr;
+	}
+	m_size = 0;
+}
+
+bool MappedFile::map(size_t size)
+{
+	const DWORD protect = m_writable ? PAGE_READWRITE : PAGE_READONLY;
+	m_mapping = CreateFileMappingW(static_cast<HANDLE>(m_file), nullptr, protect, 0, 0, nullptr);
+	if (!m_mapping) {
+		return false;
+	}
+	void *view = MapViewOfFile(static_cast<HANDLE>(m_mapping), m_writable ? FILE_MAP_WRITE : FILE_MAP_READ, 0, 0,
+				   size);
+	if (!view) {
+		CloseHandle(static_cast<HANDLE>(m_mapping));
+		m_mapping = nullptr;
+		return false;
+	}
+	m_data = static_cast<uint8_t *>(view);
+	m_size = size;
+	return true;
+}
+
+void MappedFile::unmap()
+{
+	if (m_data) {
+		UnmapViewOfFile(m_data);
+		m_data = nullptr;
+	}
+	if (m_mapping) {
+		CloseHandle(static_cast<HANDLE>(m_mapping));
+		m_mapping = nullptr;
+	}
+}
+
+#else
+
+bool MappedFile::openRead(const std::string &path)
+{
+	close();
+	const int fd = ::open(path.c_str(), O_RDONLY);
+	if (fd < 0) {
+		return false;
+	}
+	struct stat info;
+	if (fstat(fd, &info) != 0 || info.st_size <= 0) {
+		::close(fd);
+		return false;
+	}
+	m_fd = fd;
+	m_writable = false;
+	if (!map(static_cast<size_t>(info.st_size))) {
+		close();
+		return false;
+	}
+	// 先頭から順に読むので先読みを促す
+	posix_madvise(m_data, m_size, POSIX_MADV_SEQUENTIAL);
+	return true;
+}
+
+bool MappedFile::create(const std::string &path, size_t size)
+{
+	close();
+	const int fd = ::open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+	if (fd < 0) {
+		return false;
+	}
+	m_fd = fd;
+	m_writable = true;
+	if (ftruncate(fd, static_cast<off_t>(size)) != 0 || !map(size)) {
+		close(0);
+		return false;
+	}
+	return true;
+}
+
+bool MappedFile::resize(size_t size)
+{
+	if (m_fd < 0 || !m_writable) {
+		return false;
+	}
+	unmap();
+	return ftruncate(m_fd, static_cast<off_t>(size)) == 0 && map(size);
+}
+
+void MappedFile::close(size_t finalSize)
+{
+	unmap();
+	if (m_fd >= 0) {
+		if (m_writable && finalSize != SIZE_MAX && ftruncate(m_fd, static_cast<off_t>(finalSize)) != 0) {
+			// 切り詰めに失敗しても末尾が0で埋まるだけで、再生側は読み飛ばせる
+		}
+		::close(m_fd);
+		m_fd = -1;
+	}
+	m_size = 0;
+}
+
+bool MappedFile::map(size_t size)
+{
+	const int protect = m_writable ? PROT_READ | PROT_WRITE : PROT_READ;
+	void *view = mmap(nullptr, size, protect, m_writable ? MAP_SHARED : MAP_PRIVATE, m_fd, 0);
+	if (view == MAP_FAILED) {
+		return false;
+	}
+	m_data = static_cast<uint8_t *>(view);
+	m_size = size;
+	return true;
+}
+
+void MappedFile::unmap()
+{
+	if (m_data) {
+		munmap(m_data, m_size);
+		m_data = nullptr;
+	}
+}
+
+#endif
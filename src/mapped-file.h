@@ -0,0 +1,62 @@
+/*
+Audoo-phase-meter for OBS
+Copyright (C) 2025 you214 https://github.com/you214
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along
+with this program. If not, see <https://www.gnu.org/licenses/>
+*/
+
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+// メモリマップしたファイル（キャプチャの記録・再生用）
+// 書き込み用は伸長できるが、伸長するとマップし直すためdata()のアドレスが変わる
+class MappedFile {
+public:
+	MappedFile() = default;
+	~MappedFile() { close(); }
+
+	MappedFile(const MappedFile &) = delete;
+	MappedFile &operator=(const MappedFile &) = delete;
+
+	// 読み出し専用で開く（空のファイルは失敗）。パスはUTF-8
+	bool openRead(const std::string &path);
+	// 書き込み用に作成し、sizeバイトに伸ばしてマップする（既存のファイルは切り詰める）
+	bool create(const std::string &path, size_t size);
+	// 書き込み用: ファイルをsizeバイトに伸ばしてマップし直す
+	bool resize(size_t size);
+	// 書き込み用ならfinalSizeバイトに切り詰めてから閉じる
+	void close(size_t finalSize = SIZE_MAX);
+
+	bool isOpen() const { return m_data != nullptr; }
+	uint8_t *data() const { return m_data; }
+	size_t size() const { return m_size; }
+
+private:
+	bool map(size_t size);
+	void unmap();
+
+#ifdef _WIN32
+	void *m_file = nullptr; // HANDLE
+	void *m_mapping = nullptr;
+#else
+	int m_fd = -1;
+#endif
+	uint8_t *m_data = nullptr;
+	size_t m_size = 0;
+	bool m_writable = false;
+};
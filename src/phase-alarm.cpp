@@ -0,0 +1,118 @@
+/*
+Audoo-phase-meter for OBS
+Copyright (C) 2025 you214 https://github.com/you214
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along
+with this program. If not, see <https://www.gnu.org/licenses/>
+*/
+
+
+#include "phase-alarm.h"
+#include "correlation-kernels.h"
+#include <algorithm>
+#include <bit>
+#include <cmath>
+
+uint64_t PhaseAlarm::pack(const PhaseAlarmSettings &settings)
+{
+	// 上位から 有効(1bit) | 継続時間ms(31bit) | しきい値(float 32bit)
+	const uint64_t hold = std::min<uint32_t>(settings.holdMs, 0x7FFFFFFFu);
+	return (settings.enabled ? uint64_t(1) << 63 : 0) | (hold << 32) |
+	       std::bit_cast<uint32_t>(std::clamp(settings.threshold, -1.0f, 1.0f));
+}
+
+PhaseAlarmSettings PhaseAlarm::unpack(uint64_t packed)
+{
+	PhaseAlarmSettings settings;
+	settings.enabled = (packed >> 63) != 0;
+	settings.holdMs = static_cast<uint32_t>(packed >> 32) & 0x7FFFFFFFu;
+	settings.threshold = std::bit_cast<float>(static_cast<uint32_t>(packed));
+	return settings;
+}
+
+void PhaseAlarm::setSettings(const PhaseAlarmSettings &settings)
+{
+	m_settings.store(pack(settings), std::memory_order_relaxed);
+}
+
+PhaseAlarmSettings PhaseAlarm::settings() const
+{
+	return unpack(m_settings.load(std::memory_order_relaxed));
+}
+
+void PhaseAlarm::setActive(bool active)
+{
+	m_active.store(active, std::memory_order_release);
+	m_pendingFrames = 0;
+	if (std::atomic<bool> *notify = m_notify.load(std::memory_order_acquire)) {
+		notify->store(true, std::memory_order_release);
+	}
+}
+
+void PhaseAlarm::process(const float *left, const float *right, size_t frames)
+{
+	// 無効なら積和も取らない
+	if ((m_settings.load(std::memory_order_relaxed) >> 63) == 0) {
+		processSums(CorrelationSums(), 0);
+		return;
+	}
+	processSums(correlationSums(left, right, frames), frames);
+}
+
+void PhaseAlarm::processSums(const CorrelationSums &block, size_t frames)
+{
+	const PhaseAlarmSettings settings = unpack(m_settings.load(std::memory_order_relaxed));
+	const bool active = m_active.load(std::memory_order_relaxed);
+
+	// 警告中に無効にされたら解除を通知する
+	if (!settings.enabled) {
+		if (active) {
+			setActive(false);
+		}
+		m_ema = CorrelationSums();
+		m_emaFrames = 0.0;
+		return;
+	}
+	if (frames == 0) {
+		return;
+	}
+
+	const uint32_t sampleRate = std::max<uint32_t>(m_sampleRate.load(std::memory_order_relaxed), 1);
+	const double decay = std::exp(-static_cast<double>(frames) / (SMOOTHING_MS * 0.001 * sampleRate));
+	m_ema.lr = m_ema.lr * decay + block.lr;
+	m_ema.ll = m_ema.ll * decay + block.ll;
+	m_ema.rr = m_ema.rr * decay + block.rr;
+	m_emaFrames = m_emaFrames * decay + static_cast<double>(frames);
+
+	// 無音（と平滑化が立ち上がるまで）は判定を進めない
+	const double power = (m_ema.ll + m_ema.rr) * 0.5 / m_emaFrames;
+	if (power < SILENCE_POWER) {
+		m_pendingFrames = 0;
+		return;
+	}
+
+	const float correlation = static_cast<float>(m_ema.correlation());
+	m_correlation.store(correlation, std::memory_order_relaxed);
+
+	// 警告前はしきい値未満、警告中はしきい値+ヒステリシス超えが続いた時間を数える
+	const bool crossing = active ? correlation > settings.threshold + HYSTERESIS : correlation < settings.threshold;
+	if (!crossing) {
+		m_pendingFrames = 0;
+		return;
+	}
+
+	m_pendingFrames += frames;
+	if (m_pendingFrames * 1000 >= static_cast<uint64_t>(settings.holdMs) * sampleRate) {
+		setActive(!active);
+	}
+}
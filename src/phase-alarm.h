@@ -0,0 +1,79 @@
+/*
+Audoo-phase-meter for OBS
+Copyright (C) 2025 you214 https://github.com/you214
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along
+with this program. If not, see <https://www.gnu.org/licenses/>
+*/
+
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+#include "correlation-meter.h"
+
+// ソースごとの逆相警告の設定（プラグインの設定ファイルにUUIDごとに保存する）
+struct PhaseAlarmSettings {
+	bool enabled = false;
+	float threshold = -0.3f; // 平滑化した相関がこれを下回り続けたら警告する
+	uint32_t holdMs = 1000;  // 警告までの継続時間（解除にも同じ時間を要する）
+};
+
+// 逆相の検出（音声スレッドでブロックごとに判定する）
+// ブロックの積和を指数平均して相関を求め、しきい値の上下にヒステリシスを持たせて継続時間で状態を切り替える
+// 判定の状態更新はブロックあたりO(1)。状態が変わったときは通知フラグを立てるだけで、ログやUIはGUIスレッドが行う
+class PhaseAlarm {
+public:
+	PhaseAlarm() = default;
+
+	// GUIスレッド側: 設定は1語にまとめて渡すので、音声スレッドは途中の値を見ない
+	void configure(uint32_t sampleRate) { m_sampleRate.store(sampleRate, std::memory_order_relaxed); }
+	void setSettings(const PhaseAlarmSettings &settings);
+	PhaseAlarmSettings settings() const;
+
+	// 状態が変わったときにtrueを書き込むフラグ（nullptrで通知しない）
+	// フィルター側の判定はドックより長生きしうるので、ドックを破棄する前に外すこと
+	void setNotify(std::atomic<bool> *notify) { m_notify.store(notify, std::memory_order_release); }
+
+	// 音声スレッド側
+	void process(const float *left, const float *right, size_t frames);
+	// 積和を計算済みの場合（フィルターで1回だけ積和を取るとき）
+	void processSums(const CorrelationSums &block, size_t frames);
+
+	// どのスレッドからでも読める最新の状態
+	bool active() const { return m_active.load(std::memory_order_acquire); }
+	float correlation() const { return m_correlation.load(std::memory_order_relaxed); }
+
+	static constexpr double SMOOTHING_MS = 300.0; // 相関の平滑化の時定数
+	static constexpr float HYSTERESIS = 0.1f;      // 解除はしきい値をこれだけ上回ってから
+	static constexpr double SILENCE_POWER = 1e-5;  // 約-50dBFS。無音の間は状態を保つ
+
+private:
+	static uint64_t pack(const PhaseAlarmSettings &settings);
+	static PhaseAlarmSettings unpack(uint64_t packed);
+	void setActive(bool active);
+
+	std::atomic<uint64_t> m_settings{pack(PhaseAlarmSettings())};
+	std::atomic<uint32_t> m_sampleRate{48000};
+	std::atomic<std::atomic<bool> *> m_notify{nullptr};
+	std::atomic<bool> m_active{false};
+	std::atomic<float> m_correlation{0.0f};
+
+	// 音声スレッドのみ
+	CorrelationSums m_ema;
+	double m_emaFrames = 0.0;
+	uint64_t m_pendingFrames = 0; // 状態を切り替える側に居続けているフレーム数
+};
@@ -0,0 +1,105 @@
+/*
+Audoo-phase-meter for OBS
+Copyright (C) 2025 you214 https://github.com/you214
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along
+with this program. If not, see <https://www.gnu.org/licenses/>
+*/
+
+
+#include "phase-meter-filter.h"
+#include "alloc-tracker.h"
+#include <cstring>
+
+// フィルター1つ分のデータ。要約はドック側のソースとも共有する（どちらが先に消えてもよい）
+struct PhaseMeterTapFilter {
+	obs_source_t *context;
+	std::shared_ptr<PhaseTap> tap;
+};
+
+static PhaseMeterTapHandler tapHandler = nullptr;
+
+static const char *phase_meter_tap_get_name(void *type_data)
+{
+	(void)type_data; // 未使用パラメータを明示的にマーク
+	return obs_module_text("PhaseMeterTap");
+}
+
+static void *phase_meter_tap_create(obs_data_t *settings, obs_source_t *source)
+{
+	(void)settings; // 未使用パラメータを明示的にマーク
+	return new PhaseMeterTapFilter{source, std::make_shared<PhaseTap>()};
+}
+
+static void phase_meter_tap_destroy(void *data)
+{
+	delete static_cast<PhaseMeterTapFilter *>(data);
+}
+
+// 親ソースへの付け外し（読み込み時の復元も含めてここを通る）
+static void phase_meter_tap_add(void *data, obs_source_t *parent)
+{
+	PhaseMeterTapFilter *filter = static_cast<PhaseMeterTapFilter *>(data);
+	if (tapHandler && parent) {
+		tapHandler(parent, filter->tap, true);
+	}
+}
+
+static void phase_meter_tap_remove(void *data, obs_source_t *parent)
+{
+	PhaseMeterTapFilter *filter = static_cast<PhaseMeterTapFilter *>(data);
+	if (tapHandler && parent) {
+		tapHandler(parent, filter->tap, false);
+	}
+}
+
+// 音声スレッドで呼ばれる。バッファは読むだけで、そのまま次のフィルターへ渡す
+static struct obs_audio_data *phase_meter_tap_filter_audio(void *data, struct obs_audio_data *audio)
+{
+	PhaseMeterTapFilter *filter = static_cast<PhaseMeterTapFilter *>(data);
+	if (audio && audio->frames > 0 && audio->data[0]) {
+		const AllocScope allocScope(AllocStage::Capture);
+		const float *left = reinterpret_cast<const float *>(audio->data[0]);
+		// モノラルのソースは同じチャンネルを左右に使う（相関は常に+1）
+		const float *right = audio->data[1] ? reinterpret_cast<const float *>(audio->data[1]) : left;
+		filter->tap->process(left, right, audio->frames);
+	}
+	return audio;
+}
+
+void register_phase_meter_tap(PhaseMeterTapHandler handler)
+{
+	tapHandler = handler;
+
+	struct obs_source_info info = {};
+	info.id = PHASE_METER_TAP_ID;
+	info.type = OBS_SOURCE_TYPE_FILTER;
+	info.output_flags = OBS_SOURCE_AUDIO;
+	info.get_name = phase_meter_tap_get_name;
+	info.create = phase_meter_tap_create;
+	info.destroy = phase_meter_tap_destroy;
+	info.filter_audio = phase_meter_tap_filter_audio;
+	info.filter_add = phase_meter_tap_add;
+	info.filter_remove = phase_meter_tap_remove;
+	obs_register_source(&info);
+}
+
+std::shared_ptr<PhaseTap> get_phase_meter_tap(obs_source_t *filter)
+{
+	const char *id = filter ? obs_source_get_id(filter) : nullptr;
+	if (!id || std::strcmp(id, PHASE_METER_TAP_ID) != 0) {
+		return nullptr;
+	}
+	PhaseMeterTapFilter *data = static_cast<PhaseMeterTapFilter *>(obs_obj_get_data(filter));
+	return data ? data->tap : nullptr;
+}
@@ -0,0 +1,37 @@
+/*
+Audoo-phase-meter for OBS
+Copyright (C) 2025 you214 https://github.com/you214
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along
+with this program. If not, see <https://www.gnu.org/licenses/>
+*/
+
+
+#pragma once
+
+#include <obs-module.h>
+#include <memory>
+
+#include "phase-tap.h"
+
+// 音声フィルター"Phase Meter Tap"のソースID
+#define PHASE_METER_TAP_ID "phase_meter_tap"
+
+// フィルターがソースに付いた（attached == true）・外れたときに呼ばれる。OBSの任意のスレッドから呼ばれうる
+using PhaseMeterTapHandler = void (*)(obs_source_t *parent, const std::shared_ptr<PhaseTap> &tap, bool attached);
+
+// フィルターを登録する（obs_module_loadから呼ぶ）
+void register_phase_meter_tap(PhaseMeterTapHandler handler);
+
+// filterがPhase Meter Tapならその要約を返す（違えばnullptr）
+std::shared_ptr<PhaseTap> get_phase_meter_tap(obs_source_t *filter);
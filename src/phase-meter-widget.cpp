@@ -17,37 +17,76 @@ with this program. If not, see <https://www.gnu.org/licenses/>
 */
 
 #include "phase-meter-widget.h"
+#include "alloc-tracker.h"
 #include <obs-module.h>
 #include <obs-frontend-api.h>
+#include <util/platform.h>
 #include <QApplication>
 #include <QColorDialog>
 #include <QMainWindow>
 #include <QResizeEvent>
 #include <QPaintEvent>
+#include <QWheelEvent>
+#include <QWindow>
+#include <QScreen>
+#include <QMouseEvent>
+#include <QSignalBlocker>
+#include <QStandardItemModel>
 #include <QMutexLocker>
 #include <QThreadPool>
 #include <QFuture>
 #include <QtConcurrent>
 #include <cmath>
 #include <algorithm>
-#include <execution>
-#include <future>
 #include <thread>
-#include <numeric>
 
 PhaseMeterWidget::PhaseMeterWidget(QWidget *parent)
 	: QWidget(parent),
-	  m_updateTimer(new QTimer(this)),
 	  m_isDestroying(false),
-	  m_needsUpdate(false),
-	  m_isProcessing(false)
+	  m_showStats(false),
+	  m_displayActive(false),
+	  m_programOnly(false),
+	  m_rateWindowStartNs(statNowNs()),
+	  m_rateWindowPaints(0),
+	  m_paintsPerSecond(0.0),
+	  m_sampleRate(48000),
+	  m_integrationMs(DEFAULT_INTEGRATION_MS),
+	  m_integrationMode(CorrelationMeter::Mode::Window),
+	  m_bandCount(0),
+	  m_channels(2),
+	  m_viewMode(ViewMode::Scope),
+	  m_fftSize(DEFAULT_FFT_SIZE),
+	  m_historySeconds(0.0),
+	  m_historyMetric(HistoryMetric::Correlation),
+	  m_scopeMode(ScopeRasterizer::Mode::Lissajous),
+	  m_scopeScale(ScopeRasterizer::Scale::Linear),
+	  m_autoGain(false),
+	  m_scopePair(1),
+	  m_gridCacheValid(false),
+	  m_worker(std::make_unique<AnalysisWorker>(m_registry))
 {
+	// 出力の実サンプルレートを取得
+	audio_t *audio = obs_get_audio();
+	if (audio) {
+		m_sampleRate = audio_output_get_sample_rate(audio);
+		m_channels = static_cast<int>(audio_output_get_channels(audio));
+	}
+
 	setupUI();
+	loadAlarmSettings();
+	publishConfig(true, true);
+
+	// 描画は解析スレッドがフレームを公開したときだけ行う（タイマーで見張らない）
+	// 解析が追いついていなくても、GUIスレッドに積む要求は常に1つまで
+	m_worker->setFrameCallback([this]() {
+		if (!m_repaintQueued.exchange(true, std::memory_order_acq_rel)) {
+			QMetaObject::invokeMethod(this, &PhaseMeterWidget::updateDisplay, Qt::QueuedConnection);
+		}
+	});
+	applyFrameRate();
 
-	// 30FPSに変更（負荷軽減）
-	m_updateTimer->setInterval(33); // 33ms = 30fps
-	connect(m_updateTimer, &QTimer::timeout, this, &PhaseMeterWidget::updateDisplay);
-	m_updateTimer->start();
+	// 取り出し・相関・描画形状の計算は解析スレッドで行う
+	m_worker->start();
 
 	// 非同期処理用のスレッドプールを設定
 	QThreadPool::globalInstance()->setMaxThreadCount(
@@ -57,6 +96,10 @@ PhaseMeterWidget::PhaseMeterWidget(QWidget *parent)
 PhaseMeterWidget::~PhaseMeterWidget()
 {
 	cleanup();
+
+	// 監視コールバックはcleanup()で外したので、ここでソース（とリング）を解放できる
+	QMutexLocker locker(&m_sourcesMutex);
+	m_registry.clear();
 }
 
 void PhaseMeterWidget::setupUI()
@@ -74,105 +117,630 @@ void PhaseMeterWidget::setupUI()
 	m_colorButton = new QPushButton("Color");
 	connect(m_colorButton, &QPushButton::clicked, this, &PhaseMeterWidget::onColorButtonClicked);
 
+	// 統計オーバーレイの表示切替
+	m_statsButton = new QPushButton("Stats");
+	m_statsButton->setCheckable(true);
+	connect(m_statsButton, &QPushButton::toggled, this, &PhaseMeterWidget::onStatsToggled);
+
+	// 表示の目標レート（画面のリフレッシュレートを超えない）
+	m_frameRateCombo = new QComboBox();
+	for (int rate : {15, 30, 60, 120}) {
+		m_frameRateCombo->addItem(QString("%1 fps").arg(rate), rate);
+	}
+	m_frameRateCombo->setCurrentIndex(m_frameRateCombo->findData(DEFAULT_FRAME_RATE_HZ));
+	m_frameRateCombo->setToolTip("Target refresh rate of the meter (limited to the screen's refresh rate)");
+	connect(m_frameRateCombo, QOverload<int>::of(&QComboBox::currentIndexChanged), this,
+		&PhaseMeterWidget::onFrameRateChanged);
+
+	// プログラム出力に出ていないソースは監視しない
+	m_programOnlyCheck = new QCheckBox("Program only");
+	m_programOnlyCheck->setToolTip("Capture only sources that are active in the program output");
+	connect(m_programOnlyCheck, &QCheckBox::toggled, this, &PhaseMeterWidget::onProgramOnlyToggled);
+
 	// 相関値表示ラベル
 	m_correlationLabel = new QLabel("Correlation: 0.00");
 
+	// ソース間の遅延・極性推定。基準をここで選び、Sourceで選んだソースとの差を測る
+	m_delayCombo = new QComboBox();
+	m_delayCombo->addItem("Off");
+	connect(m_delayCombo, QOverload<int>::of(&QComboBox::currentIndexChanged), this,
+		&PhaseMeterWidget::onDelayPairChanged);
+	m_delayLabel = new QLabel();
+
+	// スコープの下に相関などの推移を流す。帯の上でホイールを回しても時間幅を切り替えられる
+	m_historyCombo = new QComboBox();
+	m_historyCombo->addItem("Off", 0.0);
+	m_historyCombo->addItem("10 s", 10.0);
+	m_historyCombo->addItem("1 min", 60.0);
+	m_historyCombo->addItem("10 min", 600.0);
+	m_historyCombo->addItem("1 h", 3600.0);
+	m_historyCombo->addItem("6 h", 21600.0);
+	m_historyCombo->addItem("24 h", 86400.0);
+	m_historyCombo->addItem("72 h", 259200.0);
+	m_historyCombo->setToolTip("Time span of the history strip (scroll over the strip to zoom)");
+	connect(m_historyCombo, QOverload<int>::of(&QComboBox::currentIndexChanged), this,
+		&PhaseMeterWidget::onHistoryChanged);
+
+	m_historyMetricCombo = new QComboBox();
+	m_historyMetricCombo->addItem("Correlation", static_cast<int>(HistoryMetric::Correlation));
+	m_historyMetricCombo->addItem("Width", static_cast<int>(HistoryMetric::Width));
+	m_historyMetricCombo->addItem("Level", static_cast<int>(HistoryMetric::Level));
+	m_historyMetricCombo->setEnabled(false);
+	connect(m_historyMetricCombo, QOverload<int>::of(&QComboBox::currentIndexChanged), this,
+		&PhaseMeterWidget::onHistoryChanged);
+
+	// 相関の積分時間
+	m_integrationCombo = new QComboBox();
+	m_integrationCombo->addItem("100 ms", 100.0);
+	m_integrationCombo->addItem("300 ms", 300.0);
+	m_integrationCombo->addItem("1 s", 1000.0);
+	m_integrationCombo->addItem("3 s", 3000.0);
+	m_integrationCombo->setCurrentIndex(m_integrationCombo->findData(DEFAULT_INTEGRATION_MS));
+	connect(m_integrationCombo, QOverload<int>::of(&QComboBox::currentIndexChanged), this,
+		&PhaseMeterWidget::onIntegrationChanged);
+
+	// 矩形窓の代わりに指数積分（時定数）を使う
+	m_exponentialCheck = new QCheckBox("Exponential");
+	connect(m_exponentialCheck, &QCheckBox::toggled, this, &PhaseMeterWidget::onIntegrationChanged);
+
+	// 帯域別の相関（Linkwitz-Rileyで分割）
+	m_bandsCombo = new QComboBox();
+	m_bandsCombo->addItem("Off", 0);
+	for (int bands : {3, 4, 5, 6, 8}) {
+		m_bandsCombo->addItem(QString("%1 bands").arg(bands), bands);
+	}
+	connect(m_bandsCombo, QOverload<int>::of(&QComboBox::currentIndexChanged), this,
+		&PhaseMeterWidget::onIntegrationChanged);
+
+	// 表示切替（スペクトル表示のときだけFFTを動かす）
+	m_viewCombo = new QComboBox();
+	m_viewCombo->addItem("Scope", static_cast<int>(ViewMode::Scope));
+	m_viewCombo->addItem("Spectrum", static_cast<int>(ViewMode::Spectrum));
+	m_viewCombo->addItem("Grid", static_cast<int>(ViewMode::Grid));
+	if (m_channels >= 3) {
+		m_viewCombo->addItem("Matrix", static_cast<int>(ViewMode::Matrix));
+	}
+	connect(m_viewCombo, QOverload<int>::of(&QComboBox::currentIndexChanged), this,
+		&PhaseMeterWidget::onIntegrationChanged);
+
+	m_fftSizeCombo = new QComboBox();
+	for (size_t size = PhaseSpectrum::MIN_FFT_SIZE; size <= PhaseSpectrum::MAX_FFT_SIZE; size <<= 1) {
+		m_fftSizeCombo->addItem(QString("FFT %1").arg(size), static_cast<int>(size));
+	}
+	m_fftSizeCombo->setCurrentIndex(m_fftSizeCombo->findData(static_cast<int>(DEFAULT_FFT_SIZE)));
+	m_fftSizeCombo->setEnabled(false);
+	connect(m_fftSizeCombo, QOverload<int>::of(&QComboBox::currentIndexChanged), this,
+		&PhaseMeterWidget::onIntegrationChanged);
+
+	// スコープの表示方式（Lissajous / M/Sゴニオメーター）と半径方向の目盛り
+	m_scopeModeCombo = new QComboBox();
+	m_scopeModeCombo->addItem("Lissajous", static_cast<int>(ScopeRasterizer::Mode::Lissajous));
+	m_scopeModeCombo->addItem("Goniometer", static_cast<int>(ScopeRasterizer::Mode::Goniometer));
+	connect(m_scopeModeCombo, QOverload<int>::of(&QComboBox::currentIndexChanged), this,
+		&PhaseMeterWidget::onScopeOptionsChanged);
+
+	m_scopeScaleCombo = new QComboBox();
+	m_scopeScaleCombo->addItem("Linear", static_cast<int>(ScopeRasterizer::Scale::Linear));
+	m_scopeScaleCombo->addItem("dB", static_cast<int>(ScopeRasterizer::Scale::Decibel));
+	connect(m_scopeScaleCombo, QOverload<int>::of(&QComboBox::currentIndexChanged), this,
+		&PhaseMeterWidget::onScopeOptionsChanged);
+
+	// 5.1・7.1ではスコープと2チャンネルの解析に使う組を選ぶ（相関行列のセルをクリックしても選べる）
+	m_scopePairCombo = new QComboBox();
+	const int channels = std::min(m_channels, ChannelMatrix::MAX_CHANNELS);
+	for (int a = 0; a < channels; ++a) {
+		for (int b = a + 1; b < channels; ++b) {
+			const QString label = QString("%1 / %2").arg(channelLabel(m_channels, a));
+			m_scopePairCombo->addItem(label.arg(channelLabel(m_channels, b)), (a << 16) | b);
+		}
+	}
+	m_scopePairCombo->setToolTip("Channel pair shown on the scope and used for correlation, bands and history");
+	m_scopePairCombo->setVisible(m_channels >= 3);
+	connect(m_scopePairCombo, QOverload<int>::of(&QComboBox::currentIndexChanged), this,
+		&PhaseMeterWidget::onScopeOptionsChanged);
+
+	// 小さい音でも表示いっぱいに広がるようにピークを追従してゲインを上げる
+	m_autoGainCheck = new QCheckBox("Auto gain");
+	connect(m_autoGainCheck, &QCheckBox::toggled, this, &PhaseMeterWidget::onScopeOptionsChanged);
+
+	m_optionsLayout = new QHBoxLayout();
+	m_optionsLayout->addWidget(new QLabel("Integration:"));
+	m_optionsLayout->addWidget(m_integrationCombo);
+	m_optionsLayout->addWidget(m_exponentialCheck);
+	m_optionsLayout->addWidget(m_bandsCombo);
+	m_optionsLayout->addSpacing(8);
+	m_optionsLayout->addWidget(m_viewCombo);
+	m_optionsLayout->addWidget(m_fftSizeCombo);
+	m_optionsLayout->addSpacing(8);
+	m_optionsLayout->addWidget(new QLabel("Scope:"));
+	m_optionsLayout->addWidget(m_scopeModeCombo);
+	m_optionsLayout->addWidget(m_scopeScaleCombo);
+	m_optionsLayout->addWidget(m_scopePairCombo);
+	m_optionsLayout->addWidget(m_autoGainCheck);
+	m_optionsLayout->addStretch();
+
 	m_controlLayout->addWidget(new QLabel("Source:"));
 	m_controlLayout->addWidget(m_sourceCombo);
 	m_controlLayout->addWidget(m_colorButton);
+	m_controlLayout->addWidget(m_statsButton);
+	m_controlLayout->addWidget(m_frameRateCombo);
+	m_controlLayout->addWidget(m_programOnlyCheck);
 	m_controlLayout->addStretch();
 	m_controlLayout->addWidget(m_correlationLabel);
 
+	m_delayLayout = new QHBoxLayout();
+	m_delayLayout->addWidget(new QLabel("Delay reference:"));
+	m_delayLayout->addWidget(m_delayCombo);
+	m_delayLayout->addWidget(m_delayLabel);
+	m_delayLayout->addStretch();
+	m_delayLayout->addWidget(new QLabel("History:"));
+	m_delayLayout->addWidget(m_historyCombo);
+	m_delayLayout->addWidget(m_historyMetricCombo);
+
+	// 選択中のソースの逆相警告。判定は音声スレッドで行うので、ドックを隠していても働く
+	m_alarmCheck = new QCheckBox("Phase alarm");
+	m_alarmCheck->setToolTip("Warn when the selected source stays out of phase, even while the dock is hidden");
+	connect(m_alarmCheck, &QCheckBox::toggled, this, &PhaseMeterWidget::onAlarmSettingsChanged);
+
+	m_alarmThresholdSpin = new QDoubleSpinBox();
+	m_alarmThresholdSpin->setPrefix("below ");
+	m_alarmThresholdSpin->setRange(-1.0, 0.9);
+	m_alarmThresholdSpin->setSingleStep(0.05);
+	m_alarmThresholdSpin->setDecimals(2);
+	m_alarmThresholdSpin->setValue(PhaseAlarmSettings().threshold);
+	m_alarmThresholdSpin->setKeyboardTracking(false);
+	connect(m_alarmThresholdSpin, QOverload<double>::of(&QDoubleSpinBox::valueChanged), this,
+		&PhaseMeterWidget::onAlarmSettingsChanged);
+
+	m_alarmHoldSpin = new QSpinBox();
+	m_alarmHoldSpin->setPrefix("for ");
+	m_alarmHoldSpin->setSuffix(" ms");
+	m_alarmHoldSpin->setRange(100, 60000);
+	m_alarmHoldSpin->setSingleStep(100);
+	m_alarmHoldSpin->setValue(static_cast<int>(PhaseAlarmSettings().holdMs));
+	m_alarmHoldSpin->setKeyboardTracking(false);
+	connect(m_alarmHoldSpin, QOverload<int>::of(&QSpinBox::valueChanged), this,
+		&PhaseMeterWidget::onAlarmSettingsChanged);
+
+	// 警告中のソース名（どれも警告していなければ隠す）
+	m_alarmLabel = new QLabel();
+	m_alarmLabel->setStyleSheet("QLabel { background-color: #b00020; color: white; padding: 1px 6px; }");
+	m_alarmLabel->hide();
+
+	m_alarmLayout = new QHBoxLayout();
+	m_alarmLayout->addWidget(m_alarmCheck);
+	m_alarmLayout->addWidget(m_alarmThresholdSpin);
+	m_alarmLayout->addWidget(m_alarmHoldSpin);
+	m_alarmLayout->addStretch();
+	m_alarmLayout->addWidget(m_alarmLabel);
+	updateAlarmControls();
+
 	m_mainLayout->addLayout(m_controlLayout);
+	m_mainLayout->addLayout(m_optionsLayout);
+	m_mainLayout->addLayout(m_delayLayout);
+	m_mainLayout->addLayout(m_alarmLayout);
 	m_mainLayout->addStretch();
 
 	setMinimumSize(300, 350);
 }
 
-void PhaseMeterWidget::addAudioSource(const QString &name, const QColor &color)
+AudioSource *PhaseMeterWidget::addAudioSource(const QString &uuid, const QString &name, const QColor &color)
 {
 	if (m_isDestroying)
-		return;
+		return nullptr;
 
 	QMutexLocker locker(&m_sourcesMutex);
 
-	// 既に存在するかチェック
-	auto it = std::find_if(m_audioSources.begin(), m_audioSources.end(),
-			       [&name](const auto &source) { return source->name == name; });
+	// 一覧へ公開する前に設定を済ませる（既に存在する場合はそのまま返す）
+	bool added = false;
+	AudioSource *source = m_registry.add(uuid, name, color, scopeWindowFrames(), [&](AudioSource &created) {
+		prepareSource(created, uuid, name);
+		added = true;
+	});
+	if (!added) {
+		return source;
+	}
 
-	if (it == m_audioSources.end()) {
-		auto source = std::make_unique<AudioSource>(name, color);
-		m_audioSources.push_back(std::move(source));
+	m_worker->requestPublish();
+	const int slot = source->slot;
 
-		// UIの更新はメインスレッドで実行
-		QMetaObject::invokeMethod(
-			this,
-			[this, name]() {
-				if (!m_isDestroying && m_sourceCombo) {
-					m_sourceCombo->addItem(name);
-				}
-			},
-			Qt::QueuedConnection);
+	// UIの更新はメインスレッドで実行（コンボの項目データにスロット番号を持たせる）
+	QMetaObject::invokeMethod(
+		this,
+		[this, slot]() {
+			if (!m_isDestroying && m_sourceCombo) {
+				syncSourceItems(slot);
+				emit captureDemandChanged();
+			}
+		},
+		Qt::QueuedConnection);
+
+	return source;
+}
+
+size_t PhaseMeterWidget::addAudioSources(const std::vector<SourceInfo> &sources)
+{
+	if (m_isDestroying)
+		return 0;
+
+	size_t added;
+	{
+		QMutexLocker locker(&m_sourcesMutex);
+		added = m_registry.addAll(sources, scopeWindowFrames(),
+					  [this](AudioSource &created, const SourceInfo &info) {
+						  prepareSource(created, info.uuid, info.name);
+					  });
+	}
+	if (added == 0) {
+		return 0;
 	}
+
+	m_worker->requestPublish();
+	refreshAudioSources();
+	emit captureDemandChanged();
+	return added;
 }
 
-void PhaseMeterWidget::removeAudioSource(const QString &name)
+// 一覧へ公開する前の設定（m_sourcesMutexを持って呼ぶ）
+void PhaseMeterWidget::prepareSource(AudioSource &created, const QString &uuid, const QString &name)
+{
+	created.channels = m_channels; // 音声スレッドが読むので、監視コールバックを付ける前に決める
+	created.configure(m_sourceConfig, nullptr);
+	created.recorder = &m_recorder;
+	created.clock = &m_worker->clock();
+	created.alarm.setNotify(&m_alarmPending);
+	auto alarm = m_alarmSettings.constFind(uuid);
+	if (alarm != m_alarmSettings.constEnd()) {
+		created.alarm.setSettings(alarm.value());
+	}
+	m_recorder.recordSource(created.slot, uuid.toStdString(), name.toStdString());
+}
+
+// コンボのslotの項目を、いまの一覧に合わせる（GUIスレッド）
+// 追加・削除・名前変更の通知は後から届くので、届いた時点の一覧を正とする
+// シーンコレクションの切り替えでは、古いソースの削除の通知が届く前に、同じスロットへ新しいソースが入っている
+void PhaseMeterWidget::syncSourceItems(int slot)
+{
+	const SourceSnapshot sources = m_registry.snapshot();
+	const SourceEntry *entry = sources->at(slot);
+	for (QComboBox *combo : {m_sourceCombo, m_delayCombo}) {
+		const int index = combo->findData(slot);
+		if (!entry) {
+			if (index > 0) {
+				combo->removeItem(index);
+			}
+		} else if (index > 0) {
+			combo->setItemText(index, entry->name);
+		} else {
+			combo->addItem(entry->name, slot);
+		}
+	}
+}
+
+void PhaseMeterWidget::removeAudioSource(const QString &uuid)
 {
 	if (m_isDestroying)
 		return;
 
 	QMutexLocker locker(&m_sourcesMutex);
 
-	auto it = std::find_if(m_audioSources.begin(), m_audioSources.end(),
-			       [&name](const auto &source) { return source->name == name; });
-
-	if (it != m_audioSources.end()) {
-		m_audioSources.erase(it);
+	const int slot = m_registry.remove(uuid);
+	if (slot >= 0) {
+		m_worker->requestPublish();
 
 		// UIの更新はメインスレッドで実行
 		QMetaObject::invokeMethod(
 			this,
-			[this, name]() {
+			[this, slot]() {
 				if (!m_isDestroying && m_sourceCombo) {
-					for (int i = 1; i < m_sourceCombo->count(); ++i) {
-						if (m_sourceCombo->itemText(i) == name) {
-							m_sourceCombo->removeItem(i);
-							break;
-						}
-					}
+					syncSourceItems(slot);
+					updateAlarmLabel(); // 警告中のソースが消えた
 				}
 			},
 			Qt::QueuedConnection);
 	}
 }
 
-void PhaseMeterWidget::updateAudioData(const QString &sourceName, const float *left, const float *right, size_t frames)
+void PhaseMeterWidget::renameAudioSource(const QString &uuid, const QString &newName)
+{
+	if (m_isDestroying)
+		return;
+
+	QMutexLocker locker(&m_sourcesMutex);
+
+	// 識別はUUIDで行うので、名前変更はラベルの更新だけで済む
+	int slot = -1;
+	const bool found = m_registry.modify(uuid, [&](SourceEntry &entry) {
+		entry.name = newName;
+		slot = entry.source->slot;
+	});
+	if (!found) {
+		return;
+	}
+	m_worker->requestPublish();
+	m_recorder.recordSource(slot, uuid.toStdString(), newName.toStdString());
+
+	QMetaObject::invokeMethod(
+		this,
+		[this, slot]() {
+			if (!m_isDestroying && m_sourceCombo) {
+				syncSourceItems(slot);
+			}
+		},
+		Qt::QueuedConnection);
+}
+
+// 音声コールバック以外からデータを流し込む場合に使う
+// リングは単一生産者なので、同じソースに対してコールバックと併用しないこと
+void PhaseMeterWidget::updateAudioData(const QString &uuid, const float *left, const float *right, size_t frames)
 {
 	if (m_isDestroying || !left || !right || frames == 0)
 		return;
 
-	// フレーム数を制限（メモリ使用量とCPU負荷を軽減）
-	const size_t maxFrames = 1024;
-	size_t actualFrames = std::min(frames, maxFrames);
+	AudioSource *source = getCaptureSource(uuid);
+	if (source) {
+		source->push(left, right, frames);
+	}
+}
 
-	QMutexLocker locker(&m_sourcesMutex);
+bool PhaseMeterWidget::startRecording(const QString &path, QString &error)
+{
+	std::string reason;
+	if (!m_recorder.start(path.toStdString(), m_sampleRate, reason)) {
+		error = QString::fromStdString(reason);
+		return false;
+	}
+
+	// 記録開始前から登録されているソースの対応を書いておく（以降の追加・名前変更はその都度書く）
+	m_registry.snapshot()->forEach([this](const SourceEntry &entry) {
+		m_recorder.recordSource(entry.source->slot, entry.source->uuid.toStdString(), entry.name.toStdString());
+	});
+
+	blog(LOG_INFO, "Phase Meter: Recording capture to %s", path.toUtf8().constData());
+	return true;
+}
+
+void PhaseMeterWidget::stopRecording()
+{
+	if (!m_recorder.isRecording()) {
+		return;
+	}
+
+	m_recorder.stop();
+	blog(LOG_INFO, "Phase Meter: Recording stopped (%llu blocks, %llu dropped, %llu bytes)",
+	     static_cast<unsigned long long>(m_recorder.recordedBlocks()),
+	     static_cast<unsigned long long>(m_recorder.droppedBlocks()),
+	     static_cast<unsigned long long>(m_recorder.bytesWritten()));
+}
+
+bool PhaseMeterWidget::startReplay(const QString &path, QString &error)
+{
+	if (m_replaying.load()) {
+		error = "already replaying";
+		return false;
+	}
+	if (m_replayThread.joinable()) {
+		m_replayThread.join(); // 最後まで再生し終えたスレッド
+	}
+
+	auto replay = std::make_shared<CaptureReplay>();
+	std::string reason;
+	if (!replay->open(path.toStdString(), reason)) {
+		error = QString::fromStdString(reason);
+		return false;
+	}
+	if (replay->sampleRate() != m_sampleRate) {
+		blog(LOG_WARNING, "Phase Meter: Capture was recorded at %u Hz, output is %u Hz", replay->sampleRate(),
+		     m_sampleRate);
+	}
+
+	blog(LOG_INFO, "Phase Meter: Replaying capture %s", path.toUtf8().constData());
+	m_replayStop.store(false);
+	m_replaying.store(true);
+	m_replayThread = std::thread([this, replay]() {
+		runReplay(*replay);
+		m_replaying.store(false);
+	});
+	return true;
+}
+
+void PhaseMeterWidget::stopReplay()
+{
+	m_replayStop.store(true);
+	if (m_replayThread.joinable()) {
+		m_replayThread.join();
+	}
+}
 
-	auto it = std::find_if(m_audioSources.begin(), m_audioSources.end(),
-			       [&sourceName](const auto &source) { return source->name == sourceName; });
+// 再生スレッド: 記録されたソースを別UUIDで登録し、ブロックを記録時の間隔でリングへ書き込む
+// 各ソースのリングへ書き込むのはこのスレッドだけなので、単一生産者の前提は崩れない
+void PhaseMeterWidget::runReplay(const CaptureReplay &replay)
+{
+	std::vector<AudioSource *> targets; // 記録時のスロット → 再生用のソース
+	QStringList uuids;
+
+	const bool finished = replay.play(
+		CaptureReplay::Pace::RealTime,
+		[&](const ReplaySource &recorded) {
+			if (recorded.slot < 0) {
+				return;
+			}
+			const QString uuid = REPLAY_UUID_PREFIX + QString::fromStdString(recorded.uuid);
+			const QString name = QString("[Replay] %1").arg(QString::fromStdString(recorded.name));
+			AudioSource *source =
+				addAudioSource(uuid, name, QColor::fromHsv((recorded.slot * 67) % 360, 255, 255));
+			if (targets.size() <= static_cast<size_t>(recorded.slot)) {
+				targets.resize(recorded.slot + 1, nullptr);
+			}
+			targets[recorded.slot] = source;
+			if (source && !uuids.contains(uuid)) {
+				uuids.append(uuid);
+			}
+		},
+		[&](const ReplayBlock &block) {
+			AudioSource *target = static_cast<size_t>(block.slot) < targets.size() ? targets[block.slot]
+											       : nullptr;
+			if (target) {
+				target->push(block.left, block.right, block.frames, block.timestampNs);
+			}
+			return true;
+		},
+		&m_replayStop);
 
-	if (it != m_audioSources.end()) {
-		auto &source = *it;
-		QMutexLocker dataLocker(&source->dataMutex);
+	for (const QString &uuid : uuids) {
+		removeAudioSource(uuid);
+	}
+	blog(LOG_INFO, "Phase Meter: Replay %s", finished ? "finished" : "stopped");
+}
 
-		// データをコピー（安全に、サイズ制限付き）
-		try {
-			source->leftChannel.assign(left, left + actualFrames);
-			source->rightChannel.assign(right, right + actualFrames);
-			m_needsUpdate = true; // 更新フラグを設定
-		} catch (...) {
-			// メモリエラーを無視
+void PhaseMeterWidget::attachTap(const QString &uuid, const std::shared_ptr<PhaseTap> &tap)
+{
+	if (m_isDestroying || !tap)
+		return;
+
+	{
+		QMutexLocker locker(&m_sourcesMutex);
+		const SourceSnapshot sources = m_registry.snapshot();
+		const SourceEntry *entry = sources->find(uuid);
+		if (!entry || entry->tap == tap) {
+			return;
+		}
+
+		// 警告の設定はフィルター側へ引き継ぐ
+		tap->alarm.configure(m_sampleRate);
+		tap->alarm.setSettings(entry->activeAlarm().settings());
+		tap->alarm.setNotify(&m_alarmPending);
+		tap->setClock(&m_worker->clock());
+		// 付く前に溜まった分は捨てる（解析スレッドはまだこの要約を読んでいない）
+		uint64_t discarded = 0;
+		tap->takeSums(discarded);
+		tap->points().clear();
+		// スコープの点の間隔は解析スレッドが次の周期で合わせる
+		m_registry.modify(uuid, [&tap](SourceEntry &next) { next.tap = tap; });
+		m_worker->requestPublish();
+	}
+
+	// 監視コールバックを外す
+	emit captureDemandChanged();
+}
+
+void PhaseMeterWidget::detachTap(const QString &uuid, const std::shared_ptr<PhaseTap> &tap)
+{
+	if (m_isDestroying)
+		return;
+
+	{
+		QMutexLocker locker(&m_sourcesMutex);
+		const SourceSnapshot sources = m_registry.snapshot();
+		const SourceEntry *entry = sources->find(uuid);
+		if (!entry || entry->tap != tap) {
+			return;
 		}
+
+		// 解析スレッドは古い版を手放すまでフィルターを読み続けるが、要約は版が持っているので解放されない
+		entry->source->alarm.setSettings(tap->alarm.settings());
+		tap->alarm.setNotify(nullptr);
+		tap->setClock(nullptr);
+		m_registry.modify(uuid, [](SourceEntry &next) { next.tap.reset(); });
+		m_worker->requestPublish();
+	}
+
+	// 警告状態を付け直し、監視コールバックに戻す
+	m_alarmPending.store(true, std::memory_order_release);
+	emit captureDemandChanged();
+}
+
+AudioSource *PhaseMeterWidget::getCaptureSource(const QString &uuid) const
+{
+	// 削除はOBSのソース破棄ハンドラで監視コールバックを外した後だけなので、版を手放してもポインタは有効
+	const SourceSnapshot sources = m_registry.snapshot();
+	const SourceEntry *entry = sources->find(uuid);
+	return entry ? entry->source.get() : nullptr;
+}
+
+size_t PhaseMeterWidget::scopeWindowFrames() const
+{
+	return std::max<size_t>(1, static_cast<size_t>(m_sampleRate * SCOPE_WINDOW_MS / 1000.0));
+}
+
+// 解析の設定を作り直して解析スレッドへ渡す（変わった段の版だけ進め、各ソースへの反映は解析スレッドが行う）
+void PhaseMeterWidget::publishConfig(bool analysis, bool scope)
+{
+	QMutexLocker locker(&m_sourcesMutex); // 追加されたソースの初期設定にも使う
+	if (analysis) {
+		m_sourceConfig.analysisVersion++;
+		m_sourceConfig.sampleRate = m_sampleRate;
+		m_sourceConfig.integrationMs = m_integrationMs;
+		m_sourceConfig.integrationMode = m_integrationMode;
+		m_sourceConfig.bandCount = m_bandCount;
+		m_sourceConfig.fftSize = m_viewMode == ViewMode::Spectrum ? m_fftSize : 0;
+	}
+	if (scope) {
+		m_sourceConfig.scopeVersion++;
+		m_sourceConfig.persistenceMs = SCOPE_PERSISTENCE_MS;
+		m_sourceConfig.scopeMode = m_scopeMode;
+		m_sourceConfig.scopeScale = m_scopeScale;
+		m_sourceConfig.autoGain = m_autoGain;
+		m_sourceConfig.scopePair = m_scopePair;
+	}
+	m_worker->setConfig(m_sourceConfig);
+}
+
+void PhaseMeterWidget::onScopeOptionsChanged()
+{
+	if (m_isDestroying)
+		return;
+
+	m_scopeMode = static_cast<ScopeRasterizer::Mode>(m_scopeModeCombo->currentData().toInt());
+	m_scopeScale = static_cast<ScopeRasterizer::Scale>(m_scopeScaleCombo->currentData().toInt());
+	m_autoGain = m_autoGainCheck->isChecked();
+	if (m_scopePairCombo->count() > 0) {
+		m_scopePair = m_scopePairCombo->currentData().toUInt();
 	}
+
+	publishConfig(false, true);
+	m_gridCacheValid = false; // 目盛りとラベルが変わる
+	update(meterRect());
+}
+
+void PhaseMeterWidget::onIntegrationChanged()
+{
+	if (m_isDestroying)
+		return;
+
+	m_integrationMs = m_integrationCombo->currentData().toDouble();
+	m_integrationMode = m_exponentialCheck->isChecked() ? CorrelationMeter::Mode::Exponential
+							    : CorrelationMeter::Mode::Window;
+
+	m_fftSize = static_cast<size_t>(m_fftSizeCombo->currentData().toInt());
+
+	const int bandCount = m_bandsCombo->currentData().toInt();
+	const ViewMode viewMode = static_cast<ViewMode>(m_viewCombo->currentData().toInt());
+	const bool viewChanged = viewMode != m_viewMode;
+	if (bandCount != m_bandCount || viewChanged) {
+		m_bandCount = bandCount;
+		m_viewMode = viewMode;
+		m_fftSizeCombo->setEnabled(m_viewMode == ViewMode::Spectrum);
+		m_gridCacheValid = false; // 帯域バーの分だけスコープの領域が変わる・表示が切り替わる
+		update(meterRect());
+	}
+
+	publishConfig(true, false);
+
+	// グリッドは全ソース、それ以外は選択中のソースだけを監視する
+	if (viewChanged) {
+		emit captureDemandChanged();
+	}
+}
+
+const SourceEntry *PhaseMeterWidget::selectedSource(const SourceList &sources) const
+{
+	// コンボの項目データはレジストリのスロット番号（"All Sources"は無効値）
+	QVariant data = m_sourceCombo->currentData();
+	if (!data.isValid()) {
+		return nullptr;
+	}
+	return sources.at(data.toInt());
 }
 
 void PhaseMeterWidget::paintEvent(QPaintEvent *event)
@@ -180,39 +748,233 @@ void PhaseMeterWidget::paintEvent(QPaintEvent *event)
 	if (m_isDestroying)
 		return;
 
+	const uint64_t paintStart = statNowNs();
+	const AllocScope allocScope(AllocStage::Paint);
+
+	// 再描画はメーター領域に限定しているので、コントロール行は描き直さない
 	QPainter painter(this);
-	painter.setRenderHint(QPainter::Antialiasing);
 
-	QRect meterRect = rect();
-	if (m_controlLayout && m_controlLayout->geometry().isValid()) {
-		meterRect.setTop(m_controlLayout->geometry().bottom() + 10);
+	const QRect meter = meterRect();
+	if (meter.isValid()) {
+		drawPhaseMeter(painter, meter);
+
+		if (m_showStats) {
+			drawStatsOverlay(painter, meter);
+		}
 	}
-	meterRect.adjust(10, 10, -10, -10);
 
-	if (meterRect.isValid()) {
-		drawPhaseMeter(painter, meterRect);
+	const uint64_t paintEnd = statNowNs();
+	statAdd(m_paintStats.paints, 1);
+	statAdd(m_paintStats.paintNs, paintEnd - paintStart);
+
+	// 1秒ごとに描画レートを更新
+	if (paintEnd - m_rateWindowStartNs >= 1000000000ULL) {
+		const uint64_t paints = statGet(m_paintStats.paints);
+		m_paintsPerSecond = (paints - m_rateWindowPaints) * 1e9 / (paintEnd - m_rateWindowStartNs);
+		m_rateWindowStartNs = paintEnd;
+		m_rateWindowPaints = paints;
 	}
 }
 
 void PhaseMeterWidget::updateDisplay()
 {
-	// 更新が必要な場合のみ再描画
-	if (!m_isDestroying && m_needsUpdate && !m_isProcessing) {
-		m_needsUpdate = false;
-		update();
+	// 解析スレッドが新しいフレームを公開したときに呼ばれる
+	m_repaintQueued.store(false, std::memory_order_release);
+	if (m_isDestroying)
+		return;
+
+	// 警告の通知も同じ周期で拾う（音声スレッドが状態を変えていなければ何もしない）
+	checkAlarms();
+
+	// ドックのタブ切り替えはイベントが届かないことがあるので、フレームのついでに表示状態を見張る
+	refreshCaptureDemand();
+
+	// 描画はQtが次の画面の更新にまとめる
+	if (m_worker->hasNewFrame()) {
+		update(meterRect());
+	}
+}
+
+void PhaseMeterWidget::refreshCaptureDemand(bool force)
+{
+	const bool active = !m_isDestroying && isVisible() && !window()->isMinimized();
+	if (active != m_displayActive || force) {
+		m_displayActive = active;
+		applyFrameRate();
+		emit captureDemandChanged();
+	}
+}
+
+void PhaseMeterWidget::applyFrameRate()
+{
+	// 画面のリフレッシュレートより速く解析しても描かれないので、遅い方に合わせる
+	int rate = m_frameRateCombo->currentData().toInt();
+	if (const QScreen *display = screen()) {
+		const int refresh = qRound(display->refreshRate());
+		if (refresh > 0) {
+			rate = std::min(rate, refresh);
+		}
+	}
+	// 隠れている間は警告の通知に足りるだけに間引く
+	if (!m_displayActive) {
+		rate = std::min(rate, OCCLUDED_FRAME_RATE_HZ);
+	}
+	m_worker->clock().setRate(rate);
+}
+
+void PhaseMeterWidget::watchWindow()
+{
+	// ドックを切り離すとトップレベルウィンドウが変わるので、表示のたびに付け替える
+	QWidget *top = window();
+	if (top == m_watchedWindow || top == this) {
+		return;
+	}
+	if (m_watchedWindow) {
+		m_watchedWindow->removeEventFilter(this);
+	}
+	m_watchedWindow = top;
+	top->installEventFilter(this);
+	if (QWindow *handle = top->windowHandle()) {
+		connect(handle, &QWindow::screenChanged, this, &PhaseMeterWidget::applyFrameRate,
+			Qt::UniqueConnection);
+	}
+}
+
+bool PhaseMeterWidget::wantsCapture(int slot) const
+{
+	if (m_isDestroying) {
+		return false;
+	}
+
+	{
+		const SourceSnapshot sources = m_registry.snapshot();
+		const SourceEntry *entry = sources->at(slot);
+		if (!entry || !entry->source->enabled || entry->tap) {
+			return false; // フィルターが付いたソースはフィルターから受け取る
+		}
+		// 逆相警告は誰も見ていないときこそ要るので、ドックが隠れていても監視を続ける
+		if (entry->activeAlarm().settings().enabled) {
+			return true;
+		}
+	}
+
+	if (!m_displayActive) {
+		return false;
+	}
+
+	// グリッドと"All Sources"はすべて、それ以外は選択中のソースと遅延推定の基準だけ
+	const QVariant selected = m_sourceCombo->currentData();
+	if (m_viewMode == ViewMode::Grid || !selected.isValid()) {
+		return true;
+	}
+	const QVariant reference = m_delayCombo->currentData();
+	return slot == selected.toInt() || (reference.isValid() && slot == reference.toInt());
+}
+
+QRect PhaseMeterWidget::meterRect() const
+{
+	QRect meter = rect();
+	if (m_alarmLayout && m_alarmLayout->geometry().isValid()) {
+		meter.setTop(m_alarmLayout->geometry().bottom() + 10);
+	}
+	meter.adjust(10, 10, -10, -10);
+	return meter;
+}
+
+void PhaseMeterWidget::ensureGridCache(const QSize &size)
+{
+	const qreal dpr = devicePixelRatioF();
+	if (m_gridCacheValid && m_gridCache.size() == size * dpr && m_gridCache.devicePixelRatio() == dpr) {
+		return;
+	}
+
+	// 物理ピクセルで確保して、高DPIでもぼやけないようにする
+	m_gridCache = QPixmap(size * dpr);
+	m_gridCache.setDevicePixelRatio(dpr);
+	m_gridCache.fill(Qt::black);
+
+	QPainter cachePainter(&m_gridCache);
+	cachePainter.setRenderHint(QPainter::Antialiasing);
+	cachePainter.setFont(font());
+
+	// グリッド表示ではタイルがそれぞれ目盛りを持つので背景だけ
+	if (m_viewMode == ViewMode::Grid) {
+		m_gridCacheValid = true;
+		return;
+	}
+
+	QRect scope, bands, history;
+	splitMeterRect(QRect(QPoint(0, 0), size), scope, bands, history);
+	if (m_viewMode == ViewMode::Spectrum) {
+		drawSpectrumGrid(cachePainter, scope);
+	} else if (m_viewMode == ViewMode::Matrix) {
+		drawMatrixGrid(cachePainter, scope);
+	} else {
+		drawGrid(cachePainter, scope);
+	}
+	if (bands.isValid()) {
+		drawBandGrid(cachePainter, bands);
+	}
+	if (history.isValid()) {
+		drawHistoryGrid(cachePainter, history);
+	}
+
+	m_gridCacheValid = true;
+}
+
+void PhaseMeterWidget::splitMeterRect(const QRect &rect, QRect &scope, QRect &bands, QRect &history) const
+{
+	// 履歴が有効なら下端に帯を取り、残りの右端に帯域バーの領域を取る
+	scope = rect;
+	bands = QRect();
+	history = QRect();
+	if (m_historySeconds > 0.0 && m_viewMode != ViewMode::Grid && rect.height() > HISTORY_HEIGHT * 2) {
+		history = QRect(rect.left(), rect.bottom() - HISTORY_HEIGHT + 1, rect.width(), HISTORY_HEIGHT);
+		scope.setBottom(history.top() - 1);
+	}
+	if (m_bandCount > 0 && m_viewMode != ViewMode::Grid) {
+		const int width = BAND_SCALE_WIDTH + m_bandCount * BAND_SLOT_WIDTH;
+		bands = QRect(rect.right() - width + 1, scope.top(), width, scope.height());
+		scope.setRight(bands.left() - 1);
 	}
 }
 
 void PhaseMeterWidget::drawPhaseMeter(QPainter &painter, const QRect &rect)
 {
-	// 背景を描画
-	painter.fillRect(rect, Qt::black);
+	// 背景とグリッドはキャッシュを貼るだけ
+	ensureGridCache(rect.size());
+	painter.drawPixmap(rect.topLeft(), m_gridCache);
+
+	if (m_viewMode == ViewMode::Grid) {
+		m_worker->setHistoryView(0, 0);
+		drawGridView(painter, rect);
+		updateDelayDisplay(m_worker->frame());
+		return;
+	}
 
-	// グリッドを描画
-	drawGrid(painter, rect);
+	QRect scope, bands, history;
+	splitMeterRect(rect, scope, bands, history);
+
+	// 履歴は表示1列（論理ピクセル）ごとに1値を読む。列の時間幅は基本点の整数倍に丸める
+	if (history.isValid()) {
+		const int columns = std::max(historyPlot(history).width(), 1);
+		const double points = m_historySeconds * 1000.0 / CorrelationHistory::BASE_INTERVAL_MS;
+		m_worker->setHistoryView(static_cast<size_t>(columns),
+					 static_cast<uint64_t>(std::max(1.0, std::round(points / columns))));
+	} else {
+		m_worker->setHistoryView(0, 0);
+	}
 
-	// 音声データを非同期で処理して描画
-	drawAudioDataAsync(painter, rect);
+	// 解析スレッドが公開した最新フレームを描画（帯域バーと履歴は相関ラベルと同じソースのもの）
+	const SourceFrame *shown = drawAudioFrame(painter, scope);
+	if (shown && bands.isValid()) {
+		drawBandBars(painter, bands, *shown);
+	}
+	if (shown && history.isValid()) {
+		drawHistory(painter, history, *shown);
+	}
+
+	updateDelayDisplay(m_worker->frame());
 }
 
 void PhaseMeterWidget::drawGrid(QPainter &painter, const QRect &rect)
@@ -234,327 +996,1171 @@ void PhaseMeterWidget::drawGrid(QPainter &painter, const QRect &rect)
 			 center.y() + diagonalOffset);
 	painter.drawLine(center.x() - diagonalOffset, center.y() + diagonalOffset, center.x() + diagonalOffset,
 			 center.y() - diagonalOffset);
+
+	// dB目盛りでは -12dB ごとの同心円を描く
+	if (m_scopeScale == ScopeRasterizer::Scale::Decibel) {
+		painter.setPen(QPen(Qt::darkGray, 1, Qt::DotLine));
+		for (float db = -12.0f; db > -ScopeRasterizer::DECIBEL_RANGE; db -= 12.0f) {
+			const int ring = static_cast<int>(radius * (1.0f + db / ScopeRasterizer::DECIBEL_RANGE));
+			painter.drawEllipse(center, ring, ring);
+		}
+	}
+
+	// ゴニオメーターでは軸の意味が変わるのでラベルを付ける（上がMid、左上がL、右上がR）
+	if (m_scopeMode == ScopeRasterizer::Mode::Goniometer) {
+		painter.setPen(Qt::gray);
+		const int labelOffset = diagonalOffset + 8;
+		painter.drawText(QRect(center.x() - 10, center.y() - radius - 16, 20, 14), Qt::AlignCenter, "M");
+		painter.drawText(QRect(center.x() - labelOffset - 10, center.y() - labelOffset - 7, 20, 14),
+				 Qt::AlignCenter, "L");
+		painter.drawText(QRect(center.x() + labelOffset - 10, center.y() - labelOffset - 7, 20, 14),
+				 Qt::AlignCenter, "R");
+		painter.drawText(QRect(center.x() - radius - 18, center.y() - 7, 16, 14), Qt::AlignCenter, "-S");
+		painter.drawText(QRect(center.x() + radius + 2, center.y() - 7, 16, 14), Qt::AlignCenter, "+S");
+	}
 }
 
-void PhaseMeterWidget::drawAudioDataAsync(QPainter &painter, const QRect &rect)
+const SourceFrame *PhaseMeterWidget::drawAudioFrame(QPainter &painter, const QRect &rect)
 {
-	if (m_isProcessing)
-		return;
+	// 新しいフレームがあれば受け取る（無ければ前回のフレームをそのまま描く）
+	m_worker->acquireFrame();
+	const AnalysisFrame &frame = m_worker->frame();
 
 	QPoint center = rect.center();
 	int radius = std::min(rect.width(), rect.height()) / 2 - 20;
-	int selectedIndex = m_sourceCombo->currentIndex();
-
-	std::vector<RenderData> renderData;
-
-	{
-		QMutexLocker locker(&m_sourcesMutex);
+	if (radius <= 0) {
+		return nullptr;
+	}
+	const QRect target(center.x() - radius, center.y() - radius, radius * 2, radius * 2);
+
+	// スコープ画像の解像度を表示サイズ（物理ピクセル）に合わせる。反映は次の解析から
+	m_worker->setRasterSize(static_cast<int>(radius * 2 * devicePixelRatioF()));
+
+	// コンボの項目データはスロット番号（"All Sources"は無効値）
+	QVariant selected = m_sourceCombo->currentData();
+	const int selectedSlot = selected.isValid() ? selected.toInt() : -1;
+
+	// 複数ソースを重ねるときは加算合成にして、重なった部分が明るくなるようにする
+	painter.save();
+	painter.setCompositionMode(QPainter::CompositionMode_Plus);
+	painter.setRenderHint(QPainter::SmoothPixmapTransform);
+
+	const SourceFrame *labelSource = nullptr;
+	int count = 0;
+	for (size_t i = 0; i < frame.count; ++i) {
+		const SourceFrame &source = frame.sources[i];
+		if (!source.enabled || !source.hasAudio) {
+			continue;
+		}
 
-		if (selectedIndex == 0) { // All Sources
-			int count = 0;
-			for (const auto &source : m_audioSources) {
-				if (source->enabled && count < 3) {
-					QMutexLocker dataLocker(&source->dataMutex);
-					if (!source->leftChannel.empty() && !source->rightChannel.empty()) {
-						renderData.emplace_back(*source);
-						count++;
-					}
-				}
+		if (selectedSlot < 0) { // All Sources
+			if (count >= 3) {
+				break;
 			}
-		} else if (selectedIndex > 0 && selectedIndex - 1 < static_cast<int>(m_audioSources.size())) {
-			const auto &source = m_audioSources[selectedIndex - 1];
-			if (source->enabled) {
-				QMutexLocker dataLocker(&source->dataMutex);
-				if (!source->leftChannel.empty() && !source->rightChannel.empty()) {
-					renderData.emplace_back(*source);
-				}
+			if (m_viewMode == ViewMode::Scope) {
+				drawSourceFrame(painter, source, target);
 			}
+			labelSource = &source;
+			count++;
+		} else if (source.slot == selectedSlot) {
+			if (m_viewMode == ViewMode::Scope) {
+				drawSourceFrame(painter, source, target);
+			}
+			labelSource = &source;
+			break;
 		}
 	}
 
-	// Synchronous processing and drawing for debugging
-	for (const auto &data : renderData) {
-		ProcessedAudioData result = processAudioSourceData(data, center, radius);
-		drawProcessedAudioSource(painter, result);
+	painter.restore();
+
+	// スペクトルは重ねると読めないので、相関ラベルと同じ1ソースだけ描く
+	if (m_viewMode == ViewMode::Spectrum && labelSource && labelSource->hasSpectrum) {
+		drawSpectrum(painter, rect, *labelSource);
+	}
+
+	if (m_viewMode == ViewMode::Matrix && labelSource && labelSource->matrixChannels > 0) {
+		drawMatrix(painter, rect, *labelSource);
+	}
+
+	// 相関値は最後に描いたソースのものを表示する
+	if (labelSource) {
+		updateCorrelationDisplay(labelSource->correlation);
 	}
+	return labelSource;
 }
 
-std::vector<std::future<PhaseMeterWidget::ProcessedAudioData>>
-PhaseMeterWidget::processAudioSourcesParallel(const std::vector<RenderData> &renderData, const QPoint &center,
-					      int radius)
+void PhaseMeterWidget::spectrumPanels(const QRect &rect, QRect &mono, QRect &phase) const
 {
+	// 上段にモノラル損失、下段に位相差。左に目盛り、下に周波数ラベルの余白を取る
+	const QRect plot = rect.adjusted(34, 16, -10, -22);
+	const int monoHeight = plot.height() * 2 / 5;
+	mono = QRect(plot.left(), plot.top(), plot.width(), monoHeight);
+	phase = QRect(plot.left(), mono.bottom() + 18, plot.width(), plot.bottom() - mono.bottom() - 18);
+}
 
-	std::vector<std::future<ProcessedAudioData>> futures;
+void PhaseMeterWidget::drawSpectrumGrid(QPainter &painter, const QRect &rect)
+{
+	QRect mono, phase;
+	spectrumPanels(rect, mono, phase);
+	if (mono.height() <= 0 || phase.height() <= 0) {
+		return;
+	}
 
-	// 各ソースを並列で処理
-	for (const auto &data : renderData) {
-		auto future = std::async(std::launch::async, [=, &data]() -> ProcessedAudioData {
-			return processAudioSourceData(data, center, radius);
-		});
-		futures.push_back(std::move(future));
+	QFont font = painter.font();
+	font.setPointSizeF(7.0);
+	painter.setFont(font);
+
+	painter.setPen(QPen(Qt::darkGray, 1));
+	painter.drawRect(mono);
+	painter.drawRect(phase);
+
+	// 周波数の目盛り（列は20Hz〜20kHzの対数軸）
+	const double lowest = PhaseSpectrum::columnEdge(0);
+	const double logRange = std::log(PhaseSpectrum::columnEdge(PhaseSpectrum::COLUMNS) / lowest);
+	for (double frequency : {100.0, 1000.0, 10000.0}) {
+		const int x = mono.left() + static_cast<int>(mono.width() * std::log(frequency / lowest) / logRange);
+		painter.setPen(QPen(Qt::darkGray, 1, Qt::DotLine));
+		painter.drawLine(x, mono.top(), x, mono.bottom());
+		painter.drawLine(x, phase.top(), x, phase.bottom());
+		painter.setPen(Qt::gray);
+		const QString label = frequency >= 1000.0 ? QString("%1k").arg(frequency / 1000.0)
+							  : QString::number(frequency);
+		painter.drawText(QRect(x - 20, phase.bottom() + 2, 40, 16), Qt::AlignCenter, label);
 	}
 
-	return futures;
+	// 横方向の目盛り
+	const int scaleFlags = Qt::AlignRight | Qt::AlignVCenter;
+	const int scaleLeft = rect.left();
+	const int scaleWidth = mono.left() - rect.left() - 3;
+	painter.setPen(QPen(Qt::darkGray, 1, Qt::DotLine));
+	painter.drawLine(mono.left(), mono.center().y(), mono.right(), mono.center().y());
+	painter.drawLine(phase.left(), phase.center().y(), phase.right(), phase.center().y());
+
+	painter.setPen(Qt::gray);
+	painter.drawText(QRect(scaleLeft, mono.top() - 7, scaleWidth, 14), scaleFlags, "0");
+	painter.drawText(QRect(scaleLeft, mono.center().y() - 7, scaleWidth, 14), scaleFlags,
+			 QString::number(-SPECTRUM_MONO_RANGE_DB / 2.0f));
+	painter.drawText(QRect(scaleLeft, mono.bottom() - 7, scaleWidth, 14), scaleFlags,
+			 QString::number(-SPECTRUM_MONO_RANGE_DB));
+	painter.drawText(QRect(scaleLeft, phase.top() - 7, scaleWidth, 14), scaleFlags, "+180");
+	painter.drawText(QRect(scaleLeft, phase.center().y() - 7, scaleWidth, 14), scaleFlags, "0");
+	painter.drawText(QRect(scaleLeft, phase.bottom() - 7, scaleWidth, 14), scaleFlags, "-180");
+
+	painter.drawText(QRect(mono.left(), mono.top() - 15, mono.width(), 14), Qt::AlignLeft | Qt::AlignVCenter,
+			 "Mono loss (dB)");
+	painter.drawText(QRect(phase.left(), phase.top() - 15, phase.width(), 14), Qt::AlignLeft | Qt::AlignVCenter,
+			 "Phase L-R (deg)");
 }
 
-PhaseMeterWidget::ProcessedAudioData PhaseMeterWidget::processAudioSourceData(const RenderData &data,
-									      const QPoint &center, int radius)
+void PhaseMeterWidget::drawSpectrum(QPainter &painter, const QRect &rect, const SourceFrame &source)
 {
+	QRect mono, phase;
+	spectrumPanels(rect, mono, phase);
+	if (mono.height() <= 0 || phase.height() <= 0) {
+		return;
+	}
 
-	ProcessedAudioData result;
-	result.color = data.color;
-	result.correlation = 0.0f;
-
-	// サンプル数を制限
-	const size_t maxSamples = 512;
-	size_t sampleCount = std::min(data.leftChannel.size(), maxSamples);
+	const int columns = PhaseSpectrum::COLUMNS;
+	for (int c = 0; c < columns; ++c) {
+		const float level = source.spectrumLevel[c];
+		if (level < SPECTRUM_GATE_DB) {
+			continue; // 無音に近い帯域の位相は意味を持たない
+		}
 
-	if (sampleCount == 0)
-		return result;
+		const int left = mono.left() + mono.width() * c / columns;
+		const int width = std::max(1, mono.left() + mono.width() * (c + 1) / columns - left - 1);
+		// レベルが低い列ほど暗くする
+		const int alpha = 80 + static_cast<int>(175.0f * std::min(1.0f, (level - SPECTRUM_GATE_DB) / 40.0f));
+
+		// モノラル損失: 上端（0dB）から下へ伸ばす。損失が大きいほど赤く
+		const float loss = std::clamp(-source.spectrumMono[c] / SPECTRUM_MONO_RANGE_DB, 0.0f, 1.0f);
+		QColor monoColor = QColor::fromHsvF((1.0f - loss) * (120.0f / 360.0f), 0.85f, 0.9f);
+		monoColor.setAlpha(alpha);
+		const int lossHeight = std::max(1, static_cast<int>(loss * (mono.height() - 1)));
+		painter.fillRect(QRect(left, mono.top() + 1, width, lossHeight), monoColor);
+
+		// 位相差: 0度で中央。±180度に近いほど赤く
+		const float degrees = source.spectrumPhase[c];
+		const int y = phase.center().y() - static_cast<int>(degrees / 180.0f * (phase.height() / 2));
+		const float inPhase = 1.0f - std::fabs(degrees) / 180.0f;
+		QColor phaseColor = QColor::fromHsvF(inPhase * (120.0f / 360.0f), 0.85f, 0.9f);
+		phaseColor.setAlpha(alpha);
+		painter.fillRect(QRect(left, y - 1, width, 3), phaseColor);
+	}
+}
 
-	// 並列で相関値を計算
-	result.correlation = calculateCorrelationParallel(data.leftChannel, data.rightChannel, sampleCount);
+QRect PhaseMeterWidget::matrixCells(const QRect &rect, int &cell) const
+{
+	// 左に行ラベル、上に列ラベル、下にファントムセンターの行を取り、残りに正方形のセルを並べる
+	const int channels = std::min(m_channels, ChannelMatrix::MAX_CHANNELS);
+	const QRect area = rect.adjusted(MATRIX_LABEL_WIDTH, MATRIX_LABEL_HEIGHT, -10, -MATRIX_FOOTER_HEIGHT);
+	cell = channels > 0 ? std::min(area.width(), area.height()) / channels : 0;
+	if (cell <= 0) {
+		return QRect();
+	}
+	const int size = cell * channels;
+	return QRect(area.left() + (area.width() - size) / 2, area.top() + (area.height() - size) / 2, size, size);
+}
 
-	// 並列でフェーズポイントを計算
-	result.points = calculatePhasePointsParallel(data.leftChannel, data.rightChannel, center, radius, sampleCount);
+void PhaseMeterWidget::drawMatrixGrid(QPainter &painter, const QRect &rect)
+{
+	int cell = 0;
+	const QRect cells = matrixCells(rect, cell);
+	if (!cells.isValid()) {
+		return;
+	}
+	const int channels = cells.width() / cell;
+
+	QFont font = painter.font();
+	font.setPointSizeF(8.0);
+	painter.setFont(font);
+
+	painter.setPen(Qt::gray);
+	const int rowLabelLeft = cells.left() - MATRIX_LABEL_WIDTH;
+	const int columnLabelTop = cells.top() - MATRIX_LABEL_HEIGHT;
+	for (int i = 0; i < channels; ++i) {
+		const QString label = channelLabel(m_channels, i);
+		const int offset = i * cell;
+		painter.drawText(QRect(rowLabelLeft, cells.top() + offset, MATRIX_LABEL_WIDTH - 4, cell),
+				 Qt::AlignRight | Qt::AlignVCenter, label);
+		painter.drawText(QRect(cells.left() + offset, columnLabelTop, cell, MATRIX_LABEL_HEIGHT),
+				 Qt::AlignCenter, label);
+	}
 
-	return result;
+	painter.setPen(QPen(Qt::darkGray, 1));
+	for (int i = 0; i <= channels; ++i) {
+		const int x = cells.left() + i * cell;
+		const int y = cells.top() + i * cell;
+		painter.drawLine(x, cells.top(), x, cells.top() + cells.height());
+		painter.drawLine(cells.left(), y, cells.left() + cells.width(), y);
+	}
 }
 
-float PhaseMeterWidget::calculateCorrelationParallel(const std::vector<float> &left, const std::vector<float> &right,
-						     size_t sampleCount)
+void PhaseMeterWidget::drawMatrix(QPainter &painter, const QRect &rect, const SourceFrame &source)
 {
+	int cell = 0;
+	const QRect cells = matrixCells(rect, cell);
+	const int channels = std::min(source.matrixChannels, cells.isValid() ? cells.width() / cell : 0);
+	if (channels <= 0) {
+		return;
+	}
 
-	if (sampleCount < 4) {
-		// サンプル数が少ない場合は逐次処理
-		return calculateCorrelationSequential(left, right, sampleCount);
+	QFont font = painter.font();
+	font.setPointSizeF(7.0);
+	painter.setFont(font);
+	const bool showValues = cell >= 28;
+
+	// 行列は対称なので上三角の値を両側に描く。対角はそのチャンネルのレベル
+	for (int a = 0; a < channels; ++a) {
+		for (int b = 0; b < channels; ++b) {
+			const QRect box(cells.left() + b * cell + 1, cells.top() + a * cell + 1, cell - 1, cell - 1);
+			const float value = source.matrix[ChannelMatrix::pairIndex(std::min(a, b), std::max(a, b))];
+			const bool silent = source.matrix[ChannelMatrix::pairIndex(a, a)] < MATRIX_GATE_DB ||
+					    source.matrix[ChannelMatrix::pairIndex(b, b)] < MATRIX_GATE_DB;
+			QColor color;
+			QString text;
+			if (a == b) {
+				const float shade = std::clamp(1.0f + value / MATRIX_LEVEL_RANGE_DB, 0.0f, 1.0f);
+				color = QColor::fromHsvF(0.0f, 0.0f, 0.15f + 0.6f * shade);
+				text = silent ? QString() : QString::number(value, 'f', 0);
+			} else if (silent) {
+				color = QColor(40, 40, 40);
+			} else {
+				// +1で緑、0で黄、-1で赤
+				color = QColor::fromHsvF((value + 1.0f) / 2.0f * (120.0f / 360.0f), 0.85f, 0.9f);
+				text = QString::number(value, 'f', 2);
+			}
+			painter.fillRect(box, color);
+			if (showValues && !text.isEmpty()) {
+				painter.setPen(Qt::black);
+				painter.drawText(box, Qt::AlignCenter, text);
+			}
+		}
 	}
 
-	// 並列でドット積と二乗和を計算
-	const size_t numThreads = std::min(sampleCount / 128, static_cast<size_t>(std::thread::hardware_concurrency()));
-	const size_t chunkSize = sampleCount / numThreads;
+	// スコープに出している組を囲む
+	const int pairLeft = static_cast<int>(m_scopePair >> 16);
+	const int pairRight = static_cast<int>(m_scopePair & 0xFFFFu);
+	if (pairLeft < channels && pairRight < channels) {
+		painter.setPen(QPen(Qt::white, 2));
+		painter.drawRect(QRect(cells.left() + pairRight * cell, cells.top() + pairLeft * cell, cell, cell));
+		painter.drawRect(QRect(cells.left() + pairLeft * cell, cells.top() + pairRight * cell, cell, cell));
+	}
 
-	std::vector<std::future<std::tuple<float, float, float>>> futures;
+	if (centerChannel(channels) >= 0) {
+		painter.setPen(Qt::gray);
+		painter.drawText(QRect(cells.left(), cells.bottom() + 4, cells.width(), MATRIX_FOOTER_HEIGHT - 4),
+				 Qt::AlignCenter, QString("Phantom C vs L+R: %1").arg(source.phantomCenter, 0, 'f', 2));
+	}
+}
 
-	for (size_t i = 0; i < numThreads; ++i) {
-		size_t start = i * chunkSize;
-		size_t end = (i == numThreads - 1) ? sampleCount : (i + 1) * chunkSize;
+void PhaseMeterWidget::drawBandGrid(QPainter &painter, const QRect &rect)
+{
+	// 縦方向に +1（上）〜 -1（下）。上下に周波数ラベルと余白を取る
+	const QRect bars = rect.adjusted(BAND_SCALE_WIDTH, 20, 0, -20);
+	QFont font = painter.font();
+	font.setPointSizeF(7.0);
+	painter.setFont(font);
 
-		auto future = std::async(
-			std::launch::async, [&left, &right, start, end]() -> std::tuple<float, float, float> {
-				float dotProduct = 0.0f;
-				float leftSum = 0.0f;
-				float rightSum = 0.0f;
+	painter.setPen(QPen(Qt::darkGray, 1));
+	painter.drawRect(bars.adjusted(0, 0, -1, 0));
+
+	painter.setPen(Qt::gray);
+	const int scaleFlags = Qt::AlignRight | Qt::AlignVCenter;
+	const int scaleWidth = BAND_SCALE_WIDTH - 3;
+	painter.drawText(QRect(rect.left(), bars.top() - 7, scaleWidth, 14), scaleFlags, "+1");
+	painter.drawText(QRect(rect.left(), bars.center().y() - 7, scaleWidth, 14), scaleFlags, "0");
+	painter.drawText(QRect(rect.left(), bars.bottom() - 7, scaleWidth, 14), scaleFlags, "-1");
+
+	painter.setPen(QPen(Qt::darkGray, 1, Qt::DotLine));
+	painter.drawLine(bars.left(), bars.center().y(), bars.right(), bars.center().y());
+
+	// 帯域の中心周波数（上下端の幾何平均）。クロスオーバーは全ソース共通
+	painter.setPen(Qt::gray);
+	for (int band = 0; band < m_bandCount; ++band) {
+		const double center = std::sqrt(BandCorrelationMeter::edgeFrequency(band, m_bandCount) *
+						BandCorrelationMeter::edgeFrequency(band + 1, m_bandCount));
+		const QString label = center >= 1000.0 ? QString("%1k").arg(center / 1000.0, 0, 'f', 1)
+						       : QString::number(static_cast<int>(center));
+		const int x = bars.left() + band * BAND_SLOT_WIDTH;
+		painter.drawText(QRect(x, bars.bottom() + 2, BAND_SLOT_WIDTH, 16), Qt::AlignCenter, label);
+	}
+}
 
-				// C++20の並列アルゴリズムを使用
-				auto leftBegin = left.begin() + start;
-				auto leftEnd = left.begin() + end;
-				auto rightBegin = right.begin() + start;
+void PhaseMeterWidget::drawBandBars(QPainter &painter, const QRect &rect, const SourceFrame &source)
+{
+	const QRect bars = rect.adjusted(BAND_SCALE_WIDTH, 20, 0, -20);
+	const int zeroY = bars.center().y();
+	const int halfHeight = bars.height() / 2;
+	const int count = std::min(source.bandCount, m_bandCount);
+
+	for (int band = 0; band < count; ++band) {
+		const float value = source.bandCorrelation[band];
+		const int height = static_cast<int>(value * halfHeight);
+		const int x = bars.left() + band * BAND_SLOT_WIDTH + 3;
+
+		// +1で緑、0で黄、-1で赤
+		const QColor color = QColor::fromHsvF((value + 1.0f) / 2.0f * (120.0f / 360.0f), 0.85f, 0.9f);
+		painter.fillRect(QRect(QPoint(x, std::min(zeroY, zeroY - height)),
+				       QSize(BAND_SLOT_WIDTH - 6, std::max(1, std::abs(height)))),
+				 color);
+	}
+}
 
-				// 内積を計算
-				dotProduct = std::transform_reduce(std::execution::unseq, leftBegin, leftEnd,
-								   rightBegin, 0.0f, std::plus<float>(),
-								   std::multiplies<float>());
+void PhaseMeterWidget::drawSourceFrame(QPainter &painter, const SourceFrame &source, const QRect &target)
+{
+	if (source.imageSize > 0) {
+		// フレームの画素をコピーせずにQImageで包む（フレームは次のacquireFrameまで書き換えられない）
+		const QImage image(reinterpret_cast<const uchar *>(source.pixels.data()), source.imageSize,
+				   source.imageSize, source.imageSize * static_cast<int>(sizeof(uint32_t)),
+				   QImage::Format_ARGB32_Premultiplied);
+		painter.drawImage(target, image);
+	}
+}
 
-				// 左チャンネルの二乗和
-				leftSum = std::transform_reduce(std::execution::unseq, leftBegin, leftEnd, 0.0f,
-								std::plus<float>(), [](float x) { return x * x; });
+QRect PhaseMeterWidget::historyPlot(const QRect &rect) const
+{
+	// 上に見出し、左に目盛りの余白を取る
+	return rect.adjusted(HISTORY_SCALE_WIDTH, HISTORY_TITLE_HEIGHT + 2, -1, -2);
+}
 
-				// 右チャンネルの二乗和
-				rightSum = std::transform_reduce(std::execution::unseq, rightBegin, right.begin() + end,
-								 0.0f, std::plus<float>(),
-								 [](float x) { return x * x; });
+void PhaseMeterWidget::historyScale(float &lowest, float &highest) const
+{
+	switch (m_historyMetric) {
+	case HistoryMetric::Width:
+		lowest = -30.0f; // 下ほどモノラル寄り
+		highest = 30.0f;
+		break;
+	case HistoryMetric::Level:
+		lowest = -60.0f;
+		highest = 0.0f;
+		break;
+	default:
+		lowest = -1.0f;
+		highest = 1.0f;
+		break;
+	}
+}
 
-				return std::make_tuple(dotProduct, leftSum, rightSum);
-			});
+void PhaseMeterWidget::drawHistoryGrid(QPainter &painter, const QRect &rect)
+{
+	const QRect plot = historyPlot(rect);
+	QFont font = painter.font();
+	font.setPointSizeF(7.0);
+	painter.setFont(font);
 
-		futures.push_back(std::move(future));
-	}
+	painter.setPen(QPen(Qt::darkGray, 1));
+	painter.drawRect(plot);
+	painter.setPen(QPen(Qt::darkGray, 1, Qt::DotLine));
+	painter.drawLine(plot.left(), plot.center().y(), plot.right(), plot.center().y());
+
+	float lowest, highest;
+	historyScale(lowest, highest);
+	const auto label = [](float value) {
+		return value > 0.0f ? QString("+%1").arg(value) : QString::number(value);
+	};
+
+	painter.setPen(Qt::gray);
+	const int scaleFlags = Qt::AlignRight | Qt::AlignVCenter;
+	const int scaleWidth = HISTORY_SCALE_WIDTH - 3;
+	painter.drawText(QRect(rect.left(), plot.top() - 7, scaleWidth, 14), scaleFlags, label(highest));
+	painter.drawText(QRect(rect.left(), plot.center().y() - 7, scaleWidth, 14), scaleFlags,
+			 label((lowest + highest) / 2.0f));
+	painter.drawText(QRect(rect.left(), plot.bottom() - 7, scaleWidth, 14), scaleFlags, label(lowest));
+
+	const QString unit = m_historyMetric == HistoryMetric::Correlation ? QString() : QString(" (dB)");
+	painter.drawText(QRect(plot.left(), rect.top(), plot.width(), HISTORY_TITLE_HEIGHT),
+			 Qt::AlignLeft | Qt::AlignVCenter, m_historyMetricCombo->currentText() + unit);
+	painter.drawText(QRect(plot.left(), rect.top(), plot.width(), HISTORY_TITLE_HEIGHT),
+			 Qt::AlignRight | Qt::AlignVCenter, QString("last %1").arg(m_historyCombo->currentText()));
+}
 
-	// 結果を集約
-	float totalDotProduct = 0.0f;
-	float totalLeftSum = 0.0f;
-	float totalRightSum = 0.0f;
+void PhaseMeterWidget::drawHistory(QPainter &painter, const QRect &rect, const SourceFrame &source)
+{
+	const QRect plot = historyPlot(rect).adjusted(1, 1, -1, -1);
+	const size_t count = std::min(source.historyCount, static_cast<size_t>(std::max(plot.width(), 0)));
+	if (count == 0 || plot.height() <= 0) {
+		return;
+	}
 
-	for (auto &future : futures) {
-		if (future.valid()) {
-			auto [dotProduct, leftSum, rightSum] = future.get();
-			totalDotProduct += dotProduct;
-			totalLeftSum += leftSum;
-			totalRightSum += rightSum;
+	float lowest, highest;
+	historyScale(lowest, highest);
+	const float scale = plot.height() / (highest - lowest);
+	const auto toY = [&](float value) {
+		return plot.bottom() - static_cast<int>((std::clamp(value, lowest, highest) - lowest) * scale);
+	};
+	const auto pick = [this](const HistoryPoint &point) -> const HistoryRange & {
+		switch (m_historyMetric) {
+		case HistoryMetric::Width:
+			return point.width;
+		case HistoryMetric::Level:
+			return point.level;
+		default:
+			return point.correlation;
 		}
+	};
+
+	// 列ごとに最小〜最大の縦線と平均の折れ線。最新の列を右端に置く
+	m_historyRanges.clear();
+	m_historyMeans.clear();
+	const HistoryPoint *columns = source.history.data() + source.historyCount - count;
+	for (size_t i = 0; i < count; ++i) {
+		const HistoryRange &range = pick(columns[i]);
+		const int x = plot.right() - static_cast<int>(count - 1 - i);
+		m_historyRanges.emplace_back(x, toY(range.max), x, toY(range.min));
+		m_historyMeans.emplace_back(x, toY(range.mean));
 	}
 
-	if (totalLeftSum > 0 && totalRightSum > 0) {
-		return totalDotProduct / std::sqrt(totalLeftSum * totalRightSum);
-	}
+	QColor rangeColor = source.color;
+	rangeColor.setAlpha(90);
+	painter.setPen(QPen(rangeColor, 1));
+	painter.drawLines(m_historyRanges.data(), static_cast<int>(m_historyRanges.size()));
+	painter.setPen(QPen(source.color, 1));
+	painter.drawPolyline(m_historyMeans.data(), static_cast<int>(m_historyMeans.size()));
+}
 
-	return 0.0f;
+// n枚の正方形タイルが最も大きくなる列数を選ぶ
+static void gridLayout(const QSize &area, int count, int spacing, int &columns, int &tileSize)
+{
+	columns = 1;
+	tileSize = 0;
+	for (int candidate = 1; candidate <= count; ++candidate) {
+		const int rows = (count + candidate - 1) / candidate;
+		const int size = std::min((area.width() - spacing * (candidate - 1)) / candidate,
+					  (area.height() - spacing * (rows - 1)) / rows);
+		if (size > tileSize) {
+			tileSize = size;
+			columns = candidate;
+		}
+	}
 }
 
-float PhaseMeterWidget::calculateCorrelationSequential(const std::vector<float> &left, const std::vector<float> &right,
-						       size_t sampleCount)
+const SourceFrame *PhaseMeterWidget::drawGridView(QPainter &painter, const QRect &rect)
 {
+	m_worker->acquireFrame();
+	const AnalysisFrame &frame = m_worker->frame();
+
+	// 有効なソースすべてにタイルを割り当てる（音の無いソースは空のスコープになる）
+	m_gridSources.clear();
+	for (size_t i = 0; i < frame.count; ++i) {
+		if (frame.sources[i].enabled) {
+			m_gridSources.push_back(&frame.sources[i]);
+		}
+	}
+	const int count = static_cast<int>(m_gridSources.size());
+	if (count == 0) {
+		m_tiles.clear();
+		return nullptr;
+	}
 
-	float correlation = 0.0f;
-	float leftSum = 0.0f;
-	float rightSum = 0.0f;
+	int columns, tileSize;
+	gridLayout(rect.size(), count, GRID_SPACING, columns, tileSize);
+	if (tileSize <= GRID_LABEL_HEIGHT + GRID_BAR_HEIGHT + 8) {
+		return nullptr;
+	}
+	const qreal dpr = devicePixelRatioF();
+
+	// スコープ画像の解像度をタイル内のスコープの大きさに合わせる（全ソース共通）
+	const int scopeSize = tileSize - GRID_LABEL_HEIGHT - GRID_BAR_HEIGHT - 6;
+	m_worker->setRasterSize(static_cast<int>(scopeSize * dpr));
+
+	// 画像・相関値・名前が変わったタイルだけを描き直す
+	m_tiles.resize(count);
+	m_dirtyTiles.clear();
+	const QSize tilePixels = QSize(tileSize, tileSize) * dpr;
+	for (int i = 0; i < count; ++i) {
+		const GridTile &tile = m_tiles[i];
+		const SourceFrame &source = *m_gridSources[i];
+		const bool moved = std::abs(tile.correlation - source.correlation) >= GRID_CORRELATION_STEP;
+		if (tile.image.size() != tilePixels || tile.slot != source.slot ||
+		    tile.pixelsVersion != source.pixelsVersion || tile.hasAudio != source.hasAudio || moved ||
+		    tile.name != source.name || tile.color != source.color) {
+			m_dirtyTiles.push_back(i);
+		}
+	}
 
-	for (size_t i = 0; i < sampleCount; ++i) {
-		correlation += left[i] * right[i];
-		leftSum += left[i] * left[i];
-		rightSum += right[i] * right[i];
+	// タイルは互いに独立したQImageなので並列に描ける
+	QFont tileFont = font();
+	tileFont.setPointSizeF(7.5);
+	const auto render = [&](int index) {
+		renderTile(m_tiles[index], *m_gridSources[index], tileSize, dpr, tileFont);
+	};
+	if (m_dirtyTiles.size() > 1) {
+		QtConcurrent::blockingMap(m_dirtyTiles, render);
+	} else {
+		for (int index : m_dirtyTiles) {
+			render(index);
+		}
 	}
 
-	if (leftSum > 0 && rightSum > 0) {
-		correlation /= std::sqrt(leftSum * rightSum);
+	// 余白は左右・上下に均等に振り分ける
+	const int rows = (count + columns - 1) / columns;
+	const int left = rect.left() + (rect.width() - columns * tileSize - (columns - 1) * GRID_SPACING) / 2;
+	const int top = rect.top() + (rect.height() - rows * tileSize - (rows - 1) * GRID_SPACING) / 2;
+	for (int i = 0; i < count; ++i) {
+		const QPoint position(left + (i % columns) * (tileSize + GRID_SPACING),
+				      top + (i / columns) * (tileSize + GRID_SPACING));
+		painter.drawImage(position, m_tiles[i].image);
 	}
 
-	return correlation;
+	// 相関ラベルは選択中のソース（All Sourcesなら最初の音のあるソース）
+	QVariant selected = m_sourceCombo->currentData();
+	const int selectedSlot = selected.isValid() ? selected.toInt() : -1;
+	const SourceFrame *labelSource = nullptr;
+	for (const SourceFrame *source : m_gridSources) {
+		if (selectedSlot >= 0 ? source->slot == selectedSlot : source->hasAudio) {
+			labelSource = source;
+			break;
+		}
+	}
+	if (labelSource) {
+		updateCorrelationDisplay(labelSource->correlation);
+	}
+	return labelSource;
 }
 
-std::vector<QPoint> PhaseMeterWidget::calculatePhasePointsParallel(const std::vector<float> &left,
-								   const std::vector<float> &right,
-								   const QPoint &center, int radius, size_t sampleCount)
+// 描画スレッドから並列に呼ばれる。ウィジェットの状態には触らない
+void PhaseMeterWidget::renderTile(GridTile &tile, const SourceFrame &source, int tileSize, qreal dpr,
+				  const QFont &font)
 {
+	const QSize pixels = QSize(tileSize, tileSize) * dpr;
+	if (tile.image.size() != pixels) {
+		tile.image = QImage(pixels, QImage::Format_ARGB32_Premultiplied);
+	}
+	tile.image.setDevicePixelRatio(dpr);
+	tile.image.fill(QColor(16, 16, 16));
 
-	const int maxPoints = 50;
-	const int step = std::max(1, static_cast<int>(sampleCount / maxPoints));
+	QPainter painter(&tile.image);
+	painter.setRenderHint(QPainter::Antialiasing);
+	painter.setFont(font);
 
-	std::vector<QPoint> points;
-	points.reserve(maxPoints);
+	// 名前
+	const QRect label(3, 0, tileSize - 6, GRID_LABEL_HEIGHT);
+	painter.setPen(source.color);
+	painter.drawText(label, Qt::AlignLeft | Qt::AlignVCenter,
+			 painter.fontMetrics().elidedText(source.name, Qt::ElideRight, label.width()));
 
-	// 並列でポイントを計算
-	std::vector<size_t> indices;
-	for (size_t i = 0; i < sampleCount; i += step) {
-		indices.push_back(i);
+	// スコープ（円と十字の上に画像を加算合成する）
+	const int scopeSize = tileSize - GRID_LABEL_HEIGHT - GRID_BAR_HEIGHT - 6;
+	const QRect scope((tileSize - scopeSize) / 2, GRID_LABEL_HEIGHT + 1, scopeSize, scopeSize);
+	painter.setPen(QPen(Qt::darkGray, 1));
+	painter.drawEllipse(scope);
+	painter.drawLine(scope.left(), scope.center().y(), scope.right(), scope.center().y());
+	painter.drawLine(scope.center().x(), scope.top(), scope.center().x(), scope.bottom());
+	if (source.hasAudio && source.imageSize > 0) {
+		const QImage image(reinterpret_cast<const uchar *>(source.pixels.data()), source.imageSize,
+				   source.imageSize, source.imageSize * static_cast<int>(sizeof(uint32_t)),
+				   QImage::Format_ARGB32_Premultiplied);
+		painter.setCompositionMode(QPainter::CompositionMode_Plus);
+		painter.setRenderHint(QPainter::SmoothPixmapTransform);
+		painter.drawImage(scope, image);
+		painter.setCompositionMode(QPainter::CompositionMode_SourceOver);
 	}
 
-	std::mutex pointsMutex;
+	// 相関バー（中央が0、右が+1）。色は帯域バーと同じく+1で緑、0で黄、-1で赤
+	const QRect bar(3, tileSize - GRID_BAR_HEIGHT - 2, tileSize - 6, GRID_BAR_HEIGHT);
+	painter.fillRect(bar, QColor(48, 48, 48));
+	if (source.hasAudio) {
+		const float value = std::clamp(source.correlation, -1.0f, 1.0f);
+		const int zeroX = bar.center().x();
+		const int width = static_cast<int>(value * bar.width() / 2);
+		const QColor color = QColor::fromHsvF((value + 1.0f) / 2.0f * (120.0f / 360.0f), 0.85f, 0.9f);
+		painter.fillRect(QRect(std::min(zeroX, zeroX + width), bar.top(), std::max(1, std::abs(width)),
+				       bar.height()),
+				 color);
+	}
+	painter.fillRect(QRect(bar.center().x(), bar.top() - 1, 1, bar.height() + 2), Qt::gray);
+
+	tile.slot = source.slot;
+	tile.pixelsVersion = source.pixelsVersion;
+	tile.correlation = source.correlation;
+	tile.hasAudio = source.hasAudio;
+	tile.name = source.name;
+	tile.color = source.color;
+}
+
+void PhaseMeterWidget::updateDelayDisplay(const AnalysisFrame &frame)
+{
+	// 表示内容を決める状態を先に比べ、変わったときだけ文字列を作る（相関ラベルと同じ）
+	DelayDisplay display;
+	if (frame.delayReference < 0 || frame.delayTarget < 0) {
+		display.state = m_delayCombo->currentIndex() > 0 ? DelayDisplay::State::NoTarget
+								 : DelayDisplay::State::Empty;
+	} else if (!frame.delay.valid) {
+		display.state = DelayDisplay::State::Measuring;
+	} else {
+		display.state = DelayDisplay::State::Valid;
+		display.delayCenti = std::lround(frame.delay.delayMs * 100.0);
+		display.peakCenti = std::lround(frame.delay.peak * 100.0);
+		display.inverted = frame.delay.inverted;
+	}
+	if (display == m_delayDisplay) {
+		return;
+	}
+	m_delayDisplay = display;
+
+	QString text;
+	switch (display.state) {
+	case DelayDisplay::State::NoTarget:
+		text = "Select a source to compare";
+		break;
+	case DelayDisplay::State::Measuring:
+		text = "Measuring...";
+		break;
+	case DelayDisplay::State::Valid:
+		// 正の値は選択中のソースが基準より遅れていることを表す
+		text = QString("%1%2 ms  peak %3  %4")
+			       .arg(display.delayCenti >= 0 ? "+" : "")
+			       .arg(display.delayCenti / 100.0, 0, 'f', 2)
+			       .arg(display.peakCenti / 100.0, 0, 'f', 2)
+			       .arg(display.inverted ? "polarity inverted" : "polarity normal");
+		break;
+	default:
+		break;
+	}
 
-	std::for_each(std::execution::par_unseq, indices.begin(), indices.end(), [&](size_t i) {
-		float leftVal = left[i];
-		float rightVal = right[i];
+	QMetaObject::invokeMethod(
+		this,
+		[this, text]() {
+			if (!m_isDestroying && m_delayLabel) {
+				m_delayLabel->setText(text);
+			}
+		},
+		Qt::QueuedConnection);
+}
 
-		float magnitude = std::sqrt(leftVal * leftVal + rightVal * rightVal);
+void PhaseMeterWidget::updateCorrelationDisplay(float correlation)
+{
+	// 表示桁で丸めた値が変わったときだけラベルを更新する（ラベルの再描画・再レイアウトと、描画ごとの文字列の確保を避ける）
+	const int centi = static_cast<int>(std::lround(std::clamp(correlation, -1.0f, 1.0f) * 100.0f));
+	if (centi == m_correlationCenti) {
+		return;
+	}
+	m_correlationCenti = centi;
+	const QString text = QString("Correlation: %1").arg(centi / 100.0, 0, 'f', 2);
+
+	// 描画中にウィジェットを変更しないよう、反映は次のイベントループで行う
+	QMetaObject::invokeMethod(
+		this,
+		[this, text]() {
+			if (!m_isDestroying && m_correlationLabel) {
+				m_correlationLabel->setText(text);
+			}
+		},
+		Qt::QueuedConnection);
+}
 
-		if (magnitude > 0.01f) {
-			magnitude = std::min(magnitude, 1.0f);
-			float angle = std::atan2(rightVal, leftVal);
+void PhaseMeterWidget::onStatsToggled(bool checked)
+{
+	m_showStats = checked;
+	update(meterRect());
+}
 
-			int x = center.x() + static_cast<int>(magnitude * radius * std::cos(angle));
-			int y = center.y() + static_cast<int>(magnitude * radius * std::sin(angle));
+void PhaseMeterWidget::onFrameRateChanged()
+{
+	if (!m_isDestroying) {
+		applyFrameRate();
+	}
+}
 
-			std::lock_guard<std::mutex> lock(pointsMutex);
-			points.emplace_back(x, y);
+QStringList PhaseMeterWidget::formatStats() const
+{
+	QStringList lines;
+
+	const AnalysisStats &analysis = m_worker->stats();
+	const uint64_t paints = statGet(m_paintStats.paints);
+	const uint64_t cycles = statGet(analysis.cycles);
+	const double paintAvgUs = paints ? statGet(m_paintStats.paintNs) / 1000.0 / paints : 0.0;
+	const double analyzeAvgUs = cycles ? statGet(analysis.analyzeNs) / 1000.0 / cycles : 0.0;
+
+	lines.append(QString("paint %1/s  total %2  avg %3 us")
+			     .arg(m_paintsPerSecond, 0, 'f', 1)
+			     .arg(paints)
+			     .arg(paintAvgUs, 0, 'f', 1));
+	lines.append(QString("analysis %1 Hz  cycles %2  avg %3 us  frames %4  skipped %5")
+			     .arg(m_worker->clock().rate())
+			     .arg(cycles)
+			     .arg(analyzeAvgUs, 0, 'f', 1)
+			     .arg(statGet(analysis.framesPublished))
+			     .arg(statGet(analysis.framesSuperseded)));
+
+	// ENABLE_ALLOC_TRACKINGのビルドだけ、段ごとの確保回数の累計を出す（定常状態で増えていれば回帰）
+	if constexpr (ALLOC_TRACKING) {
+		QString line("alloc");
+		for (int stage = 0; stage < static_cast<int>(AllocStage::Count); ++stage) {
+			const AllocTotals totals = allocTotals(static_cast<AllocStage>(stage));
+			line += QString("  %1 %2 (%3 KB)")
+					.arg(allocStageName(static_cast<AllocStage>(stage)))
+					.arg(totals.count)
+					.arg(totals.bytes / 1024);
 		}
+		lines.append(line);
+	}
+
+	const SourceSnapshot sources = m_registry.snapshot();
+	int attached = 0;
+	sources->forEach([&attached](const SourceEntry &entry) { attached += entry.source->attached.load() ? 1 : 0; });
+	lines.append(QString("capturing %1 of %2 sources").arg(attached).arg(sources->size()));
+
+	sources->forEach([&lines](const SourceEntry &entry) {
+		const AudioSource &source = *entry.source;
+		const uint64_t blocks = statGet(source.captureStats.blocks);
+		const uint64_t drains = statGet(source.consumeStats.drains);
+		const double callbackAvgUs = blocks ? statGet(source.captureStats.callbackNs) / 1000.0 / blocks : 0.0;
+		const double analyzeAvgUs = drains ? statGet(source.consumeStats.analyzeNs) / 1000.0 / drains : 0.0;
+
+		lines.append(QString("%1: blocks %2  frames %3/%4  dropped %5  cb avg %6 us max %7 us  analyze %8 us")
+				     .arg(entry.name)
+				     .arg(blocks)
+				     .arg(statGet(source.consumeStats.frames))
+				     .arg(statGet(source.captureStats.frames))
+				     .arg(source.capture.droppedFrames())
+				     .arg(callbackAvgUs, 0, 'f', 2)
+				     .arg(statGet(source.captureStats.callbackMaxNs) / 1000.0, 0, 'f', 1)
+				     .arg(analyzeAvgUs, 0, 'f', 1));
 	});
 
-	return points;
+	return lines;
 }
 
-void PhaseMeterWidget::drawProcessedAudioSource(QPainter &painter, const ProcessedAudioData &data)
+void PhaseMeterWidget::dumpStats() const
 {
-	painter.setPen(QPen(data.color, 2));
-
-	// 点を描画
-	for (const auto &point : data.points) {
-		painter.drawEllipse(point, 1, 1);
+	blog(LOG_INFO, "Phase Meter: pipeline stats");
+	for (const QString &line : formatStats()) {
+		blog(LOG_INFO, "  %s", line.toUtf8().constData());
 	}
-
-	// 相関値を更新（頻度制限付き）
-	updateCorrelationDisplay(data.correlation);
 }
 
-void PhaseMeterWidget::updateCorrelationDisplay(float correlation)
+void PhaseMeterWidget::drawStatsOverlay(QPainter &painter, const QRect &rect)
 {
-	static int updateCounter = 0;
-	if (++updateCounter % 10 == 0) { // 10回に1回だけ更新
-		QMetaObject::invokeMethod(
-			this,
-			[this, correlation]() {
-				if (!m_isDestroying && m_correlationLabel) {
-					m_correlationLabel->setText(
-						QString("Correlation: %1").arg(correlation, 0, 'f', 2));
-				}
-			},
-			Qt::QueuedConnection);
+	const QStringList lines = formatStats();
+
+	painter.save();
+	painter.setRenderHint(QPainter::Antialiasing, false);
+	QFont font = painter.font();
+	font.setPointSizeF(7.5);
+	painter.setFont(font);
+
+	const int lineHeight = painter.fontMetrics().height();
+	QRect textRect(rect.left() + 4, rect.top() + 4, rect.width() - 8, lineHeight * lines.size() + 4);
+	painter.fillRect(textRect, QColor(0, 0, 0, 160));
+	painter.setPen(Qt::lightGray);
+
+	int y = textRect.top() + painter.fontMetrics().ascent() + 2;
+	for (const QString &line : lines) {
+		painter.drawText(textRect.left() + 2, y, line);
+		y += lineHeight;
 	}
+	painter.restore();
 }
 
 void PhaseMeterWidget::onSourceSelectionChanged()
 {
 	if (!m_isDestroying) {
-		m_needsUpdate = true;
+		onDelayPairChanged(); // 遅延推定の対象はSourceで選んだソース
+		updateAlarmControls();
+		update(meterRect());
 	}
 }
 
-void PhaseMeterWidget::onColorButtonClicked()
+void PhaseMeterWidget::onDelayPairChanged()
 {
 	if (m_isDestroying)
 		return;
 
-	int selectedIndex = m_sourceCombo->currentIndex();
-	if (selectedIndex > 0) {
-		QString sourceName = m_sourceCombo->itemText(selectedIndex);
-		if (sourceName.isEmpty())
+	const QVariant reference = m_delayCombo->currentData();
+	const QVariant target = m_sourceCombo->currentData();
+	m_worker->setDelayPair(reference.isValid() ? reference.toInt() : -1, target.isValid() ? target.toInt() : -1);
+	update(meterRect());
+	emit captureDemandChanged();
+}
+
+void PhaseMeterWidget::onProgramOnlyToggled(bool checked)
+{
+	if (m_isDestroying)
+		return;
+
+	m_programOnly.store(checked, std::memory_order_relaxed);
+	emit captureDemandChanged();
+}
+
+void PhaseMeterWidget::onHistoryChanged()
+{
+	if (m_isDestroying)
+		return;
+
+	// 履歴はいつも全段を取っているので、切り替えは次のフレームで反映される
+	m_historySeconds = m_historyCombo->currentData().toDouble();
+	m_historyMetric = static_cast<HistoryMetric>(m_historyMetricCombo->currentData().toInt());
+	m_historyMetricCombo->setEnabled(m_historySeconds > 0.0);
+	m_gridCacheValid = false; // 帯の分だけスコープの領域が変わる・目盛りが変わる
+	update(meterRect());
+}
+
+void PhaseMeterWidget::updateAlarmControls()
+{
+	// 警告の設定は選択中のソースのもの（"All Sources"では編集できない）
+	PhaseAlarmSettings settings;
+	bool selected = false;
+	const SourceSnapshot sources = m_registry.snapshot();
+	if (const SourceEntry *entry = selectedSource(*sources)) {
+		settings = entry->activeAlarm().settings();
+		selected = true;
+	}
+
+	const QSignalBlocker checkBlocker(m_alarmCheck);
+	const QSignalBlocker thresholdBlocker(m_alarmThresholdSpin);
+	const QSignalBlocker holdBlocker(m_alarmHoldSpin);
+	m_alarmCheck->setChecked(settings.enabled);
+	m_alarmThresholdSpin->setValue(settings.threshold);
+	m_alarmHoldSpin->setValue(static_cast<int>(settings.holdMs));
+	m_alarmCheck->setEnabled(selected);
+	m_alarmThresholdSpin->setEnabled(selected);
+	m_alarmHoldSpin->setEnabled(selected);
+}
+
+void PhaseMeterWidget::onAlarmSettingsChanged()
+{
+	if (m_isDestroying)
+		return;
+
+	PhaseAlarmSettings settings;
+	settings.enabled = m_alarmCheck->isChecked();
+	settings.threshold = static_cast<float>(m_alarmThresholdSpin->value());
+	settings.holdMs = static_cast<uint32_t>(m_alarmHoldSpin->value());
+
+	QString uuid;
+	{
+		const SourceSnapshot sources = m_registry.snapshot();
+		const SourceEntry *entry = selectedSource(*sources);
+		if (!entry) {
 			return;
+		}
+		entry->activeAlarm().setSettings(settings);
+		uuid = entry->source->uuid;
+	}
 
-		QMutexLocker locker(&m_sourcesMutex);
+	// 再生中の仮のソースは保存しない
+	if (!uuid.startsWith(REPLAY_UUID_PREFIX)) {
+		{
+			QMutexLocker locker(&m_sourcesMutex);
+			m_alarmSettings.insert(uuid, settings);
+		}
+		saveAlarmSettings();
+	}
 
-		auto it = std::find_if(m_audioSources.begin(), m_audioSources.end(),
-				       [&sourceName](const auto &s) { return s->name == sourceName; });
+	// 警告を有効にしたソースはドックを隠しても監視する
+	emit captureDemandChanged();
+}
+
+void PhaseMeterWidget::checkAlarms()
+{
+	// 音声スレッドが状態を変えたときだけ全ソースを見る
+	if (m_isDestroying || !m_alarmPending.exchange(false, std::memory_order_acquire))
+		return;
 
-		if (it != m_audioSources.end()) {
-			auto &source = *it;
+	struct AlarmEvent {
+		QString uuid;
+		QString name;
+		bool active;
+		float correlation;
+	};
+	std::vector<AlarmEvent> events;
+	m_registry.snapshot()->forEach([&](const SourceEntry &entry) {
+		const PhaseAlarm &alarm = entry.activeAlarm();
+		const bool active = alarm.active();
+		AudioSource &source = *entry.source;
+		if (active != source.alarmReported) {
+			source.alarmReported = active; // GUIスレッドだけが触る
+			events.push_back({source.uuid, entry.name, active, alarm.correlation()});
+		}
+	});
 
-			QMainWindow *mainWindow = static_cast<QMainWindow *>(obs_frontend_get_main_window());
+	for (const AlarmEvent &event : events) {
+		if (event.active) {
+			blog(LOG_WARNING, "Phase Meter: '%s' is out of phase (correlation %.2f)",
+			     event.name.toUtf8().constData(), event.correlation);
+		} else {
+			blog(LOG_INFO, "Phase Meter: '%s' is back in phase (correlation %.2f)",
+			     event.name.toUtf8().constData(), event.correlation);
+		}
+		emit phaseAlarmChanged(event.uuid, event.name, event.active, event.correlation);
+	}
 
-			QColorDialog *dialog = new QColorDialog(source->color, mainWindow);
-			dialog->setAttribute(Qt::WA_DeleteOnClose);
+	if (!events.empty()) {
+		updateAlarmLabel();
+	}
+}
 
-			connect(dialog, &QColorDialog::colorSelected, this, [this, sourceName](const QColor &color) {
-				if (m_isDestroying)
-					return;
+void PhaseMeterWidget::updateAlarmLabel()
+{
+	QStringList names;
+	m_registry.snapshot()->forEach([&](const SourceEntry &entry) {
+		if (entry.source->alarmReported) {
+			names << entry.name;
+		}
+	});
 
-				if (color.isValid()) {
-					QMutexLocker locker(&m_sourcesMutex);
-					auto it = std::find_if(m_audioSources.begin(), m_audioSources.end(),
-							       [&sourceName](const auto &s) {
-								       return s->name == sourceName;
-							       });
+	if (names.isEmpty()) {
+		m_alarmLabel->hide();
+		return;
+	}
+	m_alarmLabel->setText(QString("Out of phase: %1").arg(names.join(", ")));
+	m_alarmLabel->show();
+}
 
-					if (it != m_audioSources.end()) {
-						(*it)->color = color;
-						m_needsUpdate = true;
-					}
-				}
-			});
+void PhaseMeterWidget::loadAlarmSettings()
+{
+	char *path = obs_module_config_path(ALARM_CONFIG_FILE);
+	if (!path) {
+		return;
+	}
+	obs_data_t *data = obs_data_create_from_json_file_safe(path, "bak");
+	bfree(path);
+	if (!data) {
+		return;
+	}
 
-			dialog->open();
+	obs_data_array_t *sources = obs_data_get_array(data, "sources");
+	const size_t count = obs_data_array_count(sources);
+	for (size_t i = 0; i < count; ++i) {
+		obs_data_t *item = obs_data_array_item(sources, i);
+		const QString uuid = QString::fromUtf8(obs_data_get_string(item, "uuid"));
+		if (!uuid.isEmpty()) {
+			PhaseAlarmSettings settings;
+			settings.enabled = obs_data_get_bool(item, "enabled");
+			settings.threshold = static_cast<float>(obs_data_get_double(item, "threshold"));
+			const long long holdMs = obs_data_get_int(item, "hold_ms");
+			settings.holdMs = static_cast<uint32_t>(std::clamp<long long>(holdMs, 0, 60000));
+			QMutexLocker locker(&m_sourcesMutex);
+			m_alarmSettings.insert(uuid, settings);
 		}
+		obs_data_release(item);
+	}
+	obs_data_array_release(sources);
+	obs_data_release(data);
+}
+
+void PhaseMeterWidget::saveAlarmSettings() const
+{
+	char *directory = obs_module_config_path("");
+	char *path = obs_module_config_path(ALARM_CONFIG_FILE);
+	if (!directory || !path) {
+		bfree(directory);
+		bfree(path);
+		return;
+	}
+	os_mkdirs(directory);
+	bfree(directory);
+
+	// ソースが一時的に無くなっても設定は残す。差分が読みやすいようUUID順に書く
+	QStringList uuids = m_alarmSettings.keys();
+	uuids.sort();
+
+	obs_data_t *data = obs_data_create();
+	obs_data_array_t *sources = obs_data_array_create();
+	for (const QString &uuid : uuids) {
+		const PhaseAlarmSettings settings = m_alarmSettings.value(uuid);
+		obs_data_t *item = obs_data_create();
+		obs_data_set_string(item, "uuid", uuid.toUtf8().constData());
+		obs_data_set_bool(item, "enabled", settings.enabled);
+		obs_data_set_double(item, "threshold", settings.threshold);
+		obs_data_set_int(item, "hold_ms", settings.holdMs);
+		obs_data_array_push_back(sources, item);
+		obs_data_release(item);
+	}
+	obs_data_set_array(data, "sources", sources);
+
+	if (!obs_data_save_json_safe(data, path, "tmp", "bak")) {
+		blog(LOG_WARNING, "Phase Meter: Cannot save alarm settings to %s", path);
 	}
+	obs_data_array_release(sources);
+	obs_data_release(data);
+	bfree(path);
+}
+
+void PhaseMeterWidget::onColorButtonClicked()
+{
+	if (m_isDestroying)
+		return;
+
+	const SourceSnapshot sources = m_registry.snapshot();
+	const SourceEntry *entry = selectedSource(*sources);
+	if (!entry)
+		return;
+
+	// ダイアログ表示中にスロットが再利用される可能性があるので、UUIDで引き直す
+	const QString uuid = entry->source->uuid;
+
+	QMainWindow *mainWindow = static_cast<QMainWindow *>(obs_frontend_get_main_window());
+
+	QColorDialog *dialog = new QColorDialog(entry->color, mainWindow);
+	dialog->setAttribute(Qt::WA_DeleteOnClose);
+
+	connect(dialog, &QColorDialog::colorSelected, this, [this, uuid](const QColor &color) {
+		if (m_isDestroying)
+			return;
+
+		if (color.isValid()) {
+			QMutexLocker locker(&m_sourcesMutex);
+			if (m_registry.modify(uuid, [&color](SourceEntry &entry) { entry.color = color; })) {
+				m_worker->requestPublish();
+			}
+		}
+	});
+
+	dialog->open();
 }
 
 void PhaseMeterWidget::cleanup()
 {
 	m_isDestroying = true;
 
-	if (m_updateTimer) {
-		m_updateTimer->stop();
+	if (m_watchedWindow) {
+		m_watchedWindow->removeEventFilter(this);
+		m_watchedWindow = nullptr;
+	}
+
+	// 再生を止め、記録中のブロックを書き出して閉じる
+	stopReplay();
+	stopRecording();
+
+	// 解析スレッドを停止（以降リングを読む者はいない）
+	if (m_worker) {
+		m_worker->stop();
+	}
+
+	// フィルターはドックより長く動き続けるので、このウィジェットへの通知を外す
+	m_registry.snapshot()->forEach([](const SourceEntry &entry) {
+		if (entry.tap) {
+			entry.tap->alarm.setNotify(nullptr);
+			entry.tap->setClock(nullptr);
+		}
+	});
+
+	// ドックより長く残るソースもあるので、付いている監視コールバックをここで外す
+	// （外し終われば、音声スレッドがこのソースへ書き込むことはもうない）
+	if (m_captureDetach) {
+		m_registry.snapshot()->forEach([this](const SourceEntry &entry) {
+			if (entry.source->attached.load()) {
+				m_captureDetach(*entry.source);
+			}
+		});
 	}
 
 	// 進行中の非同期処理を待機
 	QThreadPool::globalInstance()->waitForDone(1000);
-
-	QMutexLocker locker(&m_sourcesMutex);
-	m_audioSources.clear();
 }
 
 void PhaseMeterWidget::resizeEvent(QResizeEvent *event)
 {
 	QWidget::resizeEvent(event);
-	m_needsUpdate = true;
+	m_gridCacheValid = false;
+	update(meterRect());
+}
+
+// 履歴の帯の上でホイールを回すと、時間幅の選択肢を1段ずつ切り替える（上で拡大）
+void PhaseMeterWidget::wheelEvent(QWheelEvent *event)
+{
+	QRect scope, bands, history;
+	splitMeterRect(meterRect(), scope, bands, history);
+	const int steps = event->angleDelta().y() / 120;
+	if (!history.contains(event->position().toPoint()) || steps == 0) {
+		QWidget::wheelEvent(event);
+		return;
+	}
+
+	const int index = std::clamp(m_historyCombo->currentIndex() - steps, 1, m_historyCombo->count() - 1);
+	m_historyCombo->setCurrentIndex(index);
+	event->accept();
+}
+
+void PhaseMeterWidget::mousePressEvent(QMouseEvent *event)
+{
+	// 相関行列のセルをクリックすると、その組をスコープに出す
+	if (m_viewMode == ViewMode::Matrix && event->button() == Qt::LeftButton) {
+		QRect scope, bands, history;
+		splitMeterRect(meterRect(), scope, bands, history);
+		int cell = 0;
+		const QRect cells = matrixCells(scope, cell);
+		const QPoint position = event->position().toPoint();
+		if (cells.contains(position)) {
+			const int row = (position.y() - cells.top()) / cell;
+			const int column = (position.x() - cells.left()) / cell;
+			const int pair = (std::min(row, column) << 16) | std::max(row, column);
+			const int index = m_scopePairCombo->findData(pair);
+			if (row != column && index >= 0) {
+				m_scopePairCombo->setCurrentIndex(index);
+				event->accept();
+				return;
+			}
+		}
+	}
+	QWidget::mousePressEvent(event);
+}
+
+// 表示されたらすぐ監視を付け直し、隠れたらすぐ外す
+void PhaseMeterWidget::showEvent(QShowEvent *event)
+{
+	QWidget::showEvent(event);
+	watchWindow();
+	refreshCaptureDemand();
+	applyFrameRate(); // 別の画面で表示されたかもしれない
+}
+
+void PhaseMeterWidget::hideEvent(QHideEvent *event)
+{
+	QWidget::hideEvent(event);
+	refreshCaptureDemand();
+}
+
+// 最小化・復元はトップレベルウィンドウにしか届かないので、そこで拾う
+bool PhaseMeterWidget::eventFilter(QObject *watched, QEvent *event)
+{
+	if (watched == m_watchedWindow && event->type() == QEvent::WindowStateChange) {
+		refreshCaptureDemand();
+	}
+	return QWidget::eventFilter(watched, event);
 }
 
 void PhaseMeterWidget::closeEvent(QCloseEvent *event)
@@ -568,26 +2174,48 @@ void PhaseMeterWidget::refreshAudioSources()
 	if (m_isDestroying)
 		return;
 
-	// コンボボックスをクリア（"All Sources"以外）
-	while (m_sourceCombo->count() > 1) {
-		m_sourceCombo->removeItem(1);
-	}
+	const SourceSnapshot sources = m_registry.snapshot();
+
+	// "All Sources"・"Off"以外を作り直す。項目は1回の挿入でまとめて入れ、途中の選択変化は通知しない
+	// 選んでいたソースが残っていれば選んだままにし、消えていれば先頭に戻して通知する
+	for (QComboBox *combo : {m_sourceCombo, m_delayCombo}) {
+		const int previousIndex = combo->currentIndex();
+		const QVariant previous = combo->currentData();
+		int index;
+		{
+			const QSignalBlocker blocker(combo);
+			QStandardItemModel *model = qobject_cast<QStandardItemModel *>(combo->model());
+			if (combo->count() > 1) {
+				combo->model()->removeRows(1, combo->count() - 1);
+			}
+			if (model) {
+				QList<QStandardItem *> items;
+				items.reserve(static_cast<qsizetype>(sources->size()));
+				sources->forEach([&items](const SourceEntry &entry) {
+					QStandardItem *item = new QStandardItem(entry.name);
+					item->setData(entry.source->slot, Qt::UserRole);
+					items.append(item);
+				});
+				model->invisibleRootItem()->appendRows(items);
+			} else {
+				sources->forEach([combo](const SourceEntry &entry) {
+					combo->addItem(entry.name, entry.source->slot);
+				});
+			}
 
-	// 現在の音声ソースを再追加
-	QMutexLocker locker(&m_sourcesMutex);
-	for (const auto &source : m_audioSources) {
-		m_sourceCombo->addItem(source->name);
+			index = previousIndex > 0 ? std::max(combo->findData(previous), 0) : 0;
+			combo->setCurrentIndex(index == previousIndex ? index : -1);
+		}
+		if (index != previousIndex) {
+			combo->setCurrentIndex(index);
+		}
 	}
 }
 
 QStringList PhaseMeterWidget::getAvailableAudioSources() const
 {
 	QStringList sources;
-	QMutexLocker locker(&m_sourcesMutex);
-
-	for (const auto &source : m_audioSources) {
-		sources.append(source->name);
-	}
+	m_registry.snapshot()->forEach([&sources](const SourceEntry &entry) { sources.append(entry.name); });
 
 	return sources;
 }
\ No newline at end of file
@@ -19,7 +19,7 @@ with this program. If not, see <https://www.gnu.org/licenses/>
 #pragma once
 
 #include <QWidget>
-#include <QTimer>
+#include <QPointer>
 #include <QPainter>
 #include <QComboBox>
 #include <QColorDialog>
@@ -27,24 +27,27 @@ with this program. If not, see <https://www.gnu.org/licenses/>
 #include <QVBoxLayout>
 #include <QHBoxLayout>
 #include <QLabel>
+#include <QCheckBox>
+#include <QSpinBox>
+#include <QDoubleSpinBox>
+#include <QHash>
 #include <QMutex>
 #include <QMutexLocker>
 #include <vector>
 #include <memory>
-#include <future>
+#include <atomic>
+#include <climits>
+#include <thread>
 #include <QImage>
+#include <QPixmap>
 
-class AudioSource {
-public:
-	QString name;
-	QColor color;
-	std::vector<float> leftChannel;
-	std::vector<float> rightChannel;
-	bool enabled;
-	mutable QMutex dataMutex; // データ保護用
+#include "source-registry.h"
+#include "analysis-worker.h"
+#include "capture-recorder.h"
+#include "capture-replay.h"
 
-	AudioSource(const QString &n, const QColor &c) : name(n), color(c), enabled(true) {}
-};
+// 監視コールバックを外す関数（OBSのAPIを呼ぶのはplugin-main側）
+using CaptureDetachHandler = void (*)(AudioSource &source);
 
 class PhaseMeterWidget : public QWidget {
 	Q_OBJECT
@@ -53,83 +56,250 @@ public:
 	explicit PhaseMeterWidget(QWidget *parent = nullptr);
 	~PhaseMeterWidget() override;
 
-	void addAudioSource(const QString &name, const QColor &color = Qt::green);
-	void removeAudioSource(const QString &name);
-	void updateAudioData(const QString &sourceName, const float *left, const float *right, size_t frames);
+	// ソースはOBSのUUIDで識別し、表示名はラベルとしてのみ扱う
+	AudioSource *addAudioSource(const QString &uuid, const QString &name, const QColor &color = Qt::green);
+	// 起動時などにまとめて登録する（一覧の差し替えもコンボの作り直しも1回で済ませる。GUIスレッドから呼ぶ）
+	size_t addAudioSources(const std::vector<SourceInfo> &sources);
+	void removeAudioSource(const QString &uuid);
+	void renameAudioSource(const QString &uuid, const QString &newName);
+	void updateAudioData(const QString &uuid, const float *left, const float *right, size_t frames);
+	AudioSource *getCaptureSource(const QString &uuid) const; // 音声コールバックの書き込み先
+	// フィルター"Phase Meter Tap"を付けたソースは、監視コールバックの代わりにフィルターの要約で解析する
+	void attachTap(const QString &uuid, const std::shared_ptr<PhaseTap> &tap);
+	void detachTap(const QString &uuid, const std::shared_ptr<PhaseTap> &tap);
+	void dumpStats() const;                                    // パイプライン統計をログへ出力
 	void refreshAudioSources();                   // 音声ソース一覧を更新
 	QStringList getAvailableAudioSources() const; // 利用可能な音声ソース一覧を取得
 
+	// 音声コールバックが受け取ったブロックの記録と、記録したファイルの実時間再生
+	bool startRecording(const QString &path, QString &error);
+	void stopRecording();
+	bool isRecording() const { return m_recorder.isRecording(); }
+	bool startReplay(const QString &path, QString &error);
+	void stopReplay();
+	bool isReplaying() const { return m_replaying.load(); }
+
+	// このソースの音声が要るか（逆相警告が有効なら常に、それ以外はドックが見えているときだけ）。GUIスレッドから呼ぶ
+	bool wantsCapture(int slot) const;
+	// プログラム出力で有効なソースだけを監視する
+	bool programSourcesOnly() const { return m_programOnly.load(std::memory_order_relaxed); }
+	// 破棄するときに、まだ付いている監視コールバックを外すのに使う（ドックはアンロードより先に破棄される）
+	void setCaptureDetachHandler(CaptureDetachHandler handler) { m_captureDetach = handler; }
+
+signals:
+	// wantsCaptureの結果が変わりうるとき（表示・選択・表示方式の変化、ソースの追加）
+	void captureDemandChanged();
+	// ソースの逆相警告が発生・解除された（GUIスレッドで発行する）
+	void phaseAlarmChanged(const QString &uuid, const QString &name, bool active, double correlation);
+
 protected:
 	void paintEvent(QPaintEvent *event) override;
 	void resizeEvent(QResizeEvent *event) override;
+	void showEvent(QShowEvent *event) override;
+	void hideEvent(QHideEvent *event) override;
+	void wheelEvent(QWheelEvent *event) override;
+	void mousePressEvent(QMouseEvent *event) override;
 	void closeEvent(QCloseEvent *event) override;
+	bool eventFilter(QObject *watched, QEvent *event) override;
 
 private slots:
 	void onSourceSelectionChanged();
 	void onColorButtonClicked();
+	void onStatsToggled(bool checked);
+	void onFrameRateChanged();
+	void onIntegrationChanged();
+	void onScopeOptionsChanged();
+	void onDelayPairChanged();
+	void onProgramOnlyToggled(bool checked);
+	void onHistoryChanged();
+	void onAlarmSettingsChanged();
+	void checkAlarms();
 	void updateDisplay();
 
 private:
 	void setupUI();
 	void drawPhaseMeter(QPainter &painter, const QRect &rect);
-	void drawAudioSource(QPainter &painter, const QPoint &center, int radius, const AudioSource &source);
 	void cleanup();
+	const SourceEntry *selectedSource(const SourceList &sources) const;
+	QStringList formatStats() const;
+	void drawStatsOverlay(QPainter &painter, const QRect &rect);
+	void publishConfig(bool analysis, bool scope);
+	size_t scopeWindowFrames() const;
+	void prepareSource(AudioSource &created, const QString &uuid, const QString &name);
+	void syncSourceItems(int slot);
+	void refreshCaptureDemand(bool force = false);
+	void watchWindow();
+	void applyFrameRate();
+	void loadAlarmSettings();
+	void saveAlarmSettings() const;
+	void updateAlarmControls();
+	void updateAlarmLabel();
+	void runReplay(const CaptureReplay &replay);
 
 	QVBoxLayout *m_mainLayout;
 	QHBoxLayout *m_controlLayout;
+	QHBoxLayout *m_optionsLayout;
+	QHBoxLayout *m_delayLayout;
+	QHBoxLayout *m_alarmLayout;
+	QComboBox *m_delayCombo;
+	QLabel *m_delayLabel;
+	QComboBox *m_integrationCombo;
+	QCheckBox *m_exponentialCheck;
+	QComboBox *m_bandsCombo;
+	QComboBox *m_viewCombo;
+	QComboBox *m_fftSizeCombo;
+	QComboBox *m_scopeModeCombo;
+	QComboBox *m_scopeScaleCombo;
+	QComboBox *m_scopePairCombo;
+	QCheckBox *m_autoGainCheck;
 	QComboBox *m_sourceCombo;
 	QPushButton *m_colorButton;
+	QPushButton *m_statsButton;
+	QComboBox *m_frameRateCombo;
+	QCheckBox *m_programOnlyCheck;
+	QComboBox *m_historyCombo;
+	QComboBox *m_historyMetricCombo;
 	QLabel *m_correlationLabel;
+	QCheckBox *m_alarmCheck;
+	QDoubleSpinBox *m_alarmThresholdSpin;
+	QSpinBox *m_alarmHoldSpin;
+	QLabel *m_alarmLabel;
 
-	std::vector<std::unique_ptr<AudioSource>> m_audioSources;
-	QTimer *m_updateTimer;
-	mutable QMutex m_sourcesMutex; // オーディオソース保護用
+	CaptureRecorder m_recorder; // ソースから参照されるのでレジストリより先に宣言する
+	std::atomic<bool> m_alarmPending{false}; // 音声スレッドが警告状態を変えたときに立てる（同上）
+	SourceRegistry m_registry;     // 読むときはロックを取らずに版を受け取る
+	mutable QMutex m_sourcesMutex; // 一覧の書き手同士（追加・削除・名前・色・フィルターの変更）と設定の排他
+	SourceConfig m_sourceConfig;   // 解析スレッドへ渡した設定（m_sourcesMutexで保護）
+	std::atomic<bool> m_repaintQueued{false}; // 解析スレッドが積んだupdateDisplayがまだ走っていない
+	QPointer<QWidget> m_watchedWindow;        // 最小化を見張っているトップレベルウィンドウ
 	bool m_isDestroying;
-	bool m_needsUpdate;
+	bool m_showStats;
+	bool m_displayActive; // ドックが表示されていて、最小化も隠れたタブでもない
+	std::atomic<bool> m_programOnly; // OBSのsource_activate/deactivate（任意のスレッド）からも読む
 
-	// Phase meter specific
-	static constexpr int PHASE_METER_SIZE = 200;
-	static constexpr int SAMPLE_RATE = 48000;
-	static constexpr int BUFFER_SIZE = 1024;
+	// 描画段の統計（GUIスレッドのみが書き込む）
+	PaintStats m_paintStats;
+	uint64_t m_rateWindowStartNs;
+	uint64_t m_rateWindowPaints;
+	double m_paintsPerSecond;
 
-	// 追加の構造体とメンバー
-private:
-	struct RenderData {
+	// 相関の積分設定（出力の実サンプルレートを基準にミリ秒で指定）
+	uint32_t m_sampleRate;
+	double m_integrationMs;
+	CorrelationMeter::Mode m_integrationMode;
+	int m_bandCount; // 帯域別相関の帯域数（0で無効）
+
+	// 出力のチャンネル数（OBSのスピーカー配置。3以上なら相関行列を表示できる）
+	int m_channels;
+
+	// 表示（スコープ / 位相・モノラル互換性スペクトル / ソースごとの小さなスコープを並べたグリッド / 相関行列）
+	enum class ViewMode { Scope, Spectrum, Grid, Matrix };
+	ViewMode m_viewMode;
+	size_t m_fftSize;
+
+	// 相関履歴の帯（表示する時間幅。0で非表示）と、帯に描く値
+	enum class HistoryMetric { Correlation, Width, Level };
+	double m_historySeconds;
+	HistoryMetric m_historyMetric;
+	std::vector<QLine> m_historyRanges; // 描画ごとに使い回す作業領域
+	std::vector<QPoint> m_historyMeans;
+
+	// スコープの表示方式
+	ScopeRasterizer::Mode m_scopeMode;
+	ScopeRasterizer::Scale m_scopeScale;
+	bool m_autoGain;
+	uint32_t m_scopePair; // スコープに描くチャンネルの組（AudioSource::scopePairと同じ形式）
+
+	// 背景とグリッドはサイズ・DPI・表示方式が変わったときだけ描き直してキャッシュする
+	QPixmap m_gridCache;
+	bool m_gridCacheValid;
+
+	// グリッド表示のタイル。ソースの画像か相関値が変わったタイルだけを描き直して使い回す
+	struct GridTile {
+		int slot = -1;
+		uint64_t pixelsVersion = 0;
+		float correlation = 0.0f;
+		bool hasAudio = false;
 		QString name;
 		QColor color;
-		std::vector<float> leftChannel;
-		std::vector<float> rightChannel;
-
-		RenderData(const AudioSource &source)
-			: name(source.name),
-			  color(source.color),
-			  leftChannel(source.leftChannel),
-			  rightChannel(source.rightChannel)
-		{
-		}
+		QImage image; // 名前・スコープ・相関バーまで描いたタイル全体
 	};
+	std::vector<GridTile> m_tiles;
+	std::vector<const SourceFrame *> m_gridSources; // 描画ごとに使い回す作業領域
+	std::vector<int> m_dirtyTiles;
 
-	struct ProcessedAudioData {
-		QColor color;
-		float correlation;
-		std::vector<QPoint> points;
+	// 相関ラベル・遅延ラベルに表示中の値（変化したときだけsetTextする）
+	int m_correlationCenti = INT_MIN; // 相関を表示桁（0.01単位）に丸めた値。描画ごとに文字列を作らない
+	struct DelayDisplay {
+		enum class State { Empty, NoTarget, Measuring, Valid } state = State::Empty;
+		long delayCenti = 0; // 遅延（ms）・ピークを表示桁（0.01単位）に丸めた値
+		long peakCenti = 0;
+		bool inverted = false;
+		bool operator==(const DelayDisplay &) const = default;
 	};
+	DelayDisplay m_delayDisplay;
+
+	// Phase meter specific
+	static constexpr int PHASE_METER_SIZE = 200;
+	static constexpr double SCOPE_WINDOW_MS = 20.0;        // スコープに描く直近サンプルの長さ
+	static constexpr double SCOPE_PERSISTENCE_MS = 150.0;  // スコープの残光の時定数
+	static constexpr double DEFAULT_INTEGRATION_MS = 300.0; // 相関値の積分時間
+	static constexpr int BAND_SLOT_WIDTH = 22;               // 帯域バー1本分の幅
+	static constexpr int BAND_SCALE_WIDTH = 24;              // 帯域バー左の目盛り幅
+	static constexpr size_t DEFAULT_FFT_SIZE = 4096;
+	static constexpr float SPECTRUM_MONO_RANGE_DB = 24.0f; // モノラル損失の表示範囲
+	static constexpr float SPECTRUM_GATE_DB = -70.0f;      // これ未満のレベルの列は描かない
+	static constexpr int GRID_SPACING = 4;                  // グリッドのタイル間隔
+	static constexpr int GRID_LABEL_HEIGHT = 14;            // タイル上端の名前の高さ
+	static constexpr int GRID_BAR_HEIGHT = 6;               // タイル下端の相関バーの高さ
+	static constexpr float GRID_CORRELATION_STEP = 0.005f;  // これ未満の相関の変化ではタイルを描き直さない
+	static constexpr int HISTORY_HEIGHT = 84;               // 履歴の帯の高さ（見出しを含む）
+	static constexpr int HISTORY_SCALE_WIDTH = 28;          // 履歴の帯の左の目盛り幅
+	static constexpr int HISTORY_TITLE_HEIGHT = 14;
+	static constexpr int MATRIX_LABEL_WIDTH = 30;           // 相関行列の行ラベルの幅
+	static constexpr int MATRIX_LABEL_HEIGHT = 16;          // 相関行列の列ラベルの高さ
+	static constexpr int MATRIX_FOOTER_HEIGHT = 20;         // ファントムセンターの行
+	static constexpr int DEFAULT_FRAME_RATE_HZ = 30;        // 表示の目標レート
+	static constexpr int OCCLUDED_FRAME_RATE_HZ = 10;       // 隠れている間のレート（警告の通知には足りる）
+	static constexpr float MATRIX_LEVEL_RANGE_DB = 60.0f;   // 対角に描くレベルの範囲
+	static constexpr float MATRIX_GATE_DB = -70.0f;         // これ未満のチャンネルを含む組は灰色で描く
+
+	// 逆相警告の設定（UUIDごと。プラグインの設定ディレクトリに保存する）
+	// 書き換えはGUIスレッドだけだが、ソースの追加（任意のスレッド）が読むので、書くときはm_sourcesMutexを持つ
+	QHash<QString, PhaseAlarmSettings> m_alarmSettings;
+	CaptureDetachHandler m_captureDetach = nullptr;
+	static constexpr const char *ALARM_CONFIG_FILE = "alarms.json";
+
+	// 記録の再生スレッド（再生中のソースは"replay:"を付けたUUIDで登録する）
+	std::thread m_replayThread;
+	std::atomic<bool> m_replayStop{false};
+	std::atomic<bool> m_replaying{false};
+	static constexpr const char *REPLAY_UUID_PREFIX = "replay:";
 
-	bool m_isProcessing;
+	// 解析スレッド（描画用フレームを公開する）。レジストリとロックより先に破棄されるよう最後に宣言する
+	std::unique_ptr<AnalysisWorker> m_worker;
 
-	// 非同期処理用メソッド
+	// 描画用メソッド（解析済みフレームを描くだけ）
+	QRect meterRect() const;
+	void ensureGridCache(const QSize &size);
+	void splitMeterRect(const QRect &rect, QRect &scope, QRect &bands, QRect &history) const;
 	void drawGrid(QPainter &painter, const QRect &rect);
-	void drawAudioDataAsync(QPainter &painter, const QRect &rect);
-	std::vector<std::future<ProcessedAudioData>>
-	processAudioSourcesParallel(const std::vector<RenderData> &renderData, const QPoint &center, int radius);
-	ProcessedAudioData processAudioSourceData(const RenderData &data, const QPoint &center, int radius);
-	float calculateCorrelationParallel(const std::vector<float> &left, const std::vector<float> &right,
-					   size_t sampleCount);
-	float calculateCorrelationSequential(const std::vector<float> &left, const std::vector<float> &right,
-					     size_t sampleCount);
-	std::vector<QPoint> calculatePhasePointsParallel(const std::vector<float> &left,
-							 const std::vector<float> &right, const QPoint &center,
-							 int radius, size_t sampleCount);
-	void drawProcessedAudioSource(QPainter &painter, const ProcessedAudioData &data);
+	void drawBandGrid(QPainter &painter, const QRect &rect);
+	const SourceFrame *drawAudioFrame(QPainter &painter, const QRect &rect);
+	void drawBandBars(QPainter &painter, const QRect &rect, const SourceFrame &source);
+	void spectrumPanels(const QRect &rect, QRect &mono, QRect &phase) const;
+	void drawSpectrumGrid(QPainter &painter, const QRect &rect);
+	void drawSpectrum(QPainter &painter, const QRect &rect, const SourceFrame &source);
+	void drawSourceFrame(QPainter &painter, const SourceFrame &source, const QRect &target);
+	QRect historyPlot(const QRect &rect) const;
+	void historyScale(float &lowest, float &highest) const;
+	void drawHistoryGrid(QPainter &painter, const QRect &rect);
+	void drawHistory(QPainter &painter, const QRect &rect, const SourceFrame &source);
+	const SourceFrame *drawGridView(QPainter &painter, const QRect &rect);
+	QRect matrixCells(const QRect &rect, int &cell) const;
+	void drawMatrixGrid(QPainter &painter, const QRect &rect);
+	void drawMatrix(QPainter &painter, const QRect &rect, const SourceFrame &source);
+	static void renderTile(GridTile &tile, const SourceFrame &source, int tileSize, qreal dpr, const QFont &font);
 	void updateCorrelationDisplay(float correlation);
+	void updateDelayDisplay(const AnalysisFrame &frame);
 };
\ No newline at end of file
@@ -0,0 +1,195 @@
+/*
+Audoo-phase-meter for OBS
+Copyright (C) 2025 you214 https://github.com/you214
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along
+with this program. If not, see <https://www.gnu.org/licenses/>
+*/
+
+#include "phase-spectrum.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+static constexpr double LOWEST_COLUMN_HZ = 20.0;
+static constexpr double HIGHEST_COLUMN_HZ = 20000.0;
+static constexpr double RAD_TO_DEG = 57.29577951308232;
+
+void PhaseSpectrum::configure(uint32_t sampleRate, size_t fftSize, double smoothingMs)
+{
+	m_sampleRate = std::max<uint32_t>(sampleRate, 1);
+
+	if (fftSize == 0) {
+		m_plan.reset();
+		m_size = 0;
+		m_inputLeft = {};
+		m_inputRight = {};
+		m_work = {};
+		m_crossRe = m_crossIm = m_sumMag = m_absSum = m_energy = {};
+		return;
+	}
+
+	m_plan = FftPlan::get(std::clamp(fftSize, MIN_FFT_SIZE, MAX_FFT_SIZE));
+	m_size = m_plan->size();
+	m_hop = m_size / 2;
+
+	const size_t bins = m_size / 2 + 1;
+	m_inputLeft.assign(m_size, 0.0f);
+	m_inputRight.assign(m_size, 0.0f);
+	m_work.assign(m_size, std::complex<float>());
+	m_crossRe.assign(bins, 0.0f);
+	m_crossIm.assign(bins, 0.0f);
+	m_sumMag.assign(bins, 0.0f);
+	m_absSum.assign(bins, 0.0f);
+	m_energy.assign(bins, 0.0f);
+
+	// 1フレーム（ホップ）ごとの平滑化係数。時定数はミリ秒で指定
+	const double hopMs = 1000.0 * static_cast<double>(m_hop) / m_sampleRate;
+	m_smoothing = static_cast<float>(1.0 - std::exp(-hopMs / std::max(smoothingMs, hopMs)));
+
+	// 窓をかけた正弦波の振幅がそのまま読めるようにするための係数
+	m_amplitudeScale = static_cast<float>(2.0 / m_plan->windowSum());
+
+	// 列の範囲（低域では1つのビンを複数の列が共有する）
+	const double binHz = static_cast<double>(m_sampleRate) / m_size;
+	m_columnStart.resize(COLUMNS);
+	m_columnEnd.resize(COLUMNS);
+	for (int c = 0; c < COLUMNS; ++c) {
+		const size_t lower = static_cast<size_t>(std::lround(columnEdge(c) / binHz));
+		const size_t upper = static_cast<size_t>(std::lround(columnEdge(c + 1) / binHz));
+		const size_t start = std::clamp<size_t>(lower, 1, bins - 1);
+		m_columnStart[c] = static_cast<uint32_t>(start);
+		m_columnEnd[c] = static_cast<uint32_t>(std::clamp<size_t>(upper, start + 1, bins));
+	}
+
+	reset();
+}
+
+void PhaseSpectrum::reset()
+{
+	m_filled = 0;
+	std::fill(m_crossRe.begin(), m_crossRe.end(), 0.0f);
+	std::fill(m_crossIm.begin(), m_crossIm.end(), 0.0f);
+	std::fill(m_sumMag.begin(), m_sumMag.end(), 0.0f);
+	std::fill(m_absSum.begin(), m_absSum.end(), 0.0f);
+	std::fill(m_energy.begin(), m_energy.end(), 0.0f);
+	++m_version;
+}
+
+double PhaseSpectrum::columnEdge(int index)
+{
+	return LOWEST_COLUMN_HZ * std::pow(HIGHEST_COLUMN_HZ / LOWEST_COLUMN_HZ, static_cast<double>(index) / COLUMNS);
+}
+
+void PhaseSpectrum::process(const float *left, const float *right, size_t frames)
+{
+	if (!m_plan || !left || !right) {
+		return;
+	}
+
+	while (frames > 0) {
+		const size_t count = std::min(frames, m_size - m_filled);
+		std::memcpy(m_inputLeft.data() + m_filled, left, count * sizeof(float));
+		std::memcpy(m_inputRight.data() + m_filled, right, count * sizeof(float));
+		m_filled += count;
+		left += count;
+		right += count;
+		frames -= count;
+
+		if (m_filled == m_size) {
+			analyzeFrame();
+
+			// 後半を前へ詰めて、次のフレームと半分重ねる
+			const size_t keep = (m_size - m_hop) * sizeof(float);
+			std::memmove(m_inputLeft.data(), m_inputLeft.data() + m_hop, keep);
+			std::memmove(m_inputRight.data(), m_inputRight.data() + m_hop, keep);
+			m_filled = m_size - m_hop;
+		}
+	}
+}
+
+void PhaseSpectrum::analyzeFrame()
+{
+	const float *window = m_plan->window();
+	std::complex<float> *z = m_work.data();
+
+	for (size_t i = 0; i < m_size; ++i) {
+		z[i] = std::complex<float>(m_inputLeft[i] * window[i], m_inputRight[i] * window[i]);
+	}
+
+	m_plan->forward(z);
+
+	// z = L + iR の変換から L と R を分離する
+	// L[k] = (Z[k] + conj(Z[N-k])) / 2, R[k] = (Z[k] - conj(Z[N-k])) / 2i
+	const size_t bins = m_size / 2 + 1;
+	const float alpha = m_smoothing;
+	const float scale = m_amplitudeScale * 0.5f;
+
+	for (size_t k = 0; k < bins; ++k) {
+		const std::complex<float> a = z[k];
+		const std::complex<float> b = std::conj(z[(m_size - k) & (m_size - 1)]);
+
+		const float lRe = (a.real() + b.real()) * scale;
+		const float lIm = (a.imag() + b.imag()) * scale;
+		const float rRe = (a.imag() - b.imag()) * scale;
+		const float rIm = (b.real() - a.real()) * scale;
+
+		const float crossRe = lRe * rRe + lIm * rIm;
+		const float crossIm = lIm * rRe - lRe * rIm;
+		const float magL = std::sqrt(lRe * lRe + lIm * lIm);
+		const float magR = std::sqrt(rRe * rRe + rIm * rIm);
+		const float sumRe = lRe + rRe;
+		const float sumIm = lIm + rIm;
+		const float magSum = std::sqrt(sumRe * sumRe + sumIm * sumIm);
+
+		m_crossRe[k] += (crossRe - m_crossRe[k]) * alpha;
+		m_crossIm[k] += (crossIm - m_crossIm[k]) * alpha;
+		m_sumMag[k] += (magSum - m_sumMag[k]) * alpha;
+		m_absSum[k] += (magL + magR - m_absSum[k]) * alpha;
+		m_energy[k] += ((magL * magL + magR * magR) * 0.5f - m_energy[k]) * alpha;
+	}
+
+	++m_version;
+}
+
+void PhaseSpectrum::columns(float *phaseDegrees, float *monoDb, float *levelDb) const
+{
+	if (!m_plan) {
+		std::fill(phaseDegrees, phaseDegrees + COLUMNS, 0.0f);
+		std::fill(monoDb, monoDb + COLUMNS, 0.0f);
+		std::fill(levelDb, levelDb + COLUMNS, FLOOR_DB);
+		return;
+	}
+
+	for (int c = 0; c < COLUMNS; ++c) {
+		float crossRe = 0.0f, crossIm = 0.0f, sumMag = 0.0f, absSum = 0.0f, energy = 0.0f;
+		for (uint32_t k = m_columnStart[c]; k < m_columnEnd[c]; ++k) {
+			crossRe += m_crossRe[k];
+			crossIm += m_crossIm[k];
+			sumMag += m_sumMag[k];
+			absSum += m_absSum[k];
+			energy += m_energy[k];
+		}
+
+		// 位相は相互スペクトルのベクトル平均から求める（位相の算術平均は±180度で破綻するため）
+		// Im(L·conj(R)) > 0 はLが進んでいる（Rが遅れている）
+		phaseDegrees[c] = static_cast<float>(std::atan2(crossIm, crossRe) * RAD_TO_DEG);
+
+		// 逆相なら |L+R| が |L|+|R| より小さくなる
+		const float ratio = absSum > 1e-9f ? sumMag / absSum : 1.0f;
+		monoDb[c] = std::max(FLOOR_DB, 20.0f * std::log10(std::max(ratio, 1e-6f)));
+
+		const float bins = static_cast<float>(m_columnEnd[c] - m_columnStart[c]);
+		levelDb[c] = std::max(FLOOR_DB, 10.0f * std::log10(energy / bins + 1e-12f));
+	}
+}
@@ -0,0 +1,86 @@
+/*
+Audoo-phase-meter for OBS
+Copyright (C) 2025 you214 https://github.com/you214
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along
+with this program. If not, see <https://www.gnu.org/licenses/>
+*/
+
+#pragma once
+
+#include <complex>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "fft-plan.h"
+
+// 周波数ビンごとのチャンネル間位相差とモノラル互換性（|L+R| と |L|+|R| の比）
+// 取り出したサンプル列を50%オーバーラップのフレームに分けてFFTし、ビンごとの値を時間方向に平滑化する
+// L と R は1回の複素FFT（z = L + iR）でまとめて変換する
+class PhaseSpectrum {
+public:
+	PhaseSpectrum() = default;
+
+	// fftSize 0で無効（processは何もしない）。バッファはここで確保し、process中は確保しない
+	void configure(uint32_t sampleRate, size_t fftSize, double smoothingMs);
+	void reset();
+
+	void process(const float *left, const float *right, size_t frames);
+
+	bool enabled() const { return m_plan != nullptr; }
+	size_t fftSize() const { return m_size; }
+
+	// 解析したフレームの通し番号（表示側の更新判定用）
+	uint64_t version() const { return m_version; }
+
+	// 表示用の列（対数周波数で COLUMNS 分割）へまとめる
+	// phaseDegrees: L基準のRの位相差（-180〜+180）、monoDb: モノラル化での損失（0以下）、levelDb: 平均レベル（dBFS）
+	void columns(float *phaseDegrees, float *monoDb, float *levelDb) const;
+
+	// 列の下端周波数（index == COLUMNSで上端）
+	static double columnEdge(int index);
+
+	static constexpr size_t MIN_FFT_SIZE = 1024;
+	static constexpr size_t MAX_FFT_SIZE = 8192;
+	static constexpr int COLUMNS = 96;
+	static constexpr float FLOOR_DB = -90.0f;
+
+private:
+	void analyzeFrame();
+
+	std::shared_ptr<const FftPlan> m_plan;
+	uint32_t m_sampleRate = 48000;
+	size_t m_size = 0;
+	size_t m_hop = 0;
+	size_t m_filled = 0;
+	float m_smoothing = 1.0f; // フレームごとの指数平滑化係数
+	float m_amplitudeScale = 1.0f;
+	uint64_t m_version = 0;
+
+	std::vector<float> m_inputLeft;
+	std::vector<float> m_inputRight;
+	std::vector<std::complex<float>> m_work;
+
+	// ビンごとの平滑化済みの値（ビン数 N/2+1）
+	std::vector<float> m_crossRe;  // Re(L·conj(R))
+	std::vector<float> m_crossIm;  // Im(L·conj(R))
+	std::vector<float> m_sumMag;   // |L+R|
+	std::vector<float> m_absSum;   // |L|+|R|
+	std::vector<float> m_energy;   // (|L|²+|R|²)/2
+
+	// 列ごとのビン範囲 [m_columnStart[c], m_columnEnd[c])
+	std::vector<uint32_t> m_columnStart;
+	std::vector<uint32_t> m_columnEnd;
+};
@@ -0,0 +1,96 @@
+/*
+Audoo-phase-meter for OBS
+Copyright (C) 2025 you214 https://github.com/you214
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along
+with this program. If not, see <https://www.gnu.org/licenses/>
+*/
+
+
+#include "phase-tap.h"
+#include "correlation-kernels.h"
+#include <algorithm>
+
+PhaseTap::PhaseTap(size_t decimation)
+	: m_decimation(std::max<size_t>(decimation, 1)),
+	  m_points(POINTS_CAPACITY)
+{
+}
+
+void PhaseTap::process(const float *left, const float *right, size_t frames)
+{
+	if (!left || !right || frames == 0) {
+		return;
+	}
+
+	const CorrelationSums block = correlationSums(left, right, frames);
+	alarm.processSums(block, frames);
+
+	// 累計を更新して公開する（書き込み中はシーケンスが奇数）
+	m_totals += block;
+	m_totalFrames += frames;
+	const uint32_t seq = m_seq.load(std::memory_order_relaxed);
+	m_seq.store(seq + 1, std::memory_order_relaxed);
+	std::atomic_thread_fence(std::memory_order_release);
+	m_publishedLr.store(m_totals.lr, std::memory_order_relaxed);
+	m_publishedLl.store(m_totals.ll, std::memory_order_relaxed);
+	m_publishedRr.store(m_totals.rr, std::memory_order_relaxed);
+	m_publishedFrames.store(m_totalFrames, std::memory_order_relaxed);
+	m_seq.store(seq + 2, std::memory_order_release);
+
+	// 間引いた点は小さな作業領域に集めてからまとめてリングへ書く（直前に読んだ範囲なのでキャッシュに載っている）
+	constexpr size_t STAGE = 256;
+	float stageLeft[STAGE];
+	float stageRight[STAGE];
+	size_t staged = 0;
+	size_t index = m_skip;
+	for (; index < frames; index += m_decimation) {
+		stageLeft[staged] = left[index];
+		stageRight[staged] = right[index];
+		if (++staged == STAGE) {
+			m_points.write(stageLeft, stageRight, staged);
+			staged = 0;
+		}
+	}
+	if (staged > 0) {
+		m_points.write(stageLeft, stageRight, staged);
+	}
+	m_skip = index - frames;
+
+	if (FrameClock *clock = m_clock.load(std::memory_order_acquire)) {
+		clock->signal();
+	}
+}
+
+CorrelationSums PhaseTap::takeSums(uint64_t &frames)
+{
+	uint32_t before, after;
+	CorrelationSums totals;
+	uint64_t totalFrames;
+	do {
+		before = m_seq.load(std::memory_order_acquire);
+		totals.lr = m_publishedLr.load(std::memory_order_relaxed);
+		totals.ll = m_publishedLl.load(std::memory_order_relaxed);
+		totals.rr = m_publishedRr.load(std::memory_order_relaxed);
+		totalFrames = m_publishedFrames.load(std::memory_order_relaxed);
+		std::atomic_thread_fence(std::memory_order_acquire);
+		after = m_seq.load(std::memory_order_relaxed);
+	} while ((before & 1) || before != after);
+
+	CorrelationSums delta = totals;
+	delta -= m_taken;
+	frames = totalFrames - m_takenFrames;
+	m_taken = totals;
+	m_takenFrames = totalFrames;
+	return delta;
+}
@@ -0,0 +1,79 @@
+/*
+Audoo-phase-meter for OBS
+Copyright (C) 2025 you214 https://github.com/you214
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along
+with this program. If not, see <https://www.gnu.org/licenses/>
+*/
+
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+#include "audio-ring-buffer.h"
+#include "correlation-meter.h"
+#include "frame-clock.h"
+#include "phase-alarm.h"
+
+// フィルター"Phase Meter Tap"から解析スレッドへ渡す要約
+// 音声スレッドはバッファを1回なめて積和の累計を更新し、スコープ用に間引いた点だけをリングへ書く。
+// 生のサンプルはコピーしないので、ソースあたりの負荷はキャッシュに載っているバッファへの1パスで済む
+// 生産者（filter_audio）と消費者（解析スレッド）はそれぞれ1つだけ
+class PhaseTap {
+public:
+	explicit PhaseTap(size_t decimation = DEFAULT_DECIMATION);
+
+	PhaseTap(const PhaseTap &) = delete;
+	PhaseTap &operator=(const PhaseTap &) = delete;
+
+	// 生産者側: ブロックを解析する（バッファは読むだけ）
+	void process(const float *left, const float *right, size_t frames);
+
+	// 消費者側: 前回の呼び出しから増えた積和とフレーム数
+	CorrelationSums takeSums(uint64_t &frames);
+
+	// 消費者側: 間引いたスコープ用の点（decimationフレームに1点）
+	AudioRingBuffer &points() { return m_points; }
+	size_t decimation() const { return m_decimation; }
+
+	// 解析スレッドの周期（ドックが受け取っている間だけ設定され、ブロックごとに起こす）
+	void setClock(FrameClock *clock) { m_clock.store(clock, std::memory_order_release); }
+
+	// 逆相の検出もフィルター内で同じ積和から行う
+	PhaseAlarm alarm;
+
+	static constexpr size_t DEFAULT_DECIMATION = 4; // 48kHzで毎秒12000点
+	static constexpr size_t POINTS_CAPACITY = 8192;
+
+private:
+	size_t m_decimation;
+	size_t m_skip = 0; // 次に点を拾うまでに飛ばすフレーム数（ブロックをまたいで間隔を保つ）
+	AudioRingBuffer m_points;
+	std::atomic<FrameClock *> m_clock{nullptr};
+
+	// 積和の累計（生産者だけが書き、シーケンスロックで公開する）
+	CorrelationSums m_totals;
+	uint64_t m_totalFrames = 0;
+	std::atomic<uint32_t> m_seq{0};
+	std::atomic<double> m_publishedLr{0.0};
+	std::atomic<double> m_publishedLl{0.0};
+	std::atomic<double> m_publishedRr{0.0};
+	std::atomic<uint64_t> m_publishedFrames{0};
+
+	// 消費者が前回読んだ累計
+	CorrelationSums m_taken;
+	uint64_t m_takenFrames = 0;
+};
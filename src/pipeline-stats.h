@@ -0,0 +1,81 @@
+/*
+Audoo-phase-meter for OBS
+Copyright (C) 2025 you214 https://github.com/you214
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along
+with this program. If not, see <https://www.gnu.org/licenses/>
+*/
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+
+// パイプライン計測用カウンタ
+// 各カウンタは書き込むスレッドが1つだけなので、fetch_addではなくload+storeで更新する
+// （読み出し側は多少古い値を見るだけで、書き込み側同士がキャッシュラインを奪い合うことはない）
+using StatCounter = std::atomic<uint64_t>;
+
+inline void statAdd(StatCounter &counter, uint64_t value)
+{
+	counter.store(counter.load(std::memory_order_relaxed) + value, std::memory_order_relaxed);
+}
+
+inline void statMax(StatCounter &counter, uint64_t value)
+{
+	if (value > counter.load(std::memory_order_relaxed)) {
+		counter.store(value, std::memory_order_relaxed);
+	}
+}
+
+inline uint64_t statGet(const StatCounter &counter)
+{
+	return counter.load(std::memory_order_relaxed);
+}
+
+inline uint64_t statNowNs()
+{
+	return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+						     std::chrono::steady_clock::now().time_since_epoch())
+					     .count());
+}
+
+// 音声スレッドだけが書き込むカウンタ（キャプチャ段）
+struct alignas(64) CaptureStats {
+	StatCounter blocks{0};
+	StatCounter frames{0};
+	StatCounter callbackNs{0};
+	StatCounter callbackMaxNs{0};
+};
+
+// 解析スレッドだけが書き込むカウンタ（取り出し・解析段）
+struct alignas(64) ConsumeStats {
+	StatCounter drains{0};
+	StatCounter frames{0};
+	StatCounter analyzeNs{0};
+};
+
+// 解析段のカウンタ（解析スレッドのみ）
+struct alignas(64) AnalysisStats {
+	StatCounter cycles{0};
+	StatCounter analyzeNs{0};
+	StatCounter framesPublished{0};
+	StatCounter framesSuperseded{0}; // 描画される前に次のフレームで上書きされた数
+};
+
+// 描画段のカウンタ（GUIスレッドのみ）
+struct alignas(64) PaintStats {
+	StatCounter paints{0};
+	StatCounter paintNs{0};
+};
@@ -26,145 +26,278 @@ with this program. If not, see <https://www.gnu.org/licenses/>
 #include <QAction>
 #include <QMenuBar>
 #include <QApplication>
-#include <QTimer>
 #include <QPointer>
 #include <QMutex>
 #include <QMutexLocker>
 #include <QRandomGenerator>
 #include <QTime>
 #include <QThread>
+#include <QDateTime>
+#include <QFileDialog>
+#include <atomic>
+#include <vector>
 
 #include <obs-module.h>
 #include <plugin-support.h>
 #include <obs-frontend-api.h>
+#include <util/platform.h>
 
 #include "phase-meter-dock.h"
+#include "alloc-tracker.h"
+#include "correlation-kernels.h"
+#include "phase-meter-filter.h"
 
 OBS_DECLARE_MODULE()
 OBS_MODULE_USE_DEFAULT_LOCALE("obs-phase-meter", "en-US")
 
+// 他のプラグイン向けの逆相警告シグナル（コアのシグナルハンドラに宣言する）
+#define PHASE_ALARM_SIGNAL "phase_meter_alarm"
+
 // グローバル変数
 static QPointer<PhaseMeterDock> phaseMeterDock = nullptr;
-static bool moduleUnloading = false;
+static std::atomic<bool> moduleUnloading{false}; // 音声スレッドからも読む
 static bool audioMonitoringActive = false;
-
-static QTimer *updateTimer = nullptr;
-static QMutex pendingDataMutex;
-static QHash<QString, QPair<QVector<float>, QVector<float>>> pendingAudioData;
+static bool startupFinished = false;
+static uint64_t moduleLoadNs = 0;
+// 起動時とシーンコレクションの切り替え中は、作られたソースを1件ずつ登録せず、読み込み後にまとめて登録する
+static std::atomic<bool> deferSourceDiscovery{true};
 
 // 音声データを監視するコールバック
+// OBSの音声スレッドで呼ばれるため、ロック・メモリ確保・ログ出力を行わない
 static void audio_capture_callback(void *data, obs_source_t *source, const struct audio_data *audio_data, bool muted)
 {
-	if (moduleUnloading || !data || !source || !audio_data || muted) {
+	if (moduleUnloading.load(std::memory_order_relaxed) || !data || !source || !audio_data || muted) {
 		return;
 	}
 
-	const char *sourceName = obs_source_get_name(source);
-	if (sourceName) {
-		blog(LOG_INFO, "audio_capture_callback called for source: %s", sourceName);
+	if (audio_data->frames == 0) {
+		return;
 	}
 
-	if (audio_data->data[0] && audio_data->data[1] && audio_data->frames > 0) {
-		if (sourceName) {
-			QMutexLocker locker(&pendingDataMutex);
-			QString sourceNameQt = QString::fromUtf8(sourceName);
+	const AllocScope allocScope(AllocStage::Capture);
 
-			const float *left = reinterpret_cast<const float *>(audio_data->data[0]);
-			const float *right = reinterpret_cast<const float *>(audio_data->data[1]);
+	// 出力のスピーカー配置の平面をすべて渡す（5.1・7.1は相関行列も積算する）
+	AudioSource *target = static_cast<AudioSource *>(data);
+	const float *planes[ChannelMatrix::MAX_CHANNELS];
+	const int channels = std::min(target->channels, ChannelMatrix::MAX_CHANNELS);
+	int count = 0;
+	while (count < channels && audio_data->data[count]) {
+		planes[count] = reinterpret_cast<const float *>(audio_data->data[count]);
+		++count;
+	}
 
-			QVector<float> leftData(left, left + audio_data->frames);
-			QVector<float> rightData(right, right + audio_data->frames);
+	if (count >= 2) {
+		target->pushPlanes(planes, count, audio_data->frames, audio_data->timestamp);
+	}
+}
 
-			pendingAudioData[sourceNameQt] = qMakePair(leftData, rightData);
-			blog(LOG_INFO, "Audio data added for source: %s, frames: %d", sourceName, audio_data->frames);
-		}
+// ソースの識別子（名前変更しても変わらないUUID）
+static QString get_source_uuid(obs_source_t *source)
+{
+	const char *uuid = obs_source_get_uuid(source);
+	return uuid ? QString::fromUtf8(uuid) : QString();
+}
+
+// ソースに対応する書き込み先を取得
+static AudioSource *get_capture_source(PhaseMeterWidget *widget, obs_source_t *source)
+{
+	QString uuid = get_source_uuid(source);
+	if (!widget || uuid.isEmpty()) {
+		return nullptr;
 	}
+	return widget->getCaptureSource(uuid);
 }
 
-// OBSのすべての音声ソースを取得してPhase Meterに追加
-static bool add_audio_source_enum(void *data, obs_source_t *source)
+// 登録する1件（色はランダム）
+static SourceInfo make_source_info(obs_source_t *source)
 {
-	PhaseMeterWidget *widget = static_cast<PhaseMeterWidget *>(data);
+	const char *name = obs_source_get_name(source);
+	QRandomGenerator *rand = QRandomGenerator::global();
+	return SourceInfo{get_source_uuid(source), name ? QString::fromUtf8(name) : QString(),
+			  QColor::fromHsv(rand->bounded(360), 255, 255)};
+}
 
-	if (!source || !widget) {
-		return true;
+// ウィジェットのレジストリへソースを登録
+static AudioSource *register_audio_source(PhaseMeterWidget *widget, obs_source_t *source)
+{
+	if (!obs_source_get_name(source)) {
+		return nullptr;
 	}
+	const SourceInfo info = make_source_info(source);
+	return info.uuid.isEmpty() ? nullptr : widget->addAudioSource(info.uuid, info.name, info.color);
+}
 
-	uint32_t flags = obs_source_get_output_flags(source);
-	if (flags & OBS_SOURCE_AUDIO) {
-		const char *name = obs_source_get_name(source);
-		if (name) {
-			QString sourceName = QString::fromUtf8(name);
-			// ランダムな色を生成
-			QRandomGenerator *rand = QRandomGenerator::global();
-			QColor color = QColor::fromHsv(rand->bounded(360), 255, 255);
-			widget->addAudioSource(sourceName, color);
-		}
+// まとめて登録する音声ソースと、それらに付いているフィルター"Phase Meter Tap"
+struct SourceDiscovery {
+	std::vector<SourceInfo> sources;
+	std::vector<std::pair<QString, std::shared_ptr<PhaseTap>>> taps;
+};
+
+static void collect_tap_enum(obs_source_t *parent, obs_source_t *filter, void *data)
+{
+	std::shared_ptr<PhaseTap> tap = get_phase_meter_tap(filter);
+	if (tap) {
+		static_cast<SourceDiscovery *>(data)->taps.emplace_back(get_source_uuid(parent), tap);
 	}
+}
 
+static bool collect_audio_source_enum(void *data, obs_source_t *source)
+{
+	if (!source || !(obs_source_get_output_flags(source) & OBS_SOURCE_AUDIO) || !obs_source_get_name(source)) {
+		return true;
+	}
+
+	SourceDiscovery *discovery = static_cast<SourceDiscovery *>(data);
+	discovery->sources.push_back(make_source_info(source));
+	obs_source_enum_filters(source, collect_tap_enum, discovery);
 	return true;
 }
 
-// 音声監視のコールバックを追加
-static bool add_monitoring_callback(void *data, obs_source_t *source)
+// フィルター"Phase Meter Tap"が付いた・外れた（任意のスレッドから呼ばれるので、GUIスレッドで反映する）
+// ソースがまだ登録されていなければ何もしない（まとめて登録するときにフィルターも列挙する）
+static void phase_meter_tap_changed(obs_source_t *parent, const std::shared_ptr<PhaseTap> &tap, bool attached)
 {
-	PhaseMeterWidget *widget = static_cast<PhaseMeterWidget *>(data);
-	uint32_t flags = obs_source_get_output_flags(source);
+	if (moduleUnloading || !phaseMeterDock || phaseMeterDock.isNull()) {
+		return;
+	}
 
-	if (flags & OBS_SOURCE_AUDIO) {
-		obs_source_add_audio_capture_callback(source, audio_capture_callback, widget);
+	const QString uuid = get_source_uuid(parent);
+	QMetaObject::invokeMethod(
+		phaseMeterDock.data(),
+		[uuid, tap, attached]() {
+			if (moduleUnloading || !phaseMeterDock || phaseMeterDock.isNull()) {
+				return;
+			}
+			PhaseMeterWidget *widget = phaseMeterDock->getPhaseMeterWidget();
+			if (!widget) {
+				return;
+			}
+			if (attached) {
+				widget->attachTap(uuid, tap);
+			} else {
+				widget->detachTap(uuid, tap);
+			}
+		},
+		Qt::QueuedConnection);
+}
+
+// 監視コールバックを付ける・外す（付いているかはソースごとのフラグで管理し、二重に付け外ししない）
+static void set_capture_attached(obs_source_t *source, AudioSource *target, bool attached)
+{
+	if (attached) {
+		if (!target->attached.exchange(true)) {
+			obs_source_add_audio_capture_callback(source, audio_capture_callback, target);
+		}
+	} else if (target->attached.exchange(false)) {
+		obs_source_remove_audio_capture_callback(source, audio_capture_callback, target);
+	}
+}
+
+// ウィジェットが破棄されるときに、まだ付いている監視コールバックを外す（GUIスレッド）
+// OBSは外すときにコールバックと同じロックを取るので、戻った後にこのソースへ書き込まれることはない
+static void detach_capture(AudioSource &target)
+{
+	const QByteArray uuid = target.uuid.toUtf8();
+	obs_source_t *source = obs_get_source_by_uuid(uuid.constData());
+	if (source) {
+		set_capture_attached(source, &target, false);
+		obs_source_release(source);
 	}
-	return true;
 }
 
-// 音声監視のコールバックを削除
-static bool remove_monitoring_callback(void *data, obs_source_t *source)
+// 表示に必要なソースにだけ監視コールバックを付ける（ドックが見えていなければすべて外す）
+// OBSは監視コールバックが付いたソースごとに音声をコピーするので、見ていないソースの分を払わずに済む
+static bool update_capture_subscription(void *data, obs_source_t *source)
 {
 	PhaseMeterWidget *widget = static_cast<PhaseMeterWidget *>(data);
-	uint32_t flags = obs_source_get_output_flags(source);
+	if (!source || !(obs_source_get_output_flags(source) & OBS_SOURCE_AUDIO)) {
+		return true;
+	}
 
-	if (flags & OBS_SOURCE_AUDIO) {
-		obs_source_remove_audio_capture_callback(source, audio_capture_callback, widget);
+	AudioSource *target = get_capture_source(widget, source);
+	if (target) {
+		const bool wanted = audioMonitoringActive && !moduleUnloading && widget->wantsCapture(target->slot) &&
+				    (!widget->programSourcesOnly() || obs_source_active(source));
+		set_capture_attached(source, target, wanted);
 	}
 	return true;
 }
 
-// 音声監視の開始
-static void start_audio_monitoring()
+// 表示・選択・ソースの状態が変わったときにGUIスレッドで呼ぶ
+static void update_capture_subscriptions()
 {
-	if (!phaseMeterDock || phaseMeterDock.isNull() || audioMonitoringActive) {
+	if (!phaseMeterDock || phaseMeterDock.isNull()) {
 		return;
 	}
 
 	PhaseMeterWidget *widget = phaseMeterDock->getPhaseMeterWidget();
-	if (!widget) {
+	if (widget) {
+		obs_enum_sources(update_capture_subscription, widget);
+	}
+}
+
+// 音声監視の開始（実際に付けるのは表示に必要なソースだけ）
+static void start_audio_monitoring()
+{
+	if (!phaseMeterDock || phaseMeterDock.isNull() || audioMonitoringActive) {
 		return;
 	}
 
-	obs_enum_sources(add_monitoring_callback, widget);
 	audioMonitoringActive = true;
+	update_capture_subscriptions();
 
 	blog(LOG_INFO, "Phase Meter: Audio monitoring started");
 }
 
-// 音声監視の停止
+// 音声監視の停止（付いているコールバックをすべて外す）
 static void stop_audio_monitoring()
 {
 	if (!audioMonitoringActive) {
 		return;
 	}
 
-	PhaseMeterWidget *widget = nullptr;
-	if (phaseMeterDock && !phaseMeterDock.isNull()) {
-		widget = phaseMeterDock->getPhaseMeterWidget();
-	}
-
-	obs_enum_sources(remove_monitoring_callback, widget);
 	audioMonitoringActive = false;
+	update_capture_subscriptions();
 
 	blog(LOG_INFO, "Phase Meter: Audio monitoring stopped");
 }
 
+// 逆相警告を他のプラグインへ知らせる（コアのシグナル"phase_meter_alarm"。GUIスレッドから発行する）
+static void emit_phase_alarm(const QString &uuid, const QString &name, bool active, double correlation)
+{
+	const QByteArray uuidUtf8 = uuid.toUtf8();
+	const QByteArray nameUtf8 = name.toUtf8();
+	obs_source_t *source = obs_get_source_by_uuid(uuidUtf8.constData()); // 再生中の仮のソースならnullptr
+
+	calldata_t data;
+	calldata_init(&data);
+	calldata_set_ptr(&data, "source", source);
+	calldata_set_string(&data, "uuid", uuidUtf8.constData());
+	calldata_set_string(&data, "name", nameUtf8.constData());
+	calldata_set_bool(&data, "active", active);
+	calldata_set_float(&data, "correlation", correlation);
+	signal_handler_signal(obs_get_signal_handler(), PHASE_ALARM_SIGNAL, &data);
+	calldata_free(&data);
+	obs_source_release(source);
+}
+
+// ソースがプログラム出力に出入りしたとき（任意のスレッドから呼ばれる）
+static void source_activity_handler(void *data, calldata_t *calldata)
+{
+	(void)data;     // 未使用パラメータを明示的にマーク
+	(void)calldata; // 未使用パラメータを明示的にマーク
+
+	if (moduleUnloading || !phaseMeterDock || phaseMeterDock.isNull()) {
+		return;
+	}
+
+	PhaseMeterWidget *widget = phaseMeterDock->getPhaseMeterWidget();
+	if (widget && widget->programSourcesOnly()) {
+		QMetaObject::invokeMethod(phaseMeterDock.data(), []() { update_capture_subscriptions(); },
+					  Qt::QueuedConnection);
+	}
+}
+
 // ソースが作成された時のハンドラ
 static void source_create_handler(void *data, calldata_t *calldata)
 {
@@ -175,24 +308,18 @@ static void source_create_handler(void *data, calldata_t *calldata)
 		return;
 	}
 
+	// 読み込み中のソースは、読み込みが終わってからまとめて登録する
+	if (deferSourceDiscovery.load()) {
+		return;
+	}
+
 	uint32_t flags = obs_source_get_output_flags(source);
 	if (flags & OBS_SOURCE_AUDIO) {
 		if (phaseMeterDock && !phaseMeterDock.isNull()) {
 			PhaseMeterWidget *widget = phaseMeterDock->getPhaseMeterWidget();
 			if (widget) {
-				const char *name = obs_source_get_name(source);
-				if (name) {
-					QString sourceName = QString::fromUtf8(name);
-					QRandomGenerator *rand = QRandomGenerator::global();
-					QColor color = QColor::fromHsv(rand->bounded(360), 255, 255);
-					widget->addAudioSource(sourceName, color);
-
-					// 新しいソースに監視コールバックを追加
-					if (audioMonitoringActive) {
-						obs_source_add_audio_capture_callback(source, audio_capture_callback,
-										      widget);
-					}
-				}
+				// 監視コールバックは表示に必要になったときに付ける（captureDemandChanged経由）
+				register_audio_source(widget, source);
 			}
 		}
 	}
@@ -211,21 +338,37 @@ static void source_destroy_handler(void *data, calldata_t *calldata)
 	if (phaseMeterDock && !phaseMeterDock.isNull()) {
 		PhaseMeterWidget *widget = phaseMeterDock->getPhaseMeterWidget();
 		if (widget) {
-			const char *name = obs_source_get_name(source);
-			if (name) {
-				QString sourceName = QString::fromUtf8(name);
-				widget->removeAudioSource(sourceName);
-
-				// 監視コールバックを削除
-				if (audioMonitoringActive) {
-					obs_source_remove_audio_capture_callback(source, audio_capture_callback,
-										 widget);
-				}
+			AudioSource *target = get_capture_source(widget, source);
+			if (target) {
+				// リングを解放する前に監視コールバックを削除
+				set_capture_attached(source, target, false);
+
+				const QString uuid = target->uuid;
+				widget->removeAudioSource(uuid);
 			}
 		}
 	}
 }
 
+// ソース名が変更された時のハンドラ（表示ラベルだけを更新する）
+static void source_rename_handler(void *data, calldata_t *calldata)
+{
+	(void)data; // 未使用パラメータを明示的にマーク
+
+	obs_source_t *source = static_cast<obs_source_t *>(calldata_ptr(calldata, "source"));
+	const char *newName = calldata_string(calldata, "new_name");
+	if (!source || !newName || moduleUnloading) {
+		return;
+	}
+
+	if (phaseMeterDock && !phaseMeterDock.isNull()) {
+		PhaseMeterWidget *widget = phaseMeterDock->getPhaseMeterWidget();
+		if (widget) {
+			widget->renameAudioSource(get_source_uuid(source), QString::fromUtf8(newName));
+		}
+	}
+}
+
 // メニューアクションのセットアップ
 static void setupMenuAction(QMainWindow *mainWindow)
 {
@@ -280,7 +423,94 @@ static void setupMenuAction(QMainWindow *mainWindow)
 	}
 }
 
-// Phase Meterドックの作成
+// ツールメニューからパイプライン統計をログへ出力
+static void dump_stats_menu_clicked(void *data)
+{
+	(void)data; // 未使用パラメータを明示的にマーク
+
+	if (phaseMeterDock && !phaseMeterDock.isNull()) {
+		PhaseMeterWidget *widget = phaseMeterDock->getPhaseMeterWidget();
+		if (widget) {
+			widget->dumpStats();
+		}
+	}
+}
+
+// キャプチャの記録先（プラグインの設定フォルダ）
+static QString captures_directory()
+{
+	char *path = obs_module_config_path("captures");
+	if (!path) {
+		return QString();
+	}
+	os_mkdirs(path);
+	QString directory = QString::fromUtf8(path);
+	bfree(path);
+	return directory;
+}
+
+// ツールメニューからキャプチャの記録を開始・停止する
+static void toggle_recording_menu_clicked(void *data)
+{
+	(void)data; // 未使用パラメータを明示的にマーク
+
+	if (!phaseMeterDock || phaseMeterDock.isNull()) {
+		return;
+	}
+	PhaseMeterWidget *widget = phaseMeterDock->getPhaseMeterWidget();
+	if (!widget) {
+		return;
+	}
+
+	if (widget->isRecording()) {
+		widget->stopRecording();
+		return;
+	}
+
+	const QString directory = captures_directory();
+	if (directory.isEmpty()) {
+		return;
+	}
+	const QString path = QString("%1/phase-meter-%2.pmrec")
+				     .arg(directory, QDateTime::currentDateTime().toString("yyyyMMdd-HHmmss"));
+	QString error;
+	if (!widget->startRecording(path, error)) {
+		blog(LOG_WARNING, "Phase Meter: Cannot start recording: %s", error.toUtf8().constData());
+	}
+}
+
+// ツールメニューから記録したキャプチャを選んで実時間で再生する（再生中なら停止する）
+static void replay_menu_clicked(void *data)
+{
+	(void)data; // 未使用パラメータを明示的にマーク
+
+	if (!phaseMeterDock || phaseMeterDock.isNull()) {
+		return;
+	}
+	PhaseMeterWidget *widget = phaseMeterDock->getPhaseMeterWidget();
+	if (!widget) {
+		return;
+	}
+
+	if (widget->isReplaying()) {
+		widget->stopReplay();
+		return;
+	}
+
+	const QString path = QFileDialog::getOpenFileName(static_cast<QWidget *>(obs_frontend_get_main_window()),
+							  "Replay Phase Meter Capture", captures_directory(),
+							  "Phase meter captures (*.pmrec)");
+	if (path.isEmpty()) {
+		return;
+	}
+	QString error;
+	if (!widget->startReplay(path, error)) {
+		blog(LOG_WARNING, "Phase Meter: Cannot replay %s: %s", path.toUtf8().constData(),
+		     error.toUtf8().constData());
+	}
+}
+
+// Phase Meterドックの作成（ソースの登録は読み込みが終わってから行う）
 static void createPhaseMeterDock()
 {
 	QMainWindow *mainWindow = static_cast<QMainWindow *>(obs_frontend_get_main_window());
@@ -288,45 +518,53 @@ static void createPhaseMeterDock()
 		return;
 	}
 
+	const uint64_t start = os_gettime_ns();
+
 	phaseMeterDock = new PhaseMeterDock(mainWindow);
 	mainWindow->addDockWidget(Qt::RightDockWidgetArea, phaseMeterDock);
 
 	// メニューアクションの設定
 	setupMenuAction(mainWindow);
+	obs_frontend_add_tools_menu_item("Phase Meter: Dump Stats", dump_stats_menu_clicked, nullptr);
+	obs_frontend_add_tools_menu_item("Phase Meter: Start/Stop Capture Recording", toggle_recording_menu_clicked,
+					 nullptr);
+	obs_frontend_add_tools_menu_item("Phase Meter: Replay Capture...", replay_menu_clicked, nullptr);
 
-	// 音声ソースを列挙して追加
 	PhaseMeterWidget *widget = phaseMeterDock->getPhaseMeterWidget();
 	if (widget) {
-		obs_enum_sources(add_audio_source_enum, widget);
-
-		updateTimer = new QTimer();
-		updateTimer->setInterval(33); // 30fps
-		QObject::connect(updateTimer, &QTimer::timeout, []() {
-			if (phaseMeterDock && !phaseMeterDock.isNull()) {
-				PhaseMeterWidget *widget = phaseMeterDock->getPhaseMeterWidget();
-				if (widget) {
-					QMutexLocker locker(&pendingDataMutex);
-					if (!pendingAudioData.isEmpty()) {
-						for (auto it = pendingAudioData.begin(); it != pendingAudioData.end();
-						     ++it) {
-							const QString &sourceName = it.key();
-							const QVector<float> &leftData = it.value().first;
-							const QVector<float> &rightData = it.value().second;
-
-							widget->updateAudioData(sourceName, leftData.data(),
-										rightData.data(), leftData.size());
-						}
-						pendingAudioData.clear();
-					}
-				}
-			}
-		});
-		updateTimer->start();
+		// 表示・選択が変わるたびに、監視するソースを付け替える
+		QObject::connect(widget, &PhaseMeterWidget::captureDemandChanged, widget,
+				 []() { update_capture_subscriptions(); });
+		QObject::connect(widget, &PhaseMeterWidget::phaseAlarmChanged, widget, emit_phase_alarm);
+		widget->setCaptureDetachHandler(detach_capture);
+	}
 
-		start_audio_monitoring();
+	blog(LOG_INFO, "Phase Meter: Dock created in %.1f ms", (os_gettime_ns() - start) / 1e6);
+}
+
+// 音声ソースを1回の列挙でまとめて登録する（一覧の差し替えとコンボの作り直しも1回ずつ）
+// 先にフラグを戻すので、列挙中に作られたソースは個別に登録される（重複した登録は無視される）
+static void discover_audio_sources()
+{
+	deferSourceDiscovery = false;
+	if (!phaseMeterDock || phaseMeterDock.isNull()) {
+		return;
+	}
+	PhaseMeterWidget *widget = phaseMeterDock->getPhaseMeterWidget();
+	if (!widget) {
+		return;
+	}
+
+	const uint64_t start = os_gettime_ns();
+	SourceDiscovery discovery;
+	obs_enum_sources(collect_audio_source_enum, &discovery);
+	const size_t added = widget->addAudioSources(discovery.sources);
+	for (const auto &[uuid, tap] : discovery.taps) {
+		widget->attachTap(uuid, tap);
 	}
 
-	blog(LOG_INFO, "Phase Meter: Dock created successfully");
+	blog(LOG_INFO, "Phase Meter: Registered %zu of %zu audio sources in %.1f ms", added, discovery.sources.size(),
+	     (os_gettime_ns() - start) / 1e6);
 }
 
 // OBSのイベントハンドラ
@@ -336,12 +574,21 @@ static void obs_event_handler(enum obs_frontend_event event, void *data)
 
 	switch (event) {
 	case OBS_FRONTEND_EVENT_FINISHED_LOADING:
-		// OBSの読み込み完了後に音声ソースを再列挙
-		if (phaseMeterDock && !phaseMeterDock.isNull()) {
-			PhaseMeterWidget *widget = phaseMeterDock->getPhaseMeterWidget();
-			if (widget) {
-				widget->refreshAudioSources();
-			}
+		// ドックはobs_module_post_loadで作っている（メインウィンドウが無かったときだけここで作る）
+		createPhaseMeterDock();
+		discover_audio_sources();
+		// 音声データはリングバッファ経由でウィジェットが直接読み出す
+		start_audio_monitoring();
+		startupFinished = true;
+		blog(LOG_INFO, "Phase Meter: Ready %.1f ms after module load", (os_gettime_ns() - moduleLoadNs) / 1e6);
+		break;
+	case OBS_FRONTEND_EVENT_SCENE_COLLECTION_CHANGING:
+		deferSourceDiscovery = true;
+		break;
+	case OBS_FRONTEND_EVENT_SCENE_COLLECTION_CHANGED:
+		// 起動時の読み込みはFINISHED_LOADINGでまとめて登録する
+		if (startupFinished) {
+			discover_audio_sources();
 		}
 		break;
 	case OBS_FRONTEND_EVENT_EXIT:
@@ -354,18 +601,27 @@ static void obs_event_handler(enum obs_frontend_event event, void *data)
 
 bool obs_module_load(void)
 {
+	moduleLoadNs = os_gettime_ns();
 	blog(LOG_INFO, "Phase Meter: Loading plugin...");
+	blog(LOG_INFO, "Phase Meter: Correlation kernel: %s", kernelIsaName(activeKernelIsa()));
 
 	// OBSイベントハンドラを登録
 	obs_frontend_add_event_callback(obs_event_handler, nullptr);
 
+	// 見たいソースにだけ付ける音声フィルター（付いたソースは監視コールバックの代わりにフィルターから受け取る）
+	register_phase_meter_tap(phase_meter_tap_changed);
+
 	// ソース作成・削除のシグナルハンドラを登録
 	signal_handler_t *core_signals = obs_get_signal_handler();
 	signal_handler_connect(core_signals, "source_create", source_create_handler, nullptr);
 	signal_handler_connect(core_signals, "source_destroy", source_destroy_handler, nullptr);
+	signal_handler_connect(core_signals, "source_rename", source_rename_handler, nullptr);
+	signal_handler_connect(core_signals, "source_activate", source_activity_handler, nullptr);
+	signal_handler_connect(core_signals, "source_deactivate", source_activity_handler, nullptr);
 
-	// 短い遅延でドックを作成
-	QTimer::singleShot(500, createPhaseMeterDock);
+	// 他のプラグインが逆相警告を受け取れるようにシグナルを宣言する
+	signal_handler_add(core_signals, "void " PHASE_ALARM_SIGNAL
+					 "(ptr source, string uuid, string name, bool active, float correlation)");
 
 	blog(LOG_INFO, "Phase Meter: Plugin loaded successfully");
 	return true;
@@ -380,12 +636,6 @@ void obs_module_unload(void)
 	// 音声監視を停止
 	stop_audio_monitoring();
 
-	if (updateTimer) {
-		updateTimer->stop();
-		delete updateTimer;
-		updateTimer = nullptr;
-	}
-
 	// 少し待機してからリソースを解放
 	if (QApplication::instance()) {
 		QApplication::processEvents();
@@ -396,6 +646,9 @@ void obs_module_unload(void)
 	signal_handler_t *core_signals = obs_get_signal_handler();
 	signal_handler_disconnect(core_signals, "source_create", source_create_handler, nullptr);
 	signal_handler_disconnect(core_signals, "source_destroy", source_destroy_handler, nullptr);
+	signal_handler_disconnect(core_signals, "source_rename", source_rename_handler, nullptr);
+	signal_handler_disconnect(core_signals, "source_activate", source_activity_handler, nullptr);
+	signal_handler_disconnect(core_signals, "source_deactivate", source_activity_handler, nullptr);
 
 	// イベントハンドラを削除
 	obs_frontend_remove_event_callback(obs_event_handler, nullptr);
@@ -416,4 +669,9 @@ void obs_module_unload(void)
 	blog(LOG_INFO, "Phase Meter: Plugin unloaded successfully");
 }
 
-void obs_module_post_load(void) {}
+// すべてのモジュールを読み込んだ後、シーンコレクションを読み込む前に呼ばれる
+// ドックはここで作り、ソースはFINISHED_LOADINGでまとめて登録する（固定の待ち時間に頼らない）
+void obs_module_post_load(void)
+{
+	createPhaseMeterDock();
+}
@@ -0,0 +1,246 @@
+/*
+Audoo-phase-meter for OBS
+Copyright (C) 2025 you214 https://github.com/you214
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along
+with this program. If not, see <https://www.gnu.org/licenses/>
+*/
+
+#include "scope-rasterizer.h"
+#include <algorithm>
+#include <cmath>
+
+// 打点をまとめて座標計算するバッチ長（座標計算のループをベクトル化させるため）
+static constexpr size_t PROJECT_BATCH = 256;
+
+// 表示上の半径がこれ未満（線形目盛りで-40dBFS）の点は中心に溜まるだけなので打点しない
+static constexpr float MIN_RADIUS = 0.01f;
+
+// 自動ゲイン: ピークがこの値になるように持ち上げる。速く追従して（アタック）ゆっくり戻す（リリース）
+static constexpr float AUTO_GAIN_TARGET = 0.7f;
+static constexpr float AUTO_GAIN_MAX = 31.6f; // +30dB
+static constexpr double AUTO_GAIN_ATTACK_MS = 10.0;
+static constexpr double AUTO_GAIN_RELEASE_MS = 1500.0;
+
+static constexpr float INV_SQRT2 = 0.70710678f;
+
+// 密度がこの値で明るさ50%になる（トーンマップの膝）
+static constexpr float DENSITY_KNEE = 1.0f;
+
+// 減衰でこの値を下回ったら表示上は消えたとみなす
+static constexpr float DENSITY_EPSILON = 1e-3f;
+
+void ScopeRasterizer::resize(int size)
+{
+	size = std::clamp(size, 16, 2048);
+	if (size == m_size) {
+		return;
+	}
+
+	m_size = size;
+	m_density.assign(static_cast<size_t>(size) * size, 0.0f);
+	m_active = false;
+	++m_version;
+}
+
+void ScopeRasterizer::setPersistence(double persistenceMs, uint32_t sampleRate)
+{
+	m_persistenceMs = std::max(persistenceMs, 1.0);
+	m_sampleRate = sampleRate > 0 ? sampleRate : 48000;
+
+	// 48kHzの1サンプルを重み1とし、サンプルレートが違っても同じ明るさになるようにする
+	m_weight = sampleRate > 0 ? 48000.0f / static_cast<float>(sampleRate) : 1.0f;
+}
+
+void ScopeRasterizer::setProjection(Mode mode, Scale scale, bool autoGain)
+{
+	if (mode == m_mode && scale == m_scale && autoGain == m_autoGain) {
+		return;
+	}
+
+	m_mode = mode;
+	m_scale = scale;
+	m_autoGain = autoGain;
+	m_envelope = 0.0f;
+	m_gain = 1.0f;
+	clear();
+}
+
+void ScopeRasterizer::updateGain(const float *left, const float *right, size_t frames)
+{
+	float peak = 0.0f;
+	for (size_t i = 0; i < frames; ++i) {
+		peak = std::max(peak, std::max(std::fabs(left[i]), std::fabs(right[i])));
+	}
+
+	// バッチ単位のピークに一次の追従をかける（係数はバッチ長から求めるのでサンプルレートに依存しない）
+	const double frameMs = 1000.0 * static_cast<double>(frames) / m_sampleRate;
+	const double timeConstant = peak > m_envelope ? AUTO_GAIN_ATTACK_MS : AUTO_GAIN_RELEASE_MS;
+	const float coefficient = static_cast<float>(1.0 - std::exp(-frameMs / timeConstant));
+	m_envelope += (peak - m_envelope) * coefficient;
+
+	m_gain = AUTO_GAIN_TARGET / std::max(m_envelope, AUTO_GAIN_TARGET / AUTO_GAIN_MAX);
+}
+
+void ScopeRasterizer::setColor(uint32_t rgb)
+{
+	rgb &= 0xFFFFFF;
+	if (m_lutValid && rgb == m_rgb) {
+		return;
+	}
+
+	m_rgb = rgb;
+	rebuildLut();
+	++m_version;
+}
+
+void ScopeRasterizer::rebuildLut()
+{
+	const float r = ((m_rgb >> 16) & 0xFF) / 255.0f;
+	const float g = ((m_rgb >> 8) & 0xFF) / 255.0f;
+	const float b = (m_rgb & 0xFF) / 255.0f;
+
+	for (int i = 0; i < 256; ++i) {
+		// 下半分で音源色まで明るくし、上半分で白へ近づける（アナログスコープの輝点風）
+		const float t = i / 255.0f;
+		const float base = std::min(1.0f, t * 2.0f);
+		const float white = std::max(0.0f, t * 2.0f - 1.0f) * 0.6f;
+		const float alpha = base;
+
+		auto channel = [&](float c) {
+			const float value = std::min(1.0f, c * base + white);
+			return static_cast<uint32_t>(value * alpha * 255.0f + 0.5f);
+		};
+
+		const uint32_t a = static_cast<uint32_t>(alpha * 255.0f + 0.5f);
+		m_lut[i] = (a << 24) | (channel(r) << 16) | (channel(g) << 8) | channel(b);
+	}
+	m_lut[0] = 0;
+	m_lutValid = true;
+}
+
+void ScopeRasterizer::accumulate(const float *left, const float *right, size_t frames)
+{
+	if (m_size == 0 || frames == 0) {
+		return;
+	}
+
+	const float half = (m_size - 1) * 0.5f;
+	const int32_t limit = m_size - 1;
+	const float weight = m_weight;
+	const bool decibel = m_scale == Scale::Decibel;
+	// 10*log10(|p|^2) / range を log2 で計算するための係数
+	const float decibelFactor = 10.0f * 0.30103f / DECIBEL_RANGE;
+	float *density = m_density.data();
+
+	int32_t index[PROJECT_BATCH];
+	float deposit[PROJECT_BATCH];
+
+	for (size_t start = 0; start < frames; start += PROJECT_BATCH) {
+		const size_t count = std::min(PROJECT_BATCH, frames - start);
+		const float *l = left + start;
+		const float *r = right + start;
+
+		if (m_autoGain) {
+			updateGain(l, r, count);
+		}
+
+		// 画面座標（yは下向き）への変換行列。ゲインもここに畳み込む
+		float xl, xr, yl, yr;
+		if (m_mode == Mode::Goniometer) {
+			// Side = (R - L)/√2 を右向き、Mid = (L + R)/√2 を上向きに（L単独は左上、R単独は右上）
+			xl = -INV_SQRT2 * m_gain;
+			xr = INV_SQRT2 * m_gain;
+			yl = -INV_SQRT2 * m_gain;
+			yr = -INV_SQRT2 * m_gain;
+		} else {
+			xl = m_gain;
+			xr = 0.0f;
+			yl = 0.0f;
+			yr = m_gain;
+		}
+
+		// 座標計算（分岐なしの演算だけなのでSIMD化される）
+		for (size_t i = 0; i < count; ++i) {
+			const float px0 = xl * l[i] + xr * r[i];
+			const float py0 = yl * l[i] + yr * r[i];
+			const float magnitudeSq = px0 * px0 + py0 * py0;
+			const float magnitude = std::sqrt(magnitudeSq);
+
+			// 表示上の半径。dB目盛りでは -DECIBEL_RANGE dB が中心、0dB が円周
+			const float radius = decibel ? std::max(0.0f, 1.0f + decibelFactor * std::log2(magnitudeSq + 1e-20f))
+						     : magnitude;
+			const float clamped = std::min(radius, 1.0f);
+			const float scale = magnitude > 0.0f ? clamped / magnitude : 0.0f;
+
+			const float x = px0 * scale * half + half;
+			const float y = py0 * scale * half + half;
+			// NaNなど異常値でも範囲外へ書かないよう整数側で丸め込む（その場合の重みは0）
+			const int32_t px = std::clamp(static_cast<int32_t>(x + 0.5f), 0, limit);
+			const int32_t py = std::clamp(static_cast<int32_t>(y + 0.5f), 0, limit);
+			index[i] = py * m_size + px;
+			deposit[i] = radius > MIN_RADIUS ? weight : 0.0f;
+		}
+
+		// 打点（散らばった書き込みなのでスカラー）
+		for (size_t i = 0; i < count; ++i) {
+			density[index[i]] += deposit[i];
+		}
+	}
+
+	m_active = true;
+	++m_version;
+}
+
+bool ScopeRasterizer::decay(double elapsedMs)
+{
+	if (!m_active || m_size == 0) {
+		return false;
+	}
+
+	const float factor = static_cast<float>(std::exp(-elapsedMs / m_persistenceMs));
+	float peak = 0.0f;
+	for (float &value : m_density) {
+		value *= factor;
+		peak = std::max(peak, value);
+	}
+
+	// 完全に消えたら以降の減衰・再変換を止める
+	if (peak < DENSITY_EPSILON) {
+		std::fill(m_density.begin(), m_density.end(), 0.0f);
+		m_active = false;
+	}
+
+	++m_version;
+	return true;
+}
+
+void ScopeRasterizer::render(uint32_t *out) const
+{
+	const size_t count = m_density.size();
+	const float *density = m_density.data();
+
+	for (size_t i = 0; i < count; ++i) {
+		// 飽和するトーンマップ d / (d + knee) を0〜255へ
+		const float d = density[i];
+		const int level = static_cast<int>(d * 255.0f / (d + DENSITY_KNEE));
+		out[i] = m_lut[level];
+	}
+}
+
+void ScopeRasterizer::clear()
+{
+	std::fill(m_density.begin(), m_density.end(), 0.0f);
+	m_active = false;
+	++m_version;
+}
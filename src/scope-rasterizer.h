@@ -0,0 +1,88 @@
+/*
+Audoo-phase-meter for OBS
+Copyright (C) 2025 you214 https://github.com/you214
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along
+with this program. If not, see <https://www.gnu.org/licenses/>
+*/
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// 全サンプルを密度バッファへ打点し、蛍光体のような残光（指数減衰）を付けてARGB画像にするラスタライザ
+// コストは「サンプル数」と「画素数」に比例し、描画プリミティブの数には依存しない
+class ScopeRasterizer {
+public:
+	// Lissajous: x = L, y = R / Goniometer: 45度回転して縦軸にMid、横軸にSide
+	enum class Mode { Lissajous, Goniometer };
+	// 半径方向の目盛り（Decibelは DECIBEL_RANGE dB を半径いっぱいに割り当てる）
+	enum class Scale { Linear, Decibel };
+
+	ScopeRasterizer() = default;
+
+	// 一辺の画素数を設定する（変更時は密度をクリア）
+	void resize(int size);
+	int size() const { return m_size; }
+
+	// 残光の時定数とサンプルレート（打点の重みをサンプルレートに依存させないため）
+	void setPersistence(double persistenceMs, uint32_t sampleRate);
+
+	// 表示方式と自動ゲインの設定（変更時は密度をクリア）
+	void setProjection(Mode mode, Scale scale, bool autoGain);
+
+	// 自動ゲインの現在値（自動ゲイン無効時は1）
+	float gain() const { return m_gain; }
+
+	// 音源の色からカラーLUTを作り直す（色が変わらなければ何もしない）
+	void setColor(uint32_t rgb);
+
+	// 全サンプルを打点する。座標変換は2x2行列の積和のみ（単位円の外は円周上に収める）
+	void accumulate(const float *left, const float *right, size_t frames);
+
+	// 経過時間に応じて減衰させる。表示に変化があり得る場合はtrue
+	bool decay(double elapsedMs);
+
+	// 密度をLUTでARGB（乗算済みアルファ）へ変換する。outは size*size 要素
+	void render(uint32_t *out) const;
+
+	void clear();
+
+	// 表示内容が変わるたびに増える番号（フレーム側の再変換要否の判定に使う）
+	uint64_t version() const { return m_version; }
+
+	static constexpr int DEFAULT_SIZE = 256;
+	static constexpr float DECIBEL_RANGE = 48.0f;
+
+private:
+	void rebuildLut();
+	void updateGain(const float *left, const float *right, size_t frames);
+
+	int m_size = 0;
+	std::vector<float> m_density;
+	float m_weight = 1.0f;
+	double m_persistenceMs = 150.0;
+	uint32_t m_sampleRate = 48000;
+	Mode m_mode = Mode::Lissajous;
+	Scale m_scale = Scale::Linear;
+	bool m_autoGain = false;
+	float m_envelope = 0.0f; // 自動ゲイン用のピーク追従値
+	float m_gain = 1.0f;
+	uint32_t m_rgb = 0;
+	bool m_lutValid = false;
+	bool m_active = false; // 減衰しきっていない点が残っているか
+	uint64_t m_version = 0;
+	uint32_t m_lut[256] = {};
+};
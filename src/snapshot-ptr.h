@@ -0,0 +1,147 @@
+/*
+Audoo-phase-meter for OBS
+Copyright (C) 2025 you214 https://github.com/you214
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along
+with this program. If not, see <https://www.gnu.org/licenses/>
+*/
+
+#pragma once
+
+#include <atomic>
+#include <cassert>
+#include <cstdint>
+#include <utility>
+
+// 公開した後は変更しない値を、読み手がロックを取らずに受け取るためのポインタ（RCU風）
+// 書き手は新しい値を作ってpublish()で差し替え、古い値は最後の読み手が手放したときに解放される
+//
+// 参照カウントは2段に分ける（split reference counting）
+// - 外側: ポインタと同じ64bit語の下位16bitに詰める。acquire()は1回のfetch_addで値とカウントを同時に取る
+// - 内側: 値ごとのカウント。差し替えたときに外側の分を移し、以降の手放しは内側から引く
+// ポインタは下位48bitに収まる前提（x86-64・AArch64のユーザー空間）。同時に持てるスナップショットは65535個まで
+// 書き手同士は呼び出し側で排他すること
+template<typename T> class SnapshotPtr {
+	struct Node {
+		template<typename... Args> explicit Node(Args &&...args) : value(std::forward<Args>(args)...) {}
+		T value;
+		std::atomic<int64_t> inner{0};
+	};
+
+public:
+	// 読み手が持つ1版分の参照。持っている間は値が解放されない
+	class Snapshot {
+	public:
+		Snapshot() = default;
+		Snapshot(Snapshot &&other) noexcept
+			: m_owner(other.m_owner),
+			  m_node(std::exchange(other.m_node, nullptr))
+		{
+		}
+		Snapshot &operator=(Snapshot &&other) noexcept
+		{
+			if (this != &other) {
+				reset();
+				m_owner = other.m_owner;
+				m_node = std::exchange(other.m_node, nullptr);
+			}
+			return *this;
+		}
+		Snapshot(const Snapshot &) = delete;
+		Snapshot &operator=(const Snapshot &) = delete;
+		~Snapshot() { reset(); }
+
+		void reset()
+		{
+			if (m_node) {
+				m_owner->release(m_node);
+				m_node = nullptr;
+			}
+		}
+
+		explicit operator bool() const { return m_node != nullptr; }
+		const T &operator*() const { return m_node->value; }
+		const T *operator->() const { return &m_node->value; }
+
+	private:
+		friend class SnapshotPtr;
+		Snapshot(const SnapshotPtr *owner, Node *node) : m_owner(owner), m_node(node) {}
+
+		const SnapshotPtr *m_owner = nullptr;
+		Node *m_node = nullptr;
+	};
+
+	// 既定値で始める（acquire()は常に有効な値を返す）
+	SnapshotPtr() { publish(T()); }
+	~SnapshotPtr() { retire(m_packed.exchange(0, std::memory_order_acq_rel)); } // 読み手が残っていないこと
+
+	SnapshotPtr(const SnapshotPtr &) = delete;
+	SnapshotPtr &operator=(const SnapshotPtr &) = delete;
+
+	// 読み手: 現在の値を受け取る（ロックもメモリ確保もしない）
+	Snapshot acquire() const
+	{
+		const uint64_t packed = m_packed.fetch_add(1, std::memory_order_acquire);
+		return Snapshot(this, nodeOf(packed));
+	}
+
+	// 書き手: 値を差し替える。古い値は読み手がいなくなった時点で解放される
+	void publish(T value)
+	{
+		Node *node = new Node(std::move(value));
+		assert((reinterpret_cast<uintptr_t>(node) >> POINTER_BITS) == 0);
+		retire(m_packed.exchange(static_cast<uint64_t>(reinterpret_cast<uintptr_t>(node)) << COUNT_BITS,
+					 std::memory_order_acq_rel));
+	}
+
+private:
+	static constexpr int COUNT_BITS = 16;
+	static constexpr int POINTER_BITS = 48;
+	static constexpr uint64_t COUNT_MASK = (uint64_t(1) << COUNT_BITS) - 1;
+	static_assert(sizeof(void *) == 8, "SnapshotPtr packs a pointer into 48 bits");
+
+	static Node *nodeOf(uint64_t packed)
+	{
+		return reinterpret_cast<Node *>(static_cast<uintptr_t>(packed >> COUNT_BITS));
+	}
+
+	void release(Node *node) const
+	{
+		// まだ現在の値なら外側のカウントを戻す（外側は同時に持たれている数だけで済み、溢れない）
+		uint64_t packed = m_packed.load(std::memory_order_relaxed);
+		while (nodeOf(packed) == node && (packed & COUNT_MASK) != 0) {
+			if (m_packed.compare_exchange_weak(packed, packed - 1, std::memory_order_release,
+							   std::memory_order_relaxed)) {
+				return;
+			}
+		}
+		// 差し替え済み: 外側の分は内側へ移されている
+		if (node->inner.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+			delete node;
+		}
+	}
+
+	static void retire(uint64_t packed)
+	{
+		Node *node = nodeOf(packed);
+		if (!node) {
+			return;
+		}
+		const int64_t outer = static_cast<int64_t>(packed & COUNT_MASK);
+		if (node->inner.fetch_add(outer, std::memory_order_acq_rel) + outer == 0) {
+			delete node;
+		}
+	}
+
+	mutable std::atomic<uint64_t> m_packed{0};
+};
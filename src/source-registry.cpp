@@ -0,0 +1,206 @@
+/*
+Audoo-phase-meter for OBS
+Copyright (C) 2025 you214 https://github.com/you214
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along
+with this program. If not, see <https://www.gnu.org/licenses/>
+*/
+
+#include "source-registry.h"
+#include <algorithm>
+
+void AudioSource::push(const float *left, const float *right, size_t frames, uint64_t timestampNs)
+{
+	const float *planes[2] = {left, right};
+	pushPlanes(planes, 2, frames, timestampNs);
+}
+
+void AudioSource::pushPlanes(const float *const *planes, int count, size_t frames, uint64_t timestampNs)
+{
+	const uint64_t start = statNowNs();
+
+	matrix.process(planes, count, frames);
+
+	// 範囲外の組（チャンネル数が減った・2チャンネルの音声）はフロントL/Rに戻す
+	const uint32_t pair = scopePair.load(std::memory_order_relaxed);
+	int left = static_cast<int>(pair >> 16);
+	int right = static_cast<int>(pair & 0xFFFFu);
+	if (left >= count || right >= count) {
+		left = 0;
+		right = 1;
+	}
+
+	capture.write(planes[left], planes[right], frames, timestampNs);
+	alarm.process(planes[0], planes[1], frames);
+	if (recorder) {
+		recorder->recordAudio(slot, timestampNs, planes[left], planes[right], frames);
+	}
+	if (clock) {
+		clock->signal();
+	}
+
+	const uint64_t elapsed = statNowNs() - start;
+	statAdd(captureStats.blocks, 1);
+	statAdd(captureStats.frames, frames);
+	statAdd(captureStats.callbackNs, elapsed);
+	statMax(captureStats.callbackMaxNs, elapsed);
+}
+
+void AudioSource::appendWindow(const float *left, const float *right, size_t frames)
+{
+	const size_t window = leftChannel.size();
+	float *leftDst = leftChannel.data();
+	float *rightDst = rightChannel.data();
+
+	if (frames >= window) {
+		// ウィンドウより長い場合は末尾だけを使う
+		std::copy(left + frames - window, left + frames, leftDst);
+		std::copy(right + frames - window, right + frames, rightDst);
+	} else {
+		// 古いサンプルを前へ詰めて末尾に追加
+		std::copy(leftDst + frames, leftDst + window, leftDst);
+		std::copy(rightDst + frames, rightDst + window, rightDst);
+		std::copy(left, left + frames, leftDst + window - frames);
+		std::copy(right, right + frames, rightDst + window - frames);
+	}
+	validFrames = std::min(window, validFrames + frames);
+}
+
+void AudioSource::configure(const SourceConfig &config, const PhaseTap *tap)
+{
+	if (analysisVersion != config.analysisVersion) {
+		analysisVersion = config.analysisVersion;
+		sampleRate = config.sampleRate;
+		correlation.configure(config.sampleRate, config.integrationMs, config.integrationMode);
+		alarm.configure(config.sampleRate);
+		matrix.configure(channels, config.sampleRate, config.integrationMs);
+		correlationHistory.configure(config.sampleRate); // サンプルレートが同じなら履歴は残す
+		bands.configure(config.sampleRate, config.bandCount, config.integrationMs, config.integrationMode);
+		// スペクトルの時間平滑化は相関の積分時間に合わせる
+		spectrum.configure(config.sampleRate, config.fftSize, config.integrationMs);
+	}
+
+	if (scopeVersion != config.scopeVersion || scopeTap != tap) {
+		scopeVersion = config.scopeVersion;
+		scopeTap = tap;
+		// フィルターからは間引いた点が届くので、点の間隔に合わせて明るさと追従を揃える
+		const uint32_t pointRate = tap ? static_cast<uint32_t>(config.sampleRate / tap->decimation())
+					       : config.sampleRate;
+		raster.setPersistence(config.persistenceMs, pointRate);
+		raster.setProjection(config.scopeMode, config.scopeScale, config.autoGain);
+		scopePair.store(config.scopePair, std::memory_order_relaxed);
+	}
+}
+
+bool AudioSource::drain(PhaseTap *tap)
+{
+	if (tap) {
+		return drainTap(*tap);
+	}
+
+	const uint64_t firstFrame = capture.readPosition();
+
+	matrix.update();
+
+	size_t consumed = capture.consume([&](const float *left, const float *right, size_t frames) {
+		correlation.process(left, right, frames);
+		correlationHistory.process(left, right, frames);
+		raster.accumulate(left, right, frames);
+		bands.process(left, right, frames);
+		spectrum.process(left, right, frames);
+		history.push(left, right, frames);
+		appendWindow(left, right, frames);
+	});
+
+	// 取り出した最後のサンプルの次の時刻を履歴に記録する（ソース間で時刻を揃えるため）
+	uint64_t endNs = 0;
+	if (consumed > 0 && history.enabled() && capture.frameTime(firstFrame + consumed, sampleRate, endNs)) {
+		history.setEndTime(endNs);
+	}
+
+	if (consumed > 0) {
+		statAdd(consumeStats.drains, 1);
+		statAdd(consumeStats.frames, consumed);
+	}
+	return consumed > 0;
+}
+
+bool AudioSource::drainTap(PhaseTap &tap)
+{
+	// 相関と履歴は積和から、スコープは間引いた点から更新する
+	uint64_t frames = 0;
+	const CorrelationSums sums = tap.takeSums(frames);
+	if (frames > 0) {
+		correlation.processSums(sums, static_cast<size_t>(frames));
+		correlationHistory.processSums(sums, static_cast<size_t>(frames));
+	}
+
+	const size_t points = tap.points().consume([&](const float *left, const float *right, size_t count) {
+		raster.accumulate(left, right, count);
+		appendWindow(left, right, count);
+	});
+
+	if (frames > 0) {
+		statAdd(consumeStats.drains, 1);
+		statAdd(consumeStats.frames, frames);
+	}
+	return frames > 0 || points > 0;
+}
+
+const SourceEntry *SourceList::find(const QString &uuid) const
+{
+	auto it = m_index.constFind(uuid);
+	return it != m_index.constEnd() ? &m_slots[it.value()] : nullptr;
+}
+
+const SourceEntry *SourceList::at(int slot) const
+{
+	if (slot < 0 || slot >= static_cast<int>(m_slots.size()) || !m_slots[slot].source) {
+		return nullptr;
+	}
+	return &m_slots[slot];
+}
+
+AudioSource &SourceRegistry::insert(SourceList &next, const SourceInfo &info, size_t windowFrames)
+{
+	// 空きスロットを再利用して、スロット番号を密に保つ
+	int slot;
+	if (!next.m_freeSlots.empty()) {
+		slot = next.m_freeSlots.back();
+		next.m_freeSlots.pop_back();
+	} else {
+		slot = static_cast<int>(next.m_slots.size());
+		next.m_slots.emplace_back();
+	}
+
+	auto source = std::make_shared<AudioSource>(info.uuid, slot, windowFrames);
+	next.m_slots[slot] = SourceEntry{source, info.name, info.color, nullptr};
+	next.m_index.insert(info.uuid, slot);
+	return *source;
+}
+
+int SourceRegistry::remove(const QString &uuid)
+{
+	SourceList next = *snapshot();
+	auto it = next.m_index.find(uuid);
+	if (it == next.m_index.end()) {
+		return -1;
+	}
+
+	const int slot = it.value();
+	next.m_index.erase(it);
+	next.m_slots[slot] = SourceEntry();
+	next.m_freeSlots.push_back(slot);
+	m_list.publish(std::move(next));
+	return slot;
+}
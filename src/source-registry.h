@@ -0,0 +1,248 @@
+/*
+Audoo-phase-meter for OBS
+Copyright (C) 2025 you214 https://github.com/you214
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along
+with this program. If not, see <https://www.gnu.org/licenses/>
+*/
+
+#pragma once
+
+#include <QString>
+#include <QColor>
+#include <QHash>
+#include <vector>
+#include <memory>
+#include <atomic>
+
+#include "audio-ring-buffer.h"
+#include "pipeline-stats.h"
+#include "correlation-meter.h"
+#include "correlation-history.h"
+#include "band-correlation.h"
+#include "phase-spectrum.h"
+#include "delay-estimator.h"
+#include "scope-rasterizer.h"
+#include "capture-recorder.h"
+#include "frame-clock.h"
+#include "phase-alarm.h"
+#include "phase-tap.h"
+#include "channel-matrix.h"
+#include "snapshot-ptr.h"
+
+// 解析の設定（GUIが作って公開し、解析スレッドが各ソースへ反映する）
+// 版は変わった段だけを設定し直すために分ける（スコープの変更で相関の積分をやり直さない）
+struct SourceConfig {
+	uint64_t analysisVersion = 0;
+	uint32_t sampleRate = 48000;
+	double integrationMs = 300.0;
+	CorrelationMeter::Mode integrationMode = CorrelationMeter::Mode::Window;
+	int bandCount = 0;
+	size_t fftSize = 0; // 0ならスペクトルを計算しない
+
+	uint64_t scopeVersion = 0;
+	double persistenceMs = 150.0;
+	ScopeRasterizer::Mode scopeMode = ScopeRasterizer::Mode::Lissajous;
+	ScopeRasterizer::Scale scopeScale = ScopeRasterizer::Scale::Linear;
+	bool autoGain = false;
+	uint32_t scopePair = 1; // AudioSource::scopePairと同じ形式
+};
+
+class AudioSource {
+public:
+	QString uuid;                   // OBSソースのUUID（名前変更でも変わらない識別子）
+	int slot;                       // レジストリ内の固定スロット番号
+	uint32_t sampleRate;            // リング上の位置を時刻へ換算するのに使う
+	AudioRingBuffer capture;        // 音声スレッドから書き込まれる
+	std::vector<float> leftChannel; // 描画用の直近サンプル（解析スレッドのみが触る）
+	std::vector<float> rightChannel;
+	size_t validFrames;
+	bool enabled;
+	int channels;                   // 音声の平面数（OBSの出力のスピーカー配置）
+	ChannelMatrix matrix;           // 3チャンネル以上なら全ペアの相関（音声スレッドで積算する）
+	// 3チャンネル以上のとき、スコープ以降の2チャンネル解析に使う組（上位16bit: 左、下位16bit: 右）
+	std::atomic<uint32_t> scopePair{1};
+	CorrelationMeter correlation; // 取り出した全サンプルで更新する（解析スレッドのみ）
+	CorrelationHistory correlationHistory; // 相関・幅・レベルの長時間履歴（解析スレッドのみ）
+	ScopeRasterizer raster;       // 取り出した全サンプルを打点する（解析スレッドのみ）
+	BandCorrelationMeter bands;   // 帯域別の相関（帯域数0なら何もしない）
+	PhaseSpectrum spectrum;       // ビンごとの位相差とモノラル互換性（無効なら何もしない）
+	DelayHistory history;         // ソース間の遅延推定用（推定対象のときだけ有効）
+	CaptureRecorder *recorder;    // 受け取ったブロックをそのまま記録する（記録中でなければ何もしない）
+	FrameClock *clock;            // 書き込むたびに解析スレッドを起こす
+	PhaseAlarm alarm;             // 逆相の検出（音声スレッドで判定する。表示とは無関係に動く）
+	bool alarmReported;           // GUIスレッドが最後に通知した警告状態
+	std::atomic<bool> attached{false}; // OBSの音声監視コールバックを付けているか（付け外しを1回に限る）
+	CaptureStats captureStats;
+	ConsumeStats consumeStats;
+
+	// 反映済みの設定（解析スレッドのみ。公開前の初期設定だけは追加した側が行う）
+	uint64_t analysisVersion;
+	uint64_t scopeVersion;
+	const PhaseTap *scopeTap; // スコープを合わせたフィルター（点の間隔が違う）
+
+	AudioSource(const QString &id, int s, size_t windowFrames)
+		: uuid(id),
+		  slot(s),
+		  sampleRate(48000),
+		  leftChannel(windowFrames, 0.0f),
+		  rightChannel(windowFrames, 0.0f),
+		  validFrames(0),
+		  enabled(true),
+		  channels(2),
+		  recorder(nullptr),
+		  clock(nullptr),
+		  alarmReported(false),
+		  analysisVersion(0),
+		  scopeVersion(0),
+		  scopeTap(nullptr)
+	{
+	}
+
+	// 生産者側: リングへ書き込み、キャプチャ段のカウンタを更新する
+	// timestampNsはブロック先頭の時刻（audio_data->timestamp）。0なら記録しない
+	void push(const float *left, const float *right, size_t frames, uint64_t timestampNs = 0);
+	// 生産者側: 多チャンネルのブロック。相関行列を積算し、scopePairの組をリングへ書く
+	// 逆相警告は選んだ組によらずplanes[0]とplanes[1]（フロントL/R）で判定する
+	void pushPlanes(const float *const *planes, int count, size_t frames, uint64_t timestampNs = 0);
+
+	// 版が変わった段だけ設定し直す。tapはスコープの点の間隔を決める（付いていなければnullptr）
+	void configure(const SourceConfig &config, const PhaseTap *tap);
+
+	// リングに溜まったサンプルをすべて取り出し、相関メーター・スコープ・直近ウィンドウへ反映する
+	// フィルターが付いていれば、その積和と間引いた点を反映する（帯域別相関・スペクトル・遅延推定は行わない）
+	bool drain(PhaseTap *tap);
+
+private:
+	bool drainTap(PhaseTap &tap);
+	void appendWindow(const float *left, const float *right, size_t frames);
+};
+
+// 一覧の1項目。名前・色・フィルターは書き換えずに、項目ごと差し替える
+struct SourceEntry {
+	std::shared_ptr<AudioSource> source;
+	QString name; // 表示名のみ。識別には使わない
+	QColor color;
+	std::shared_ptr<PhaseTap> tap; // フィルター"Phase Meter Tap"の要約。あればcaptureの代わりに使う
+
+	// 逆相の判定を実際に行っているもの（フィルターが付いていればフィルター側）
+	PhaseAlarm &activeAlarm() const { return tap ? tap->alarm : source->alarm; }
+};
+
+// 登録済みソースの一覧の1版。公開した後は変更しない
+class SourceList {
+public:
+	const SourceEntry *find(const QString &uuid) const;
+	const SourceEntry *at(int slot) const;
+	size_t size() const { return static_cast<size_t>(m_index.size()); }
+
+	// スロット順に登録済みソースを列挙する
+	template<typename Fn> void forEach(Fn &&fn) const
+	{
+		for (const SourceEntry &entry : m_slots) {
+			if (entry.source) {
+				fn(entry);
+			}
+		}
+	}
+
+private:
+	friend class SourceRegistry;
+	std::vector<SourceEntry> m_slots;
+	std::vector<int> m_freeSlots;
+	QHash<QString, int> m_index;
+};
+
+using SourceSnapshot = SnapshotPtr<SourceList>::Snapshot;
+
+// まとめて登録するときの1件
+struct SourceInfo {
+	QString uuid;
+	QString name;
+	QColor color;
+};
+
+// UUIDをキーに、密な整数スロットでAudioSourceを管理する
+// 文字列のハッシュは追加・削除・名前変更時にしか使わず、音声経路はスロット（ポインタ）だけを使う
+// 読み手（解析スレッド・GUI）はロックを取らずに一覧の版を受け取る。書き手は一覧を複製して変更し、差し替える
+// 削除したソースは、その版を持っている読み手がいなくなったときに解放される
+class SourceRegistry {
+public:
+	// 読み手: 現在の一覧（持っている間は一覧もソースも解放されない）
+	SourceSnapshot snapshot() const { return m_list.acquire(); }
+
+	// 以下は書き手。書き手同士は呼び出し側でロックすること
+	// 既に登録済みならそのソースを返す。setupは公開する前（まだ誰も読んでいないとき）に呼ぶ
+	template<typename Fn>
+	AudioSource *add(const QString &uuid, const QString &name, const QColor &color, size_t windowFrames,
+			 Fn &&setup)
+	{
+		const SourceSnapshot current = snapshot();
+		if (const SourceEntry *existing = current->find(uuid)) {
+			return existing->source.get();
+		}
+
+		SourceList next = *current;
+		AudioSource &source = insert(next, SourceInfo{uuid, name, color}, windowFrames);
+		setup(source);
+		m_list.publish(std::move(next));
+		return &source;
+	}
+	AudioSource *add(const QString &uuid, const QString &name, const QColor &color, size_t windowFrames)
+	{
+		return add(uuid, name, color, windowFrames, [](AudioSource &) {});
+	}
+
+	// まとめて登録し、一覧は1回だけ差し替える（起動時・シーンコレクションの読み込み後）
+	// 登録済みのものは飛ばす。setup(AudioSource&, const SourceInfo&)は新しく追加した分だけ公開前に呼ぶ
+	// 追加した数を返す
+	template<typename Fn> size_t addAll(const std::vector<SourceInfo> &infos, size_t windowFrames, Fn &&setup)
+	{
+		SourceList next = *snapshot();
+		size_t added = 0;
+		for (const SourceInfo &info : infos) {
+			if (info.uuid.isEmpty() || next.m_index.contains(info.uuid)) {
+				continue;
+			}
+			setup(insert(next, info, windowFrames), info);
+			added++;
+		}
+		if (added > 0) {
+			m_list.publish(std::move(next));
+		}
+		return added;
+	}
+
+	// 項目を複製してfnで書き換え、差し替える（名前・色・フィルターの変更）。未登録ならfalse
+	template<typename Fn> bool modify(const QString &uuid, Fn &&fn)
+	{
+		SourceList next = *snapshot();
+		auto it = next.m_index.constFind(uuid);
+		if (it == next.m_index.constEnd()) {
+			return false;
+		}
+		fn(next.m_slots[it.value()]);
+		m_list.publish(std::move(next));
+		return true;
+	}
+
+	// 削除したソースのスロット番号を返す（未登録なら-1）
+	int remove(const QString &uuid);
+	void clear() { m_list.publish(SourceList()); }
+
+private:
+	// nextへ新しいソースを入れる（空きスロットがあれば再利用する）
+	static AudioSource &insert(SourceList &next, const SourceInfo &info, size_t windowFrames);
+
+	SnapshotPtr<SourceList> m_list;
+};
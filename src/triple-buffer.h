@@ -0,0 +1,64 @@
+/*
+Audoo-phase-meter for OBS
+Copyright (C) 2025 you214 https://github.com/you214
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along
+with this program. If not, see <https://www.gnu.org/licenses/>
+*/
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+
+// 単一の書き手から単一の読み手へ最新の値を受け渡すトリプルバッファ
+// 書き手・読み手はそれぞれ専有のバッファを持ち、中間バッファとの交換は1回のatomic exchangeで行う
+// どちらも相手を待つことはなく、バッファは使い回すので受け渡しごとのメモリ確保もない
+template<typename T> class TripleBuffer {
+public:
+	// 書き手側: 次に公開する値を書き込むバッファ（前々回の内容が残っている）
+	T &writeBuffer() { return m_buffers[m_back]; }
+
+	// 書き手側: 書き込んだバッファを公開する。読まれる前に上書きされた値があればtrue
+	bool publish()
+	{
+		const uint8_t previous = m_middle.exchange(static_cast<uint8_t>(m_back | DIRTY), std::memory_order_acq_rel);
+		m_back = previous & INDEX_MASK;
+		return (previous & DIRTY) != 0;
+	}
+
+	// 読み手側: 新しい値が公開されていれば受け取る。受け取った場合はtrue
+	bool update()
+	{
+		if (!(m_middle.load(std::memory_order_relaxed) & DIRTY)) {
+			return false;
+		}
+		m_front = m_middle.exchange(m_front, std::memory_order_acq_rel) & INDEX_MASK;
+		return true;
+	}
+
+	// 読み手側: 新しい値が公開されているか
+	bool hasUpdate() const { return (m_middle.load(std::memory_order_relaxed) & DIRTY) != 0; }
+
+	// 読み手側: 最後に受け取った値（次のupdate()まで書き手は触らない）
+	const T &readBuffer() const { return m_buffers[m_front]; }
+
+private:
+	static constexpr uint8_t INDEX_MASK = 0x3;
+	static constexpr uint8_t DIRTY = 0x4;
+
+	T m_buffers[3];
+	uint8_t m_back = 0;
+	alignas(64) std::atomic<uint8_t> m_middle{1};
+	alignas(64) uint8_t m_front = 2;
+};
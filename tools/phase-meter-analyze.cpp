@@ -0,0 +1,506 @@
+/*
+Audoo-phase-meter for OBS
+Copyright (C) 2025 you214 https://github.com/you214
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along
+with this program. If not, see <https://www.gnu.org/licenses/>
+*/
+
+
+// WAV録音をドックと同じ解析（相関・帯域別相関・位相スペクトル）にかけ、
+// ファイルごとの時系列（CSV/JSON）と要約統計（JSON、標準出力）を出す。OBSも表示も不要
+//
+//   phase-meter-analyze [options] <file.wav | directory>...
+//
+// ファイルはメモリマップして先頭から順に読むので、長時間の録音でも全体をメモリに載せない
+// 複数ファイルは全コアで並列に処理する（1ファイルは1スレッド）
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "band-correlation.h"
+#include "correlation-kernels.h"
+#include "correlation-meter.h"
+#include "phase-spectrum.h"
+#include "wav-reader.h"
+
+namespace fs = std::filesystem;
+
+namespace {
+
+enum class Format { Csv, Json };
+
+struct Options {
+	Format format = Format::Csv;
+	fs::path outDir;        // 空なら入力ファイルと同じ場所
+	bool timeline = true;
+	double intervalMs = 100.0;
+	double integrationMs = 300.0;
+	CorrelationMeter::Mode mode = CorrelationMeter::Mode::Window;
+	int bands = 0;
+	size_t fftSize = 4096;
+	double gateDb = -60.0; // これ未満のレベルの区間は統計から除く
+	unsigned jobs = 0;
+};
+
+struct FileSummary {
+	fs::path path;
+	std::string error;
+	double durationSec = 0.0;
+	double elapsedSec = 0.0;
+	uint32_t sampleRate = 0;
+	uint64_t points = 0;
+	uint64_t activePoints = 0; // ゲートを超えた区間の数
+	double meanCorrelation = 0.0;
+	double minCorrelation = 1.0;
+	double belowZeroPercent = 0.0;
+	double belowHalfPercent = 0.0; // -0.5未満
+	double meanWidthDb = 0.0;
+	int bandCount = 0;
+	std::array<double, BandCorrelationMeter::MAX_BANDS> bandBelowZeroPercent{};
+	bool hasSpectrum = false;
+	double worstMonoLossDb = 0.0;
+	double worstMonoLossHz = 0.0;
+};
+
+constexpr size_t READ_FRAMES = 8192;
+constexpr float SPECTRUM_GATE_DB = -70.0f;
+
+std::string utf8Path(const fs::path &path)
+{
+	const std::u8string text = path.u8string();
+	return std::string(text.begin(), text.end());
+}
+
+std::string jsonEscape(const std::string &text)
+{
+	std::string escaped;
+	escaped.reserve(text.size());
+	for (char c : text) {
+		switch (c) {
+		case '"':
+			escaped += "\\\"";
+			break;
+		case '\\':
+			escaped += "\\\\";
+			break;
+		case '\n':
+			escaped += "\\n";
+			break;
+		default:
+			if (static_cast<unsigned char>(c) < 0x20) {
+				char code[8];
+				std::snprintf(code, sizeof(code), "\\u%04x", c);
+				escaped += code;
+			} else {
+				escaped += c;
+			}
+		}
+	}
+	return escaped;
+}
+
+double toDb(double power)
+{
+	return power > 1e-20 ? 10.0 * std::log10(power) : -200.0;
+}
+
+class TimelineWriter {
+public:
+	TimelineWriter(const Options &options, int bandCount) : m_format(options.format), m_bandCount(bandCount) {}
+
+	bool open(const fs::path &path, const std::string &source, uint32_t sampleRate, double intervalMs)
+	{
+		m_out.open(path, std::ios::binary | std::ios::trunc);
+		if (!m_out) {
+			return false;
+		}
+
+		if (m_format == Format::Csv) {
+			m_out << "time_s,correlation,width_db,level_l_db,level_r_db";
+			for (int band = 0; band < m_bandCount; ++band) {
+				m_out << ",band" << band + 1;
+			}
+			m_out << '\n';
+		} else {
+			m_out << "{\"file\": \"" << jsonEscape(source) << "\", \"sample_rate\": " << sampleRate
+			      << ", \"interval_ms\": " << intervalMs << ",\n \"columns\": [\"time_s\", "
+			      << "\"correlation\", \"width_db\", \"level_l_db\", \"level_r_db\"";
+			for (int band = 0; band < m_bandCount; ++band) {
+				m_out << ", \"band" << band + 1 << "\"";
+			}
+			m_out << "],\n \"rows\": [";
+		}
+		return true;
+	}
+
+	void write(double timeSec, double correlation, double width, double levelLeft, double levelRight,
+		   const double *bands)
+	{
+		char line[512];
+		int length;
+		if (m_format == Format::Csv) {
+			length = std::snprintf(line, sizeof(line), "%.3f,%.4f,%.2f,%.2f,%.2f", timeSec, correlation,
+					       width, levelLeft, levelRight);
+		} else {
+			length = std::snprintf(line, sizeof(line), "%s\n  [%.3f, %.4f, %.2f, %.2f, %.2f",
+					       m_rows ? "," : "", timeSec, correlation, width, levelLeft, levelRight);
+		}
+		m_out.write(line, length);
+		for (int band = 0; band < m_bandCount; ++band) {
+			const char *format = m_format == Format::Csv ? ",%.4f" : ", %.4f";
+			length = std::snprintf(line, sizeof(line), format, bands[band]);
+			m_out.write(line, length);
+		}
+		m_out << (m_format == Format::Csv ? "\n" : "]");
+		m_rows++;
+	}
+
+	bool close()
+	{
+		if (m_format == Format::Json) {
+			m_out << "\n ]}\n";
+		}
+		m_out.close();
+		return !m_out.fail();
+	}
+
+private:
+	Format m_format;
+	int m_bandCount;
+	std::ofstream m_out;
+	uint64_t m_rows = 0;
+};
+
+FileSummary analyzeFile(const fs::path &path, const Options &options)
+{
+	FileSummary summary;
+	summary.path = path;
+	const auto started = std::chrono::steady_clock::now();
+
+	WavReader wav;
+	if (!wav.open(utf8Path(path), summary.error)) {
+		return summary;
+	}
+	const uint32_t sampleRate = wav.sampleRate();
+	summary.sampleRate = sampleRate;
+	summary.durationSec = static_cast<double>(wav.frames()) / sampleRate;
+
+	CorrelationMeter meter;
+	meter.configure(sampleRate, options.integrationMs, options.mode);
+	BandCorrelationMeter bands;
+	bands.configure(sampleRate, options.bands, options.integrationMs, options.mode);
+	PhaseSpectrum spectrum;
+	spectrum.configure(sampleRate, options.fftSize, options.integrationMs);
+	summary.bandCount = bands.bandCount();
+	summary.hasSpectrum = spectrum.enabled();
+
+	TimelineWriter timeline(options, summary.bandCount);
+	if (options.timeline) {
+		const fs::path directory = options.outDir.empty() ? path.parent_path() : options.outDir;
+		fs::path output = directory / path.stem();
+		output += options.format == Format::Csv ? ".phase.csv" : ".phase.json";
+		if (!timeline.open(output, utf8Path(path), sampleRate, options.intervalMs)) {
+			summary.error = "cannot write " + utf8Path(output);
+			return summary;
+		}
+	}
+
+	const size_t intervalFrames =
+		std::max<size_t>(1, static_cast<size_t>(sampleRate * options.intervalMs / 1000.0));
+	std::vector<float> left(READ_FRAMES);
+	std::vector<float> right(READ_FRAMES);
+	std::array<double, BandCorrelationMeter::MAX_BANDS> bandValues{};
+	std::array<uint64_t, BandCorrelationMeter::MAX_BANDS> bandBelowZero{};
+	std::array<float, PhaseSpectrum::COLUMNS> phase{}, mono{}, level{};
+	std::array<double, PhaseSpectrum::COLUMNS> monoSum{};
+	std::array<uint64_t, PhaseSpectrum::COLUMNS> monoCount{};
+	uint64_t spectrumVersion = 0;
+
+	double correlationSum = 0.0;
+	double widthSum = 0.0;
+	uint64_t belowZero = 0;
+	uint64_t belowHalf = 0;
+	uint64_t intervalIndex = 0;
+
+	for (;;) {
+		// 1区間分を読みながら解析し、区間自体の積和からレベルと広がりを求める
+		CorrelationSums intervalSums;
+		size_t intervalRead = 0;
+		while (intervalRead < intervalFrames) {
+			const size_t count = wav.read(left.data(), right.data(),
+						      std::min(READ_FRAMES, intervalFrames - intervalRead));
+			if (count == 0) {
+				break;
+			}
+			intervalSums += correlationSums(left.data(), right.data(), count);
+			meter.process(left.data(), right.data(), count);
+			bands.process(left.data(), right.data(), count);
+			spectrum.process(left.data(), right.data(), count);
+			intervalRead += count;
+		}
+		if (intervalRead == 0) {
+			break;
+		}
+
+		const double levelLeft = toDb(intervalSums.ll / intervalRead);
+		const double levelRight = toDb(intervalSums.rr / intervalRead);
+		const double correlation = meter.correlation();
+		const double width = intervalSums.widthDb();
+		for (int band = 0; band < summary.bandCount; ++band) {
+			bandValues[band] = bands.correlation(band);
+		}
+
+		const double timeSec = static_cast<double>(intervalIndex * intervalFrames + intervalRead) / sampleRate;
+		if (options.timeline) {
+			timeline.write(timeSec, correlation, width, std::max(levelLeft, -120.0),
+				       std::max(levelRight, -120.0), bandValues.data());
+		}
+		summary.points++;
+		intervalIndex++;
+
+		if (std::max(levelLeft, levelRight) < options.gateDb) {
+			continue;
+		}
+		summary.activePoints++;
+		correlationSum += correlation;
+		widthSum += width;
+		summary.minCorrelation = std::min(summary.minCorrelation, correlation);
+		belowZero += correlation < 0.0;
+		belowHalf += correlation < -0.5;
+		for (int band = 0; band < summary.bandCount; ++band) {
+			bandBelowZero[band] += bandValues[band] < 0.0;
+		}
+
+		// モノラル化での損失は、音のある列だけを区間ごとに平均する
+		if (summary.hasSpectrum && spectrum.version() != spectrumVersion) {
+			spectrumVersion = spectrum.version();
+			spectrum.columns(phase.data(), mono.data(), level.data());
+			for (int column = 0; column < PhaseSpectrum::COLUMNS; ++column) {
+				if (level[column] >= SPECTRUM_GATE_DB) {
+					monoSum[column] += mono[column];
+					monoCount[column]++;
+				}
+			}
+		}
+	}
+
+	if (options.timeline && !timeline.close()) {
+		summary.error = "write failed";
+	}
+
+	if (summary.activePoints > 0) {
+		const double active = static_cast<double>(summary.activePoints);
+		summary.meanCorrelation = correlationSum / active;
+		summary.meanWidthDb = widthSum / active;
+		summary.belowZeroPercent = 100.0 * belowZero / active;
+		summary.belowHalfPercent = 100.0 * belowHalf / active;
+		for (int band = 0; band < summary.bandCount; ++band) {
+			summary.bandBelowZeroPercent[band] = 100.0 * bandBelowZero[band] / active;
+		}
+	} else {
+		summary.minCorrelation = 0.0;
+	}
+	for (int column = 0; column < PhaseSpectrum::COLUMNS; ++column) {
+		if (monoCount[column] > 0) {
+			const double loss = monoSum[column] / monoCount[column];
+			if (loss < summary.worstMonoLossDb) {
+				// 列の中心（対数軸）
+				const double low = PhaseSpectrum::columnEdge(column);
+				const double high = PhaseSpectrum::columnEdge(column + 1);
+				summary.worstMonoLossDb = loss;
+				summary.worstMonoLossHz = std::sqrt(low * high);
+			}
+		}
+	}
+
+	summary.elapsedSec = std::chrono::duration<double>(std::chrono::steady_clock::now() - started).count();
+	return summary;
+}
+
+void printSummary(const FileSummary &s, bool last)
+{
+	std::printf("    {\"file\": \"%s\"", jsonEscape(utf8Path(s.path)).c_str());
+	if (!s.error.empty()) {
+		std::printf(", \"error\": \"%s\"}%s\n", jsonEscape(s.error).c_str(), last ? "" : ",");
+		return;
+	}
+	std::printf(", \"sample_rate\": %u, \"duration_s\": %.3f, \"speed\": %.1f,\n", s.sampleRate, s.durationSec,
+		    s.elapsedSec > 0.0 ? s.durationSec / s.elapsedSec : 0.0);
+	std::printf("     \"active_percent\": %.2f, \"mean_correlation\": %.4f, \"min_correlation\": %.4f,\n",
+		    s.points ? 100.0 * s.activePoints / s.points : 0.0, s.meanCorrelation, s.minCorrelation);
+	std::printf("     \"below_zero_percent\": %.2f, \"below_minus_half_percent\": %.2f, \"mean_width_db\": %.2f",
+		    s.belowZeroPercent, s.belowHalfPercent, s.meanWidthDb);
+	if (s.bandCount > 0) {
+		std::printf(",\n     \"bands\": [");
+		for (int band = 0; band < s.bandCount; ++band) {
+			std::printf("%s{\"low_hz\": %.0f, \"high_hz\": %.0f, \"below_zero_percent\": %.2f}",
+				    band ? ", " : "", BandCorrelationMeter::edgeFrequency(band, s.bandCount),
+				    BandCorrelationMeter::edgeFrequency(band + 1, s.bandCount),
+				    s.bandBelowZeroPercent[band]);
+		}
+		std::printf("]");
+	}
+	if (s.hasSpectrum) {
+		std::printf(",\n     \"worst_mono_loss_db\": %.2f, \"worst_mono_loss_hz\": %.0f", s.worstMonoLossDb,
+			    s.worstMonoLossHz);
+	}
+	std::printf("}%s\n", last ? "" : ",");
+}
+
+void usage(const char *program)
+{
+	std::fprintf(stderr,
+		     "usage: %s [options] <file.wav | directory>...\n"
+		     "  --format csv|json   timeline format (default csv)\n"
+		     "  --out DIR           timeline directory (default: next to each input)\n"
+		     "  --no-timeline       write the summary only\n"
+		     "  --interval MS       timeline resolution (default 100)\n"
+		     "  --integration MS    correlation integration time (default 300)\n"
+		     "  --exponential       exponential integration instead of a rectangular window\n"
+		     "  --bands N           per-band correlation, 0 or %d..%d (default 0)\n"
+		     "  --fft N             phase spectrum FFT size, 0 to disable (default 4096)\n"
+		     "  --gate DB           ignore intervals quieter than this in the summary (default -60)\n"
+		     "  --jobs N            files analysed in parallel (default: all cores)\n",
+		     program, BandCorrelationMeter::MIN_BANDS, BandCorrelationMeter::MAX_BANDS);
+}
+
+bool isWav(const fs::path &path)
+{
+	std::string extension = path.extension().string();
+	std::transform(extension.begin(), extension.end(), extension.begin(),
+		       [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+	return extension == ".wav";
+}
+
+} // namespace
+
+int main(int argc, char **argv)
+{
+	Options options;
+	std::vector<fs::path> inputs;
+
+	for (int i = 1; i < argc; ++i) {
+		const std::string arg = argv[i];
+		const bool hasValue = i + 1 < argc;
+		if (arg == "--format" && hasValue) {
+			const std::string value = argv[++i];
+			if (value != "csv" && value != "json") {
+				usage(argv[0]);
+				return 2;
+			}
+			options.format = value == "csv" ? Format::Csv : Format::Json;
+		} else if (arg == "--out" && hasValue) {
+			options.outDir = argv[++i];
+		} else if (arg == "--no-timeline") {
+			options.timeline = false;
+		} else if (arg == "--interval" && hasValue) {
+			options.intervalMs = std::max(1.0, std::atof(argv[++i]));
+		} else if (arg == "--integration" && hasValue) {
+			options.integrationMs = std::max(1.0, std::atof(argv[++i]));
+		} else if (arg == "--exponential") {
+			options.mode = CorrelationMeter::Mode::Exponential;
+		} else if (arg == "--bands" && hasValue) {
+			options.bands = std::atoi(argv[++i]);
+		} else if (arg == "--fft" && hasValue) {
+			options.fftSize = static_cast<size_t>(std::max(0, std::atoi(argv[++i])));
+		} else if (arg == "--gate" && hasValue) {
+			options.gateDb = std::atof(argv[++i]);
+		} else if (arg == "--jobs" && hasValue) {
+			options.jobs = static_cast<unsigned>(std::max(1, std::atoi(argv[++i])));
+		} else if (!arg.empty() && arg[0] != '-') {
+			inputs.emplace_back(arg);
+		} else {
+			usage(argv[0]);
+			return 2;
+		}
+	}
+
+	// ディレクトリは直下の.wavを名前順に並べる（出力の順序を実行ごとに変えない）
+	std::vector<fs::path> files;
+	for (const fs::path &input : inputs) {
+		std::error_code error;
+		if (fs::is_directory(input, error)) {
+			std::vector<fs::path> found;
+			for (const fs::directory_entry &entry : fs::directory_iterator(input, error)) {
+				if (entry.is_regular_file(error) && isWav(entry.path())) {
+					found.push_back(entry.path());
+				}
+			}
+			std::sort(found.begin(), found.end());
+			files.insert(files.end(), found.begin(), found.end());
+		} else {
+			files.push_back(input);
+		}
+	}
+	if (files.empty()) {
+		usage(argv[0]);
+		return 2;
+	}
+	if (options.timeline && !options.outDir.empty()) {
+		std::error_code error;
+		fs::create_directories(options.outDir, error);
+	}
+
+	const unsigned cores = std::max(1u, std::thread::hardware_concurrency());
+	const unsigned requested = options.jobs ? options.jobs : cores;
+	const unsigned jobs = std::min<unsigned>(requested, static_cast<unsigned>(files.size()));
+	std::vector<FileSummary> summaries(files.size());
+	std::atomic<size_t> next{0};
+	const auto started = std::chrono::steady_clock::now();
+
+	std::vector<std::thread> workers;
+	for (unsigned job = 0; job < jobs; ++job) {
+		workers.emplace_back([&]() {
+			for (size_t index = next.fetch_add(1); index < files.size(); index = next.fetch_add(1)) {
+				summaries[index] = analyzeFile(files[index], options);
+			}
+		});
+	}
+	for (std::thread &worker : workers) {
+		worker.join();
+	}
+
+	const double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - started).count();
+	double totalDuration = 0.0;
+	int failures = 0;
+	for (const FileSummary &summary : summaries) {
+		totalDuration += summary.durationSec;
+		failures += !summary.error.empty();
+	}
+
+	std::printf("{\n");
+	std::printf("  \"kernel\": \"%s\",\n", kernelIsaName(activeKernelIsa()));
+	std::printf("  \"jobs\": %u,\n", jobs);
+	std::printf("  \"audio_s\": %.3f,\n", totalDuration);
+	std::printf("  \"elapsed_s\": %.3f,\n", elapsed);
+	std::printf("  \"speed\": %.1f,\n", elapsed > 0.0 ? totalDuration / elapsed : 0.0);
+	std::printf("  \"files\": [\n");
+	for (size_t i = 0; i < summaries.size(); ++i) {
+		printSummary(summaries[i], i + 1 == summaries.size());
+	}
+	std::printf("  ]\n");
+	std::printf("}\n");
+	return failures ? 1 : 0;
+}
@@ -0,0 +1,170 @@
+/*
+Audoo-phase-meter for OBS
+Copyright (C) 2025 you214 https://github.com/you214
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along
+with this program. If not, see <https://www.gnu.org/licenses/>
+*/
+
+
+#include "wav-reader.h"
+#include <algorithm>
+#include <cstring>
+
+static uint16_t readU16(const uint8_t *p)
+{
+	return static_cast<uint16_t>(p[0] | (p[1] << 8));
+}
+
+static uint32_t readU32(const uint8_t *p)
+{
+	return static_cast<uint32_t>(p[0]) | (static_cast<uint32_t>(p[1]) << 8) |
+	       (static_cast<uint32_t>(p[2]) << 16) | (static_cast<uint32_t>(p[3]) << 24);
+}
+
+bool WavReader::open(const std::string &path, std::string &error)
+{
+	if (!m_file.openRead(path)) {
+		error = "cannot open";
+		return false;
+	}
+
+	const uint8_t *data = m_file.data();
+	const size_t size = m_file.size();
+	if (size < 12 || std::memcmp(data, "RIFF", 4) != 0 || std::memcmp(data + 8, "WAVE", 4) != 0) {
+		error = "not a RIFF/WAVE file";
+		return false;
+	}
+
+	uint16_t format = 0;
+	uint16_t bits = 0;
+	bool haveFormat = false;
+	size_t offset = 12;
+	while (offset + 8 <= size) {
+		const uint8_t *chunk = data + offset;
+		const size_t chunkSize = readU32(chunk + 4);
+		const uint8_t *body = chunk + 8;
+		const size_t available = size - offset - 8;
+
+		if (std::memcmp(chunk, "fmt ", 4) == 0 && chunkSize >= 16 && available >= 16) {
+			format = readU16(body);
+			m_channels = readU16(body + 2);
+			m_sampleRate = readU32(body + 4);
+			bits = readU16(body + 14);
+			// WAVE_FORMAT_EXTENSIBLE はサブフォーマットGUIDの先頭2バイトが実際の形式
+			if (format == 0xFFFE && chunkSize >= 40 && available >= 40) {
+				format = readU16(body + 24);
+			}
+			haveFormat = true;
+		} else if (std::memcmp(chunk, "data", 4) == 0) {
+			if (!haveFormat) {
+				error = "data chunk before fmt chunk";
+				return false;
+			}
+			// 書き込み途中のファイルは長さが0や不正な値のことがあるので、ファイル末尾までに収める
+			const size_t dataSize = chunkSize == 0 || chunkSize > available ? available : chunkSize;
+			m_data = body;
+
+			if (format == 1 && bits == 16) {
+				m_encoding = Encoding::Int16;
+			} else if (format == 1 && bits == 24) {
+				m_encoding = Encoding::Int24;
+			} else if (format == 1 && bits == 32) {
+				m_encoding = Encoding::Int32;
+			} else if (format == 3 && bits == 32) {
+				m_encoding = Encoding::Float32;
+			} else {
+				error = "unsupported sample format " + std::to_string(format) + "/" +
+					std::to_string(bits);
+				return false;
+			}
+			if (m_channels == 0 || m_sampleRate == 0) {
+				error = "invalid fmt chunk";
+				return false;
+			}
+
+			m_frameBytes = static_cast<size_t>(m_channels) * (bits / 8);
+			m_frames = dataSize / m_frameBytes;
+			m_position = 0;
+			return true;
+		}
+
+		// チャンクは偶数バイト境界に揃う
+		offset += 8 + chunkSize + (chunkSize & 1);
+	}
+
+	error = "no data chunk";
+	return false;
+}
+
+// 1サンプルをfloatへ変換する（形式ごとにループを分けて、サンプルごとの分岐を避ける）
+static float decodeInt16(const uint8_t *p)
+{
+	return static_cast<int16_t>(readU16(p)) * (1.0f / 32768.0f);
+}
+
+static float decodeInt24(const uint8_t *p)
+{
+	// 上位24bitへ詰めて符号拡張する
+	const uint32_t value = (static_cast<uint32_t>(p[0]) << 8) | (static_cast<uint32_t>(p[1]) << 16) |
+			       (static_cast<uint32_t>(p[2]) << 24);
+	return static_cast<int32_t>(value) * (1.0f / 2147483648.0f);
+}
+
+static float decodeInt32(const uint8_t *p)
+{
+	return static_cast<int32_t>(readU32(p)) * (1.0f / 2147483648.0f);
+}
+
+static float decodeFloat32(const uint8_t *p)
+{
+	const uint32_t bits = readU32(p);
+	float value;
+	std::memcpy(&value, &bits, sizeof(value));
+	return value;
+}
+
+template<float (*Decode)(const uint8_t *)>
+static void decodeFrames(const uint8_t *frame, size_t frameBytes, size_t rightOffset, float *left, float *right,
+			 size_t count)
+{
+	for (size_t i = 0; i < count; ++i, frame += frameBytes) {
+		left[i] = Decode(frame);
+		right[i] = Decode(frame + rightOffset);
+	}
+}
+
+size_t WavReader::read(float *left, float *right, size_t maxFrames)
+{
+	const size_t count = static_cast<size_t>(std::min<uint64_t>(maxFrames, m_frames - m_position));
+	const uint8_t *frame = m_data + m_position * m_frameBytes;
+	const size_t rightOffset = m_channels > 1 ? m_frameBytes / m_channels : 0;
+
+	switch (m_encoding) {
+	case Encoding::Int16:
+		decodeFrames<decodeInt16>(frame, m_frameBytes, rightOffset, left, right, count);
+		break;
+	case Encoding::Int24:
+		decodeFrames<decodeInt24>(frame, m_frameBytes, rightOffset, left, right, count);
+		break;
+	case Encoding::Int32:
+		decodeFrames<decodeInt32>(frame, m_frameBytes, rightOffset, left, right, count);
+		break;
+	case Encoding::Float32:
+		decodeFrames<decodeFloat32>(frame, m_frameBytes, rightOffset, left, right, count);
+		break;
+	}
+
+	m_position += count;
+	return count;
+}
@@ -0,0 +1,55 @@
+/*
+Audoo-phase-meter for OBS
+Copyright (C) 2025 you214 https://github.com/you214
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along
+with this program. If not, see <https://www.gnu.org/licenses/>
+*/
+
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+#include "mapped-file.h"
+
+// メモリマップしたWAVファイルから、ステレオのプレーナfloatを先頭から順に取り出す
+// 対応形式: PCM 16/24/32bit、IEEE float 32bit（WAVE_FORMAT_EXTENSIBLEを含む）
+// モノラルはL=R、3ch以上は先頭2chを使う
+class WavReader {
+public:
+	// ファイルを開いてヘッダを読む（失敗時はerrorに理由を入れてfalse）。パスはUTF-8
+	bool open(const std::string &path, std::string &error);
+
+	uint32_t sampleRate() const { return m_sampleRate; }
+	uint16_t channels() const { return m_channels; }
+	uint64_t frames() const { return m_frames; }
+	uint64_t position() const { return m_position; }
+
+	// 最大maxFramesフレームを変換して返す（0なら終端）
+	size_t read(float *left, float *right, size_t maxFrames);
+
+private:
+	enum class Encoding { Int16, Int24, Int32, Float32 };
+
+	MappedFile m_file;
+	const uint8_t *m_data = nullptr; // dataチャンクの先頭
+	Encoding m_encoding = Encoding::Int16;
+	uint32_t m_sampleRate = 0;
+	uint16_t m_channels = 0;
+	size_t m_frameBytes = 0;
+	uint64_t m_frames = 0;
+	uint64_t m_position = 0;
+};